@@ -1,15 +1,15 @@
 #include "avr_specific.h"
 #include "rings.h"
 #include "leds.h"
+#include "scrambles.h"
 #include "../Cube/rand8.h"
 #include "../Cube/cube.h"
 #include "../Cube/controls.h"
+#include "../Cube/hint.h"
 
 #define RESET_DELAY_MS		100
 #define ERROR_DELAY_MS		100
 
-const uint8_t NumScrambleRotations = 15;
-
 void Init()
 {
 	// Remove the clk /8 prescaler.
@@ -44,12 +44,23 @@ void Init()
 	Rand8::Seed(Seed);
 }
 
-// This function is necessary to be able to sleep using a delay that isn't
-// known at compile-time.
-void Sleep(uint16_t DelayMs)
+// Sleep for a delay that isn't known at compile-time, reading the rings
+// meanwhile (one ring per ms). The actions detected are queued, to be
+// performed once the current animation ends.
+void SleepAndRead(uint16_t DelayMs)
 {
 	while (DelayMs--)
-		_delay_ms(1);
+	{
+		if (!Rings::ReadNext())
+			continue;
+		Action::Type CurAction = Controls::DetermineAction();
+		if (CurAction != Action::None)
+		{
+			Controls::PushPendingAction(CurAction);
+			Rings::Reset();
+			Controls::ResetSensors();
+		}
+	}
 }
 
 void Animate()
@@ -60,7 +71,10 @@ void Animate()
 		Leds::Update();
 		if (NextDelayMs == 0)
 			break;
-		Sleep(NextDelayMs);
+
+		// Catch up with the pending actions, so that fast players are
+		// not slowed down by the animations.
+		SleepAndRead(NextDelayMs >> Controls::GetAnimationSpeedUp());
 	}
 }
 
@@ -78,41 +92,37 @@ void Reset()
 	Leds::Update();
 
 	Controls::ResetActionQueue();
+	Hint::Reset();
 }
 
-// Perform some random (animated) rotations.
+// Perform the (animated) rotations of a scramble of the pool, which reaches
+// a uniformly random state (see AVRubik/scrambles.h).
 void Scramble()
 {
-	STATIC_ASSERT(Rotation::Top == 0 && (Rotation::Bottom + Rotation::CCW) == Rotation::NumRotations - 1,
-		      "The rotation constants are used as indices below.");
-
-	uint8_t NumRotations = NumScrambleRotations;
-	assert(NumRotations > 0);
-
-	// Choose first rotation randomly.
-	Rotation::Type PrevRot = Rand8::Get(0, Rotation::NumRotations - 1);
-	
-	// Perform the rotation animation.
-	Cube::Animation::Rotate(PrevRot);
-	Animate();
+	STATIC_ASSERT(Rotation::NumRotations <= Scrambles::End, "Rotations are stored on 4 bits.");
 
-	while (--NumRotations)
+	// Skip the scrambles before the chosen one.
+	uint8_t ScrambleIdx = Rand8::Get(0, Scrambles::NumScrambles - 1);
+	for (uint16_t NibbleIdx = 0; ; ++NibbleIdx)
 	{
-		// Choose the next rotation randomly so that it doesn't cancel
-		// the previous one.
-		Rotation::Type CurRot = Rand8::Get(0, Rotation::NumRotations - 2);
-		if (CurRot >= Rotation::Opposite(PrevRot))
-			++CurRot;
-
-		// Perform the rotation animation.
-		Cube::Animation::Rotate(CurRot);
-		Animate();
-
-		PrevRot = CurRot;
+		uint8_t Byte = pgm_read_byte(&Scrambles::f_Rotations[NibbleIdx >> 1]);
+		Rotation::Type CurRotation = ((NibbleIdx & 1) ? Byte >> 4 : Byte & 0x0F);
+		if (CurRotation == Scrambles::End)
+		{
+			if (ScrambleIdx == 0)
+				break;
+			--ScrambleIdx;
+		}
+		else if (ScrambleIdx == 0)
+		{
+			Cube::Animation::Rotate(CurRotation);
+			Animate();
+		}
 	}
 
 	// Undo makes no sense after a scramble anyway.
 	Controls::ResetActionQueue();
+	Hint::Reset();
 }
 
 void Undo()
@@ -122,6 +132,20 @@ void Undo()
 	Rotation::Type CurRotation = Controls::PopAction();
 	if (CurRotation != Rotation::None)
 	{
+		Hint::Reset();
+
+		// The undos queued meanwhile restore the earlier states at once,
+		// without animation: only the last one is animated.
+		while (Controls::PeekPendingAction() == Action::Undo)
+		{
+			Rotation::Type PrevRotation = Controls::PopAction();
+			if (PrevRotation == Rotation::None)
+				break;
+			Controls::PopPendingAction();
+			Cube::Apply(Rotation::Opposite(CurRotation));
+			CurRotation = PrevRotation;
+		}
+
 		Cube::Animation::Rotate(Rotation::Opposite(CurRotation));
 		Animate();
 	}
@@ -138,8 +162,10 @@ void Undo()
 
 void Rotate(Rotation::Type CurRotation)
 {
-	// Add the rotation to the action queue.
+	// Add the rotation to the action queue, and follow the hint if it was
+	// the hinted rotation.
 	Controls::PushAction(CurRotation);
+	Hint::OnRotation(CurRotation);
 
 	// Perform the rotation animation.
 	Cube::Animation::Rotate(CurRotation);
@@ -160,28 +186,44 @@ int main(void)
 	Rings::Reset();
 	Controls::ResetSensors();
 	Controls::ResetActionQueue();
+	Controls::ResetPendingActions();
 	Leds::Update();
 
+	// Calibrate the rings with the LEDs on, as they will be when read.
+	Rings::Calibrate();
+
 	for (;;)
 	{
-		Rings::Read();
-		bool CubeHasChanged = Controls::UpdateCubeBrightness();
-		Action::Type CurAction = Controls::DetermineAction();
+		// The actions detected during the last animation come first.
+		Action::Type CurAction = Controls::PopPendingAction();
+		if (CurAction == Action::None)
+		{
+			Rings::Read();
+			Hint::Step();
+			bool CubeHasChanged = Controls::UpdateCubeBrightness();
+			CurAction = Controls::DetermineAction();
+			if (CurAction == Action::None)
+			{
+				if (CubeHasChanged)
+					Leds::Update();
+				continue;
+			}
+
+			// Reset the sensors before the action, since its animation
+			// reads the rings to detect the next ones.
+			Rings::Reset();
+			Controls::ResetSensors();
+		}
 
+		Controls::SetActiveAction(CurAction);
 		switch (CurAction)
 		{
-		case Action::None:     if (CubeHasChanged) Leds::Update(); break;
 		case Action::Reset:    Reset();                            break;
 		case Action::Scramble: Scramble();                         break;
 		case Action::Undo:     Undo();                             break;
+		case Action::Hint:     Hint::Request();                    break;
 		default:               Rotate(CurAction);                  break;
 		}
-
-		// If an action has been done, reset the sensors.
-		if (CurAction != Action::None)
-		{
-			Rings::Reset();
-			Controls::ResetSensors();
-		}
+		Controls::SetActiveAction(Action::None);
 	}
 }
@@ -30,9 +30,15 @@ void Init()
 void Update()
 {
 	const Facelet::Type* pFacelets = Cube::GetFacelets();
+	const uint8_t* pBrightness = Cube::GetBrightness();
+	uint8_t BrightnessBits = 0;
 	for (uint8_t FaceletIdx = 0; FaceletIdx < Cube::NumFacelets; ++FaceletIdx)
 	{
-		const uint8_t* pColorComponents = &Colors[pFacelets[FaceletIdx]].r;
+		// Brightness is read one mask byte every 8 facelets, lowest bit first.
+		if ((FaceletIdx & 7) == 0)
+			BrightnessBits = *pBrightness++;
+		const uint8_t* pColorComponents = &GetColor(pFacelets[FaceletIdx], BrightnessBits & 1).r;
+		BrightnessBits >>= 1;
 		for (uint8_t ColorIdx = 0; ColorIdx < 3; ++ColorIdx)
 		{
 			uint8_t ColorComponent = pColorComponents[ColorIdx];
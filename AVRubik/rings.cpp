@@ -7,11 +7,65 @@ namespace
 
 // Dlai d'attente entre le changement du registre  dcalage et la lecture (en ms)
 #define SETTLE_DELAY 1
-// Seuil pour le registre  dcalage
-#define THRESHOLD 32
 
-// Mmoire qui contient les 4 dernires valeurs lues pour chaque anneau
-uint8_t g_InputRaw[Controls::NumSensors / 2] = { 0 };
+// Marge minimale et maximale du seuil de chaque anneau au-dessus de sa
+// lecture au repos
+#define MIN_MARGIN 8
+#define MAX_MARGIN 32
+
+// Nombre de lectures de tous les anneaux pour la calibration initiale
+const uint8_t NumCalibrationReads = 16;
+
+// Une lecture au repos rapproche d'une unit le niveau de l'anneau, une
+// lecture sur LevelTrackingPeriod de tous les anneaux: il suit une drive
+// d'environ 2,5 units par seconde (une lecture toutes les 25 ms), et garde
+// la mdiane des lectures plutt que leur moyenne, sans bits de fraction.
+const uint8_t LevelTrackingPeriod = 16;
+
+// Poids d'une lecture dans le niveau, hors calibration: le pas de
+// 1/2^TrackingRate de l'cart est alors toujours arrondi  une unit.
+const uint8_t TrackingRate = 8;
+
+// Poids d'une lecture dans la moyenne du bruit: 1/2^NoiseTrackingRate, soit
+// une constante de temps d'environ 0,4 s. Le bruit n'a que NoiseFractionBits
+// bits de fraction: il suit donc les variations rcentes, pas celles des
+// dernires secondes.
+const uint8_t NoiseTrackingRate = 4;
+
+// Les lectures d'un anneau touch sont aussi prises en compte une lecture
+// sur 64 de tous les anneaux (1,6 s), pour qu'un anneau dont la lecture au
+// repos a dpass son seuil ne reste pas touch indfiniment. Leur cart,
+// plafonn  MaxDeviation, augmente alors le bruit, donc la marge: un anneau
+// bloqu revient en environ 15 s pour un cart de 40, et un doigt tenu 4 s
+// ne dplace le niveau que de 2 ou 3 units. Multiple de LevelTrackingPeriod.
+const uint8_t TouchedTrackingPeriod = 64;
+
+// Bits de fraction du bruit, et cart maximal pris en compte pour le bruit
+const uint8_t NoiseFractionBits = NoiseTrackingRate;
+const uint8_t MaxDeviation = 15;
+
+// Nombre de lectures conserves pour l'anti-rebond
+const uint8_t NumSamples = 4;
+
+// Mmoire qui contient les 4 dernires lectures de tous les anneaux, une
+// lecture par plan de bits: le bit i%8 de l'octet i/8 pour l'anneau i
+uint8_t g_Samples[NumSamples][Controls::NumSensorBytes] = { { 0 } };
+
+// Pour chaque anneau, son niveau, la mdiane de ses lectures au repos, et la
+// moyenne mobile exponentielle de leur cart absolu  ce niveau, son bruit
+// (4 bits de fraction). Son seuil en est tir, voir IsTouched().
+uint8_t g_Levels[Controls::NumSensors] = { 0 };
+uint8_t g_Noise[Controls::NumSensors] = { 0 };
+
+// Plan de g_Samples qui recevra la prochaine lecture
+uint8_t g_SampleIdx = 0;
+
+// Prochain anneau  lire, et lectures des anneaux de son octet dj faites
+uint8_t g_RingIdx = 0;
+uint8_t g_Sample = 0;
+
+// Nombre de lectures de tous les anneaux, modulo TouchedTrackingPeriod
+uint8_t g_ReadCount = 0;
 
 // Dcale 1 bit dans le registre  dcalage. Les bits sont dcals
 // du moins significatif vers le plus significatif.
@@ -26,8 +80,8 @@ void Shift( void )
 	SH_REG_PORT &= ~_BV( SH_REG_RCK );
 }
 
-// Lecture de l'tat du prochain anneau
-bool ReadOnce( void )
+// Lecture du ADC pour le prochain anneau
+uint8_t ReadOnce( void )
 {
 	// Dcaler le "1" pour lire le prochain anneau
 	Shift();
@@ -51,52 +105,102 @@ bool ReadOnce( void )
 	// Remet ADIF  0
 	ADCSRA |= _BV( ADIF );
 
-	return Res > THRESHOLD;
+	return Res;
 }
 
-// Lecture d'une paire d'anneaux
-uint8_t ReadPair( void )
+// Ajoute une lecture au repos aux moyennes d'un anneau: si TrackLevel, son
+// niveau s'en rapproche de 1/2^Rate de leur cart, d'au moins une unit, et
+// leur cart s'ajoute au bruit avec un poids de 1/2^Rate, au plus
+// 1/2^NoiseTrackingRate.
+void Track( uint8_t RingIdx, uint8_t Res, uint8_t Rate, bool TrackLevel )
 {
-	uint8_t Res = 0;
+	uint8_t Level = g_Levels[RingIdx];
+	if (TrackLevel)
+	{
+		uint8_t Gap = (Res > Level ? Res - Level : Level - Res);
+		uint8_t Step = Gap >> Rate;
+		if (Step == 0 && Gap != 0)
+			Step = 1;
+		Level = (Res > Level ? Level + Step : Level - Step);
+		g_Levels[RingIdx] = Level;
+	}
 
-	if (ReadOnce()) Res |= _BV( 0 );
-	if (ReadOnce()) Res |= _BV( 4 );
+	uint8_t Deviation = (Res > Level ? Res - Level : Level - Res);
+	if (Deviation > MaxDeviation)
+		Deviation = MaxDeviation;
+	if (Rate > NoiseTrackingRate)
+		Rate = NoiseTrackingRate;
+	uint8_t Noise = g_Noise[RingIdx];
+	Noise -= Noise >> Rate;
+	Noise += Deviation << (NoiseFractionBits - Rate);
+	g_Noise[RingIdx] = Noise;
+}
 
-	return Res;
+// Retourne true si la lecture d'un anneau dpasse son seuil: son niveau,
+// plus 4 fois son bruit, entre MIN_MARGIN et MAX_MARGIN.
+bool IsTouched( uint8_t RingIdx, uint8_t Res )
+{
+	uint8_t Margin = g_Noise[RingIdx] >> (NoiseFractionBits - 2);
+	if (Margin < MIN_MARGIN)
+		Margin = MIN_MARGIN;
+	else if (Margin > MAX_MARGIN)
+		Margin = MAX_MARGIN;
+	return Res > g_Levels[RingIdx] + Margin;
 }
 
-// Lecture de tous les anneaux, avant le debouncing.
-void ReadRaw( void )
+// Lecture du prochain anneau, avant le debouncing. Retourne true une fois
+// le dernier anneau lu, la lecture de tous les anneaux tant complte.
+bool ReadRaw( void )
 {
-	// Srialiser un 1
-	SH_REG_PORT |=  (1 << SH_REG_SER_IN);
+	// Srialiser un 1 avant le premier anneau
+	if (g_RingIdx == 0)
+		SH_REG_PORT |=  (1 << SH_REG_SER_IN);
 
-	for (uint8_t i = 0; i < Controls::NumSensors / 2; i++)
+	// Les lectures au repos mettent  jour le seuil de l'anneau, ainsi
+	// qu'une lecture sur TouchedTrackingPeriod quand il est touch
+	uint8_t Res = ReadOnce();
+	bool IsOn = IsTouched(g_RingIdx, Res);
+	uint8_t Period = (IsOn ? TouchedTrackingPeriod : LevelTrackingPeriod);
+	bool TrackLevel = ((g_ReadCount & (Period - 1)) == 0);
+	if (!IsOn || TrackLevel)
+		Track(g_RingIdx, Res, TrackingRate, TrackLevel);
+
+	// Accumuler les lectures de 8 anneaux par octet, puis remplacer
+	// l'octet de la plus ancienne lecture
+	uint8_t Bit = 1 << (g_RingIdx & 7);
+	if (IsOn)
+		g_Sample |= Bit;
+	if (Bit == 0x80 || g_RingIdx == Controls::NumSensors - 1)
 	{
-		// Dcaler les bits pour conserver en mmoire les 3 derniers bits lus
-		g_InputRaw[i] <<= 1;
-		// Le dcalage va mettre le bit 0  0, mais il faut aussi mettre le bit 4  0
-		g_InputRaw[i]  &= ~_BV( 4 );
-		// Remplacer les bits 0 et 4 par les nouvelles lectures
-		g_InputRaw[i]  |= ReadPair();
+		g_Samples[g_SampleIdx][g_RingIdx >> 3] = g_Sample;
+		g_Sample = 0;
 	}
+	if (++g_RingIdx < Controls::NumSensors)
+		return false;
 
 	// Ajouter un "0" pour s'assurer qu'aucun anneau ne reoit des
 	// un signal  1 plus longtemps que les autres.
 	Shift();
+	g_RingIdx = 0;
+	g_SampleIdx = (g_SampleIdx + 1) & (NumSamples - 1);
+	g_ReadCount = (g_ReadCount + 1) & (TouchedTrackingPeriod - 1);
+	return true;
 }
 
-// Fonction  double utilit:
-// 	- Applique un filtre anto-rebond sur les lectures des anneaux
-//	- Ordonne les bits dans la variable finale
+// Applique un filtre anti-rebond sur les lectures des anneaux: un anneau
+// est actif s'il l'a t lors d'une des 4 dernires lectures. Les 24
+// anneaux sont traits en parallle, un octet  la fois.
 void Debounce( void )
 {
-	for (uint8_t InputIdx = 0, SensorIdx = 0; InputIdx < Controls::NumSensors / 2; ++InputIdx)
+	uint8_t SensorsOn[Controls::NumSensorBytes];
+	for (uint8_t ByteIdx = 0; ByteIdx < Controls::NumSensorBytes; ByteIdx++)
 	{
-		uint8_t RawInput = g_InputRaw[InputIdx];
-		Controls::UpdateCounter(SensorIdx++, (RawInput & 0x0F) != 0);
-		Controls::UpdateCounter(SensorIdx++, (RawInput & 0xF0) != 0);
+		uint8_t On = 0;
+		for (uint8_t i = 0; i < NumSamples; i++)
+			On |= g_Samples[i][ByteIdx];
+		SensorsOn[ByteIdx] = On;
 	}
+	Controls::UpdateSensors(SensorsOn);
 }
 
 }
@@ -122,18 +226,49 @@ void Init( void )
 	DIDR0 |= _BV(ADC1D);
 }
 
+// Calibration des seuils des anneaux,  la mise sous tension (environ
+// 400 ms): le niveau et le bruit partent de la moyenne des premires
+// lectures, leur poids passant de 1  1/16. Aucun anneau ne doit tre touch.
+void Calibrate( void )
+{
+	uint8_t Rate = 0;
+	for (uint8_t ReadIdx = 0; ReadIdx < NumCalibrationReads; ReadIdx++)
+	{
+		// Poids de 1/2^Rate, Rate tant le log2 de ReadIdx + 1
+		if (ReadIdx != 0 && (ReadIdx & (ReadIdx + 1)) == 0)
+			Rate++;
+
+		SH_REG_PORT |=  (1 << SH_REG_SER_IN);
+		for (uint8_t RingIdx = 0; RingIdx < Controls::NumSensors; RingIdx++)
+			Track(RingIdx, ReadOnce(), Rate, true);
+		Shift();
+	}
+}
+
 // Lecture de tous les anneaux. Fonction devant tre appele de l'externe.
 void Read( void )
 {
-	ReadRaw();
+	while (!ReadNext()) {}
+}
+
+// Lecture d'un seul anneau (environ 1 ms), pour lire les anneaux pendant
+// les animations. Retourne true quand la lecture de tous les anneaux est
+// complte, les capteurs ayant t mis  jour.
+bool ReadNext( void )
+{
+	if (!ReadRaw())
+		return false;
 	Debounce();
+	return true;
 }
 
 // Remet toutes les valeurs lues  0.
 void Reset()
 {
-	for (uint8_t i = 0; i < Controls::NumSensors / 2; i++)
-		g_InputRaw[i] = 0;
+	for (uint8_t i = 0; i < NumSamples; i++)
+		for (uint8_t ByteIdx = 0; ByteIdx < Controls::NumSensorBytes; ByteIdx++)
+			g_Samples[i][ByteIdx] = 0;
+	g_Sample = 0;
 }
 
 }
@@ -4,7 +4,9 @@ namespace Rings
 {
 
 void Init();	// Initialize ADC and shift register pins.
+void Calibrate();	// Set the threshold of each ring from its readings when not touched (about 400 ms).
 void Read();	// Read status of all rings (about 25 ms).
+bool ReadNext();	// Read status of the next ring (about 1 ms). Returns true when all rings have been read.
 void Reset();	// Reset debouncing bits to 0.
 
 }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "../Cube/config.h"
+
+// Pool of scrambles reaching uniformly random states, picked at random by
+// Scramble(). Generated by RubikScramble -c 32 -s 1 -n 20 -T 1000.
+namespace Scrambles
+{
+const uint8_t NumScrambles = 32;
+const uint8_t End = 0x0F;
+
+// Rotations, two per byte (the first one in the low nibble), each scramble
+// ending with End. This is stored in flash memory and must be accessed
+// using pgm_read_byte().
+const uint8_t f_Rotations[487] PROGMEM =
+{
+	0x44, 0x16, 0x21, 0x32, 0x23, 0x02, 0x30, 0x23, 0x72, 0x38, 0x22, 0x50,
+	0x25, 0x42, 0x55, 0x34, 0xF6, 0x55, 0x22, 0x2B, 0x32, 0x53, 0x11, 0x35,
+	0xA3, 0x90, 0x70, 0x14, 0x91, 0x94, 0x22, 0x6F, 0x55, 0x22, 0x11, 0x2B,
+	0x42, 0x04, 0x2B, 0x76, 0x09, 0x37, 0x23, 0x62, 0x33, 0x00, 0x3F, 0x43,
+	0x54, 0x11, 0x50, 0x22, 0x70, 0x22, 0x45, 0xB4, 0x58, 0x03, 0xA1, 0x11,
+	0x5F, 0x35, 0x23, 0x42, 0x04, 0x20, 0x32, 0x23, 0x02, 0x30, 0x70, 0x83,
+	0x44, 0xB9, 0x11, 0x1B, 0x0F, 0x20, 0x42, 0x54, 0x44, 0x56, 0x95, 0x72,
+	0x4B, 0xB6, 0x51, 0x35, 0x14, 0x91, 0x5F, 0x15, 0x61, 0x44, 0x11, 0x22,
+	0x33, 0x55, 0x54, 0x95, 0x45, 0x14, 0xB1, 0x22, 0x44, 0x01, 0x4F, 0x04,
+	0x22, 0x44, 0x10, 0x51, 0x15, 0x33, 0x36, 0x04, 0x50, 0x22, 0x7B, 0x44,
+	0x41, 0x5F, 0x44, 0x35, 0x03, 0x33, 0x22, 0x33, 0x22, 0x26, 0x72, 0x55,
+	0x08, 0x03, 0x80, 0x00, 0x22, 0xF1, 0x33, 0x22, 0x46, 0x54, 0x35, 0x43,
+	0x54, 0xA5, 0xA6, 0xB1, 0x69, 0x11, 0x94, 0xF2, 0x30, 0x63, 0x1B, 0x41,
+	0x14, 0x61, 0x44, 0x30, 0x5A, 0x21, 0x35, 0x53, 0x35, 0x23, 0xF2, 0x40,
+	0x14, 0x61, 0x33, 0x3B, 0x43, 0x64, 0x22, 0x44, 0xA9, 0x55, 0x44, 0x29,
+	0x44, 0x33, 0x00, 0x3F, 0x63, 0x11, 0x33, 0x22, 0x11, 0x33, 0x25, 0x72,
+	0x55, 0xB7, 0x47, 0x54, 0x15, 0x41, 0x31, 0xBF, 0x11, 0x44, 0x4B, 0x54,
+	0x45, 0x14, 0x51, 0x12, 0x21, 0xA2, 0x96, 0x85, 0x1A, 0x32, 0xF3, 0x33,
+	0x44, 0x55, 0x33, 0x10, 0x61, 0x11, 0x44, 0x86, 0x01, 0x7B, 0x44, 0x00,
+	0x49, 0x14, 0xF1, 0x33, 0x30, 0x43, 0x54, 0x11, 0x30, 0x2B, 0x50, 0x45,
+	0x34, 0x70, 0x1A, 0x00, 0x1F, 0x41, 0x54, 0x35, 0x43, 0x64, 0x44, 0x55,
+	0x22, 0x00, 0x21, 0x3A, 0x03, 0x43, 0x55, 0x11, 0x96, 0x3F, 0x63, 0x22,
+	0x33, 0x44, 0x33, 0xA5, 0x55, 0x52, 0x48, 0x14, 0x51, 0x75, 0x83, 0x33,
+	0xF6, 0x4B, 0xB4, 0x11, 0x36, 0x43, 0x34, 0x53, 0x85, 0x11, 0x59, 0x22,
+	0x45, 0x64, 0x33, 0x14, 0xF1, 0x26, 0x12, 0x61, 0x44, 0x11, 0x16, 0xA1,
+	0x70, 0x4B, 0x74, 0x14, 0x31, 0x23, 0x51, 0xF5, 0x26, 0x52, 0x11, 0x44,
+	0x36, 0x23, 0x11, 0xB2, 0x29, 0xA6, 0x2B, 0xA2, 0x03, 0xF0, 0x30, 0x63,
+	0x55, 0x22, 0x35, 0xB3, 0x63, 0x27, 0x11, 0x29, 0x62, 0x58, 0x75, 0xFB,
+	0x11, 0x00, 0x11, 0x3B, 0x63, 0x11, 0x00, 0x6A, 0x33, 0x02, 0x09, 0x30,
+	0xA3, 0x11, 0x15, 0x0F, 0x33, 0x00, 0x45, 0x34, 0x03, 0x22, 0x33, 0x00,
+	0x74, 0x44, 0x00, 0xB1, 0x83, 0x83, 0x6F, 0x55, 0x44, 0x11, 0x20, 0x12,
+	0x01, 0x80, 0x8B, 0x1A, 0x56, 0x35, 0x23, 0x12, 0x35, 0xF3, 0x22, 0x11,
+	0x22, 0xB6, 0x11, 0x16, 0x21, 0xB2, 0x22, 0xA9, 0x80, 0x14, 0x90, 0x22,
+	0x5F, 0x25, 0x02, 0x11, 0x22, 0x4B, 0x54, 0x22, 0x00, 0x33, 0x36, 0x25,
+	0x04, 0x44, 0x46, 0x74, 0x1F, 0x01, 0x11, 0x22, 0x11, 0x30, 0x03, 0x10,
+	0x21, 0xA5, 0x45, 0x59, 0x42, 0x16, 0xF4, 0x11, 0x55, 0x22, 0x11, 0x33,
+	0x25, 0xB2, 0xA8, 0x33, 0x44, 0x15, 0x50, 0x25, 0x00, 0x75, 0xBF, 0x44,
+	0x20, 0x42, 0x54, 0x11, 0x33, 0x55, 0x11, 0x02, 0x29, 0x02, 0x64, 0x33,
+	0x22, 0xFB, 0x22, 0x00, 0x44, 0x00, 0x4B, 0x14, 0xB1, 0x53, 0x15, 0x31,
+	0x02, 0x01, 0x10, 0x21, 0xF6, 0x10, 0x21, 0x62, 0x11, 0x55, 0x34, 0x18,
+	0x14, 0x61, 0x78, 0x00, 0x11, 0x64, 0xFF
+};
+}
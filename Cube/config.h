@@ -14,6 +14,7 @@
 	// This is needed for non-AVR platforms.
 	#define PROGMEM
 	#define pgm_read_byte(Addr)	(*(Addr))
+	#define pgm_read_dword(Addr)	(*(Addr))
 #else
 	#include <avr/pgmspace.h>
 #endif
@@ -1,4 +1,6 @@
 #include "controls.h"
+#include "hint.h"
+#include "sequence.h"
 #include "config.h"
 
 // Unnamed namespace for internal details.
@@ -8,28 +10,79 @@ namespace
 // before performing the action. A sensor read takes about 25 ms.
 const int8_t DetectionThreshold = 30;	// about 750 ms
 
-// For a given face rotation, there are 8 sensors involved in detecting it.
-const uint8_t NumSensorsPerRotation = 8;
+// Number of sensor configurations that perform a reset.
+const uint8_t NumResetOps = 3;
 
-// For a given vertex, there are 3 sensors involved in detecting an undo operation.
-const uint8_t NumSensorsPerUndo = 3;
+// Number of rows of a face along which a finger can swipe to turn it: one on
+// each neighbor face, from one corner sensor to the other.
+const uint8_t NumSwipeRows = 4;
 
-// Number of sensor configurations that perform a reset.
-const uint8_t NumResetOps = 2;
+// Maximum number of reads from the first touch of a swipe to its end, when
+// the finger leaves the first sensor. Beyond, the fingers are held in place.
+const uint8_t MaxSwipeReads = 16;	// about 400 ms
+
+// Set of sensors, as a 24-bit mask: bit i is set for sensor i.
+typedef uint32_t SensorMask;
+
+STATIC_ASSERT(Controls::NumSensors <= 32, "Sensors must fit in a SensorMask.");
+
+#define SENSOR_BIT(Idx)			(SensorMask(1) << (Idx))
+#define SENSOR_MASK2(A, B)		(SENSOR_BIT(A) | SENSOR_BIT(B))
+#define SENSOR_MASK3(A, B, C)		(SENSOR_MASK2(A, B) | SENSOR_BIT(C))
+#define SENSOR_MASK4(A, B, C, D)	(SENSOR_MASK2(A, B) | SENSOR_MASK2(C, D))
+
+// Number of bits of the hold counters, which count up to DetectionThreshold.
+const uint8_t NumHoldBits = 5;
+
+STATIC_ASSERT(DetectionThreshold < (1 << NumHoldBits), "The hold counters must reach DetectionThreshold.");
 
-// For a given reset operation, there are 4 sensors involved in detecting it (a face).
-const uint8_t NumSensorsPerReset = 4;
+// Hold counters: the number of consecutive Read() for which each sensor has
+// been ON, up to DetectionThreshold. They are bit-sliced (vertical counters):
+// bit i%8 of g_HoldPlanes[b][i/8] is bit b of the counter of sensor i, so that
+// all the counters are updated at once by a few byte operations.
+uint8_t g_HoldPlanes[NumHoldBits][Controls::NumSensorBytes];
 
-// Sensor counters. A positive value of N means that the sensor has been ON
-// for N consecutive Read(), and a negative value of -N means that it has been
-// OFF for N consecutive Read().
-int8_t g_SensorCounters[Controls::NumSensors];
+// Sensors that are ON, and sensors that have been ON for at least
+// DetectionThreshold consecutive Read(), kept up to date by UpdateSensors().
+SensorMask g_SensorsOn;
+SensorMask g_SensorsHeld;
+SensorMask g_SensorsRising;	// Sensors ON that were OFF at the previous Read().
+
+// Action being performed. While it, or an action still pending, is held,
+// it is not detected again: its hold counters restart instead, so that a
+// held gesture repeats its action once per DetectionThreshold reads after
+// the previous one, not during its animation.
+Action::Type g_ActiveAction = Action::None;
+
+// Swipe in progress: the rotation it will perform, the row of f_SwipeRows
+// it follows, and the number of reads since its first touch.
+Rotation::Type g_SwipeRotation;
+uint8_t g_SwipeRow;
+uint8_t g_SwipeReads;
+
+// Number of reads between the first touch of the last detected action and
+// its detection.
+uint8_t g_ActionLatency;
 
 // Number of entries in the action queue. Maximum number of undo operations.
 const uint8_t ActionQueueSize = 16;
 
-// Queue of the last actions taken, most recent first.
-Rotation::Type g_ActionQueue[ActionQueueSize];
+// Queue of the last actions taken, oldest first, kept canonical (see
+// Sequence) so that no entry is wasted on moves that cancel out. The extra
+// entry allows Sequence::Append() to work on a full queue.
+Rotation::Type g_ActionQueue[ActionQueueSize + 1];
+uint8_t g_ActionQueueLength;
+
+// Number of entries in the pending action queue (a power of 2).
+const uint8_t PendingQueueSize = 4;
+
+STATIC_ASSERT((PendingQueueSize & (PendingQueueSize - 1)) == 0, "PendingQueueSize must be a power of 2.");
+
+// Actions detected during an animation, to be performed when it ends: a
+// circular buffer of g_NumPendingActions entries from g_FirstPendingAction.
+Action::Type g_PendingActions[PendingQueueSize];
+uint8_t g_FirstPendingAction;
+uint8_t g_NumPendingActions;
 
 // This table converts a sensor index into a facelet index.
 // This is stored in flash memory and must be accessed using pgm_read_byte().
@@ -55,105 +108,134 @@ const Facelet::Type f_SensorToFacelet[Controls::NumSensors] PROGMEM =
 };
 #endif
 
-// This table gives the array of 8 sensor indices that correspond to a given
-// face index. CW and CCW are ignored. f_SensorsPerRotation[i][0] must always
-// turn face i CW, and the next sensors are in order.
-// This is stored in flash memory and must be accessed using pgm_read_byte().
+// Sensors detecting each rotation, in the order of namespace Rotation: a
+// rotation is detected when the 8 sensors around its face are OFF except the
+// two of either mask. The two sensors of a mask are on opposite sides of the
+// face, and the next ones (counter-clockwise) detect the opposite rotation.
+// Undos are detected when the 3 sensors around a vertex are all ON, and
+// resets when the 4 sensors of a face are all ON.
+// This is stored in flash memory and must be accessed using pgm_read_dword().
 #ifdef USE_SIMULATOR
-const uint8_t f_SensorsPerRotation[Cube::NumFaces][NumSensorsPerRotation] PROGMEM =
-{
-	{ 4,  5,  8,  9, 12, 13, 16, 17},	// top
-	{20, 21, 10,  8,  3,  2, 17, 19},	// front
-	{21, 23, 14, 12,  1,  3,  5,  7},	// right
-	{23, 22, 18, 16,  0,  1,  9, 11},	// back
-	{22, 20,  6,  4,  2,  0, 13, 15},	// left
-	{15, 14, 11, 10,  7,  6, 19, 18}	// bottom
+const SensorMask f_RotationMasks[Rotation::NumRotations][2] PROGMEM =
+{
+	{SENSOR_MASK2( 4, 12), SENSOR_MASK2( 8, 16)},	// top
+	{SENSOR_MASK2(20,  3), SENSOR_MASK2(10, 17)},	// front
+	{SENSOR_MASK2(21,  1), SENSOR_MASK2(14,  5)},	// right
+	{SENSOR_MASK2(23,  0), SENSOR_MASK2(18,  9)},	// back
+	{SENSOR_MASK2(22,  2), SENSOR_MASK2( 6, 13)},	// left
+	{SENSOR_MASK2(15,  7), SENSOR_MASK2(11, 19)},	// bottom
+	{SENSOR_MASK2( 5, 13), SENSOR_MASK2( 9, 17)},	// top CCW
+	{SENSOR_MASK2(21,  2), SENSOR_MASK2( 8, 19)},	// front CCW
+	{SENSOR_MASK2(23,  3), SENSOR_MASK2(12,  7)},	// right CCW
+	{SENSOR_MASK2(22,  1), SENSOR_MASK2(16, 11)},	// back CCW
+	{SENSOR_MASK2(20,  0), SENSOR_MASK2( 4, 15)},	// left CCW
+	{SENSOR_MASK2(14,  6), SENSOR_MASK2(10, 18)}	// bottom CCW
 };
-const uint8_t f_SensorsPerUndo[Cube::NumVertices][NumSensorsPerUndo] PROGMEM =
-{
-	{ 0, 13, 16},
-	{ 1,  9, 12},
-	{ 2, 17,  4},
-	{ 3,  5,  8},
-	{20,  6, 19},
-	{21, 10,  7},
-	{22, 18, 15},
-	{23, 14, 11}
+const SensorMask f_UndoMasks[Cube::NumVertices] PROGMEM =
+{
+	SENSOR_MASK3( 0, 13, 16),
+	SENSOR_MASK3( 1,  9, 12),
+	SENSOR_MASK3( 2, 17,  4),
+	SENSOR_MASK3( 3,  5,  8),
+	SENSOR_MASK3(20,  6, 19),
+	SENSOR_MASK3(21, 10,  7),
+	SENSOR_MASK3(22, 18, 15),
+	SENSOR_MASK3(23, 14, 11)
 };
-const uint8_t f_SensorsPerReset[NumResetOps][NumSensorsPerReset] PROGMEM =
+const SensorMask f_ResetMasks[NumResetOps] PROGMEM =
 {
-	{16, 17, 18, 19},	// Reset, green face
-	{ 4,  5,  6,  7}	// Scramble, red face
+	SENSOR_MASK4(16, 17, 18, 19),	// Reset, green face
+	SENSOR_MASK4( 4,  5,  6,  7),	// Scramble, red face
+	SENSOR_MASK4( 0,  1,  2,  3)	// Hint, white face
 };
 #else
-const uint8_t f_SensorsPerRotation[Cube::NumFaces][NumSensorsPerRotation] PROGMEM =
-{
-	{ 1,  0,  6,  7, 22, 23, 14, 15},	// top
-	{18, 19,  4,  6,  8,  9, 15, 13},	// front
-	{19, 17, 21, 22, 11,  8,  0,  2},	// right
-	{17, 16, 12, 14, 10, 11,  7,  5},	// back
-	{16, 18,  3,  1,  9, 10, 23, 20},	// left
-	{20, 21,  5,  4,  2,  3, 13, 12}	// bottom
+const SensorMask f_RotationMasks[Rotation::NumRotations][2] PROGMEM =
+{
+	{SENSOR_MASK2( 1, 22), SENSOR_MASK2( 6, 14)},	// top
+	{SENSOR_MASK2(18,  8), SENSOR_MASK2( 4, 15)},	// front
+	{SENSOR_MASK2(19, 11), SENSOR_MASK2(21,  0)},	// right
+	{SENSOR_MASK2(17, 10), SENSOR_MASK2(12,  7)},	// back
+	{SENSOR_MASK2(16,  9), SENSOR_MASK2( 3, 23)},	// left
+	{SENSOR_MASK2(20,  2), SENSOR_MASK2( 5, 13)},	// bottom
+	{SENSOR_MASK2( 0, 23), SENSOR_MASK2( 7, 15)},	// top CCW
+	{SENSOR_MASK2(19,  9), SENSOR_MASK2( 6, 13)},	// front CCW
+	{SENSOR_MASK2(17,  8), SENSOR_MASK2(22,  2)},	// right CCW
+	{SENSOR_MASK2(16, 11), SENSOR_MASK2(14,  5)},	// back CCW
+	{SENSOR_MASK2(18, 10), SENSOR_MASK2( 1, 20)},	// left CCW
+	{SENSOR_MASK2(21,  3), SENSOR_MASK2( 4, 12)}	// bottom CCW
 };
-const uint8_t f_SensorsPerUndo[Cube::NumVertices][NumSensorsPerUndo] PROGMEM =
-{
-	{10, 23, 14},
-	{11,  7, 22},
-	{ 9, 15,  1},
-	{ 8,  0,  6},
-	{18,  3, 13},
-	{19,  4,  2},
-	{16, 12, 20},
-	{17, 21,  5}
+const SensorMask f_UndoMasks[Cube::NumVertices] PROGMEM =
+{
+	SENSOR_MASK3(10, 23, 14),
+	SENSOR_MASK3(11,  7, 22),
+	SENSOR_MASK3( 9, 15,  1),
+	SENSOR_MASK3( 8,  0,  6),
+	SENSOR_MASK3(18,  3, 13),
+	SENSOR_MASK3(19,  4,  2),
+	SENSOR_MASK3(16, 12, 20),
+	SENSOR_MASK3(17, 21,  5)
 };
-const uint8_t f_SensorsPerReset[NumResetOps][NumSensorsPerReset] PROGMEM =
+const SensorMask f_ResetMasks[NumResetOps] PROGMEM =
 {
-	{14, 15, 12, 13},	// Reset, green face
-	{ 1,  0,  3,  2}	// Scramble, red face
+	SENSOR_MASK4(14, 15, 12, 13),	// Reset, green face
+	SENSOR_MASK4( 1,  0,  3,  2),	// Scramble, red face
+	SENSOR_MASK4( 8,  9, 10, 11)	// Hint, white face
 };
 #endif
 
-// Go through all sensor combinations that perform a rotation. If any of them
-// reach the given threshold, return the first one (according to the order
-// of the Rotation constants). Note: each counter value represents the time
-// for one successful sensor read, which takes about 25 ms.
-Action::Type DetectRotation(int8_t CounterThreshold)
+// Sensors of the rows of each face along which a swipe turns it, in the
+// order of namespace Rotation, the sensors of each row in the same order as
+// the sensors of f_RotationMasks (counter-clockwise): the finger goes from
+// the second to the first for a clockwise rotation.
+// This is stored in flash memory and must be accessed using pgm_read_dword().
+#ifdef USE_SIMULATOR
+const SensorMask f_SwipeRows[Cube::NumFaces][NumSwipeRows] PROGMEM =
+{
+	{SENSOR_MASK2( 4,  5), SENSOR_MASK2( 8,  9), SENSOR_MASK2(12, 13), SENSOR_MASK2(16, 17)},	// top
+	{SENSOR_MASK2(20, 21), SENSOR_MASK2(10,  8), SENSOR_MASK2( 3,  2), SENSOR_MASK2(17, 19)},	// front
+	{SENSOR_MASK2(21, 23), SENSOR_MASK2(14, 12), SENSOR_MASK2( 1,  3), SENSOR_MASK2( 5,  7)},	// right
+	{SENSOR_MASK2(23, 22), SENSOR_MASK2(18, 16), SENSOR_MASK2( 0,  1), SENSOR_MASK2( 9, 11)},	// back
+	{SENSOR_MASK2(22, 20), SENSOR_MASK2( 6,  4), SENSOR_MASK2( 2,  0), SENSOR_MASK2(13, 15)},	// left
+	{SENSOR_MASK2(15, 14), SENSOR_MASK2(11, 10), SENSOR_MASK2( 7,  6), SENSOR_MASK2(19, 18)}	// bottom
+};
+#else
+const SensorMask f_SwipeRows[Cube::NumFaces][NumSwipeRows] PROGMEM =
 {
-	assert(CounterThreshold > 0);
+	{SENSOR_MASK2( 1,  0), SENSOR_MASK2( 6,  7), SENSOR_MASK2(22, 23), SENSOR_MASK2(14, 15)},	// top
+	{SENSOR_MASK2(18, 19), SENSOR_MASK2( 4,  6), SENSOR_MASK2( 8,  9), SENSOR_MASK2(15, 13)},	// front
+	{SENSOR_MASK2(19, 17), SENSOR_MASK2(21, 22), SENSOR_MASK2(11,  8), SENSOR_MASK2( 0,  2)},	// right
+	{SENSOR_MASK2(17, 16), SENSOR_MASK2(12, 14), SENSOR_MASK2(10, 11), SENSOR_MASK2( 7,  5)},	// back
+	{SENSOR_MASK2(16, 18), SENSOR_MASK2( 3,  1), SENSOR_MASK2( 9, 10), SENSOR_MASK2(23, 20)},	// left
+	{SENSOR_MASK2(20, 21), SENSOR_MASK2( 5,  4), SENSOR_MASK2( 2,  3), SENSOR_MASK2(13, 12)}	// bottom
+};
+#endif
 
+// Action of each sensor configuration of f_ResetMasks.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const Action::Type f_ResetActions[NumResetOps] PROGMEM = { Action::Reset, Action::Scramble, Action::Hint };
+
+// Go through all sensor combinations that perform a rotation. If any of them
+// matches the given sensors, return the first one (according to the order
+// of the Rotation constants).
+Action::Type DetectRotation(SensorMask Sensors)
+{
 	STATIC_ASSERT(Action::Top == 0 && Action::Bottom == 5,
 		      "The rotation constants are used as indices below.");
 
 	Action::Type DetectedRotation = Action::None;
 	for (Action::Type RotIdx = Action::Top; RotIdx <= Action::Bottom; ++RotIdx)
 	{
-		// Address in Flash memory of the array of 8 sensor indices
-		// related to the rotation RotIdx (either CW or CCW).
-		const uint8_t* f_SensorIndices = f_SensorsPerRotation[RotIdx];
-		
-		// Construct a bitfield where each bit, starting from the LSB,
-		// indicates whether the corresponding sensor has reached the
-		// specified counter threshold.
-		STATIC_ASSERT(NumSensorsPerRotation <= 8, "must fit in a uint8_t");
-		uint8_t SensorBitfield = 0;
-
-		for (uint8_t i = 0; i < NumSensorsPerRotation; ++i)
-		{
-			uint8_t SensorIndex = pgm_read_byte(f_SensorIndices++);
-			SensorBitfield >>= 1;
-			if (g_SensorCounters[SensorIndex] >= CounterThreshold)
-				SensorBitfield |= 0x80;
-		}
+		SensorMask CW0  = pgm_read_dword(&f_RotationMasks[RotIdx][0]);
+		SensorMask CW1  = pgm_read_dword(&f_RotationMasks[RotIdx][1]);
+		SensorMask CCW0 = pgm_read_dword(&f_RotationMasks[RotIdx + Action::CCW][0]);
+		SensorMask CCW1 = pgm_read_dword(&f_RotationMasks[RotIdx + Action::CCW][1]);
 
-		// The sensors are arranged in the bitfield such that they
-		// are in order on the cube. Thus, two bits at distance 4
-		// relate to opposing facelets. So, 0x11 and 0x44 indicates
-		// that the rotation occurs in the CW direction and 0x22 and
-		// 0x88 indicates the CCW direction.
+		// Only the 8 sensors around the face matter.
+		SensorMask FaceSensors = Sensors & (CW0 | CW1 | CCW0 | CCW1);
 		Action::Type PossibleRotation = Action::None;
-		if (SensorBitfield == 0x11 || SensorBitfield == 0x44)
+		if (FaceSensors == CW0 || FaceSensors == CW1)
 			PossibleRotation = RotIdx;
-		else if (SensorBitfield == 0x22 || SensorBitfield == 0x88)
+		else if (FaceSensors == CCW0 || FaceSensors == CCW1)
 			PossibleRotation = RotIdx + Action::CCW;
 
 		if (PossibleRotation != Action::None)
@@ -168,24 +250,107 @@ Action::Type DetectRotation(int8_t CounterThreshold)
 	return DetectedRotation;
 }
 
-// Go through all sensor combinations that perform an undo. If any of them
-// reach the given threshold, return Action::Undo. Note: each counter value
-// represents the time for one successful sensor read, which takes about 25 ms.
-Action::Type DetectUndo(int8_t CounterThreshold)
+// Sensors of both masks of a rotation in f_RotationMasks.
+SensorMask GetRotationSensors(Rotation::Type Rot)
 {
-	assert(CounterThreshold > 0);
-	
-	for (uint8_t VertexIdx = 0; VertexIdx < Cube::NumVertices; ++VertexIdx)
+	return pgm_read_dword(&f_RotationMasks[Rot][0]) | pgm_read_dword(&f_RotationMasks[Rot][1]);
+}
+
+// Number of consecutive reads for which a sensor has been ON, up to
+// DetectionThreshold, from its hold counter.
+uint8_t GetHoldCount(SensorMask Sensor)
+{
+	uint8_t Count = 0;
+	for (uint8_t ByteIdx = 0; ByteIdx < Controls::NumSensorBytes; ++ByteIdx, Sensor >>= 8)
+	{
+		uint8_t Bit = uint8_t(Sensor);
+		if (Bit == 0)
+			continue;
+		for (uint8_t BitIdx = 0; BitIdx < NumHoldBits; ++BitIdx)
+			if ((g_HoldPlanes[BitIdx][ByteIdx] & Bit) != 0)
+				Count |= 1 << BitIdx;
+	}
+	return Count;
+}
+
+// Follow a finger swiping along a row of a face: it touches the next sensor
+// of the row, then leaves the first one, while no other sensor around the
+// face is ON. Return the rotation dragging the row along, once the finger
+// has left the first sensor. Waiting for it tells swipes apart from fingers
+// added one by one to hold a gesture.
+Action::Type DetectSwipe()
+{
+	if (g_SwipeRotation != Action::None)
 	{
-		const uint8_t* f_SensorIndices = f_SensorsPerUndo[VertexIdx];
-		uint8_t i = 0;
-		for (; i < NumSensorsPerUndo; ++i)
+		Rotation::Type Face = Rotation::GetFace(g_SwipeRotation);
+		SensorMask Row = pgm_read_dword(&f_SwipeRows[Face][g_SwipeRow]);
+		SensorMask FaceSensors = g_SensorsOn & (GetRotationSensors(Face) | GetRotationSensors(Face + Rotation::CCW));
+		++g_SwipeReads;
+
+		// Only the last sensor of the row is left: the swipe is done.
+		if (FaceSensors == (Row & GetRotationSensors(g_SwipeRotation)))
+		{
+			Action::Type Rot = g_SwipeRotation;
+			g_ActionLatency = g_SwipeReads;
+			g_SwipeRotation = Action::None;
+			return Rot;
+		}
+		if (FaceSensors != Row || g_SwipeReads >= MaxSwipeReads)
+			g_SwipeRotation = Action::None;
+		return Action::None;
+	}
+
+	if (g_SensorsRising == 0)
+		return Action::None;
+
+	// Look for a finger reaching the second sensor of a row.
+	for (Action::Type Face = Action::Top; Face <= Action::Bottom; ++Face)
+	{
+		SensorMask CW = GetRotationSensors(Face);
+		SensorMask FaceSensors = g_SensorsOn & (CW | GetRotationSensors(Face + Rotation::CCW));
+		for (uint8_t RowIdx = 0; RowIdx < NumSwipeRows; ++RowIdx)
 		{
-			uint8_t SensorIndex = pgm_read_byte(f_SensorIndices++);
-			if (g_SensorCounters[SensorIndex] < CounterThreshold)
-				break;
+			SensorMask Row  = pgm_read_dword(&f_SwipeRows[Face][RowIdx]);
+			SensorMask Last = g_SensorsRising & Row;
+			if (FaceSensors != Row || Last == 0 || Last == Row)
+				continue;
+			g_SwipeRotation = ((Last & CW) != 0 ? Face : Face + Action::CCW);
+			g_SwipeRow      = RowIdx;
+			g_SwipeReads    = GetHoldCount(Row & ~Last);
+			return Action::None;
 		}
-		if (i == NumSensorsPerUndo)
+	}
+	return Action::None;
+}
+
+// Restart the hold counters of the given sensors from 0.
+void RestartHoldCounters(SensorMask Sensors)
+{
+	g_SensorsHeld &= ~Sensors;
+	for (uint8_t ByteIdx = 0; ByteIdx < Controls::NumSensorBytes; ++ByteIdx, Sensors >>= 8)
+		for (uint8_t BitIdx = 0; BitIdx < NumHoldBits; ++BitIdx)
+			g_HoldPlanes[BitIdx][ByteIdx] &= ~uint8_t(Sensors);
+}
+
+// Returns true if the given action is being performed or is pending.
+bool IsActionUnderway(Action::Type CurAction)
+{
+	if (CurAction == g_ActiveAction)
+		return true;
+	for (uint8_t PendingIdx = 0; PendingIdx < g_NumPendingActions; ++PendingIdx)
+		if (g_PendingActions[(g_FirstPendingAction + PendingIdx) & (PendingQueueSize - 1)] == CurAction)
+			return true;
+	return false;
+}
+
+// Go through all sensor combinations that perform an undo. If any of them
+// is included in the given sensors, return Action::Undo.
+Action::Type DetectUndo(SensorMask Sensors)
+{
+	for (uint8_t VertexIdx = 0; VertexIdx < Cube::NumVertices; ++VertexIdx)
+	{
+		SensorMask Mask = pgm_read_dword(&f_UndoMasks[VertexIdx]);
+		if ((Sensors & Mask) == Mask)
 			return Action::Undo;
 	}
 	
@@ -193,26 +358,14 @@ Action::Type DetectUndo(int8_t CounterThreshold)
 }
 
 // Go through all sensor combinations that perform a reset. If any of them
-// reach the given threshold, return the reset action. Note: each counter value
-// represents the time for one successful sensor read, which takes about 25 ms.
-Action::Type DetectReset(int8_t CounterThreshold)
+// is included in the given sensors, return the reset action.
+Action::Type DetectReset(SensorMask Sensors)
 {
-	assert(CounterThreshold > 0);
-	
 	for (uint8_t ResetIdx = 0; ResetIdx < NumResetOps; ++ResetIdx)
 	{
-		const uint8_t* f_SensorIndices = f_SensorsPerReset[ResetIdx];
-		uint8_t i = 0;
-		for (; i < NumSensorsPerReset; ++i)
-		{
-			uint8_t SensorIndex = pgm_read_byte(f_SensorIndices++);
-			if (g_SensorCounters[SensorIndex] < CounterThreshold)
-				break;
-		}
-		if (i == NumSensorsPerReset)
-		{
-			return (ResetIdx == 0 ? Action::Reset : Action::Scramble);
-		}
+		SensorMask Mask = pgm_read_dword(&f_ResetMasks[ResetIdx]);
+		if ((Sensors & Mask) == Mask)
+			return pgm_read_byte(&f_ResetActions[ResetIdx]);
 	}
 	
 	return Action::None;
@@ -226,38 +379,61 @@ namespace Controls
 // Set all sensor counters to 0 and reset undo actions.
 void ResetSensors()
 {
-	for (uint8_t SensorIdx = 0; SensorIdx < NumSensors; ++SensorIdx)
-		g_SensorCounters[SensorIdx] = 0;
+	for (uint8_t BitIdx = 0; BitIdx < NumHoldBits; ++BitIdx)
+		for (uint8_t ByteIdx = 0; ByteIdx < NumSensorBytes; ++ByteIdx)
+			g_HoldPlanes[BitIdx][ByteIdx] = 0;
+	g_SensorsOn     = 0;
+	g_SensorsHeld   = 0;
+	g_SensorsRising = 0;
+	g_SwipeRotation = Rotation::None;
 }
 
 // Empty the action queue.
 void ResetActionQueue()
 {
-	for (uint8_t QueueIdx = 0; QueueIdx < ActionQueueSize; ++QueueIdx)
-		g_ActionQueue[QueueIdx] = Rotation::None;
+	g_ActionQueueLength = 0;
 }
 
-// Increment (or reset) counter of specified sensor according to SensorIsOn
-void UpdateCounter(uint8_t SensorIdx, bool SensorIsOn)
+// Empty the pending action queue.
+void ResetPendingActions()
 {
-	assert(SensorIdx < NumSensors);
-	int8_t OldValue = g_SensorCounters[SensorIdx];
-	int8_t NewValue = OldValue;
-	if (SensorIsOn)
-	{
-		if (OldValue <= 0)
-			NewValue = 1;
-		else if (OldValue < 127)
-			NewValue = OldValue + 1;
-	}
-	else
+	g_NumPendingActions = 0;
+}
+
+// Update the hold counters of all sensors from the sensors ON during the
+// last Read(), given as a bit mask (bit i%8 of byte i/8 for sensor i): the
+// counters of the sensors ON count up to DetectionThreshold, the others
+// restart from 0.
+void UpdateSensors(const uint8_t* pSensorsOn)
+{
+	// The masks are built from their most significant byte.
+	SensorMask PrevHeld    = g_SensorsHeld;
+	SensorMask SensorsOn   = 0;
+	SensorMask SensorsHeld = 0;
+	for (uint8_t ByteIdx = NumSensorBytes; ByteIdx-- > 0; )
 	{
-		if (OldValue >= 0)
-			NewValue = -1;
-		else if (OldValue > -128)
-			NewValue = OldValue - 1;
+		uint8_t On = pSensorsOn[ByteIdx];
+
+		// Add 1 to the counters of the sensors ON that were not held yet,
+		// propagating the carry from one bit plane to the next.
+		uint8_t Carry = On & ~uint8_t(PrevHeld >> (8 * (NumSensorBytes - 1)));
+		PrevHeld <<= 8;
+		uint8_t Held = On;
+		for (uint8_t BitIdx = 0; BitIdx < NumHoldBits; ++BitIdx)
+		{
+			uint8_t Plane = g_HoldPlanes[BitIdx][ByteIdx] & On;
+			uint8_t NewPlane = Plane ^ Carry;
+			Carry &= Plane;
+			g_HoldPlanes[BitIdx][ByteIdx] = NewPlane;
+			Held &= ((DetectionThreshold >> BitIdx) & 1) ? NewPlane : uint8_t(~NewPlane);
+		}
+
+		SensorsOn   = (SensorsOn   << 8) | On;
+		SensorsHeld = (SensorsHeld << 8) | Held;
 	}
-	g_SensorCounters[SensorIdx] = NewValue;
+	g_SensorsRising = SensorsOn & ~g_SensorsOn;
+	g_SensorsOn     = SensorsOn;
+	g_SensorsHeld   = SensorsHeld;
 }
 
 // Set the brightness of every facelet according to the sensors currently ON
@@ -265,18 +441,18 @@ void UpdateCounter(uint8_t SensorIdx, bool SensorIsOn)
 // changed, indicating a LEDs refresh is needed.
 bool UpdateCubeBrightness()
 {
-	// Copy current facelets to determine later if any facelet has changed.
-	Facelet::Type OldFacelets[Cube::NumFacelets];
-	const Facelet::Type* const pFacelets = Cube::GetFacelets();
-	for (uint8_t FaceletIdx = 0; FaceletIdx < Cube::NumFacelets; ++FaceletIdx)
-		OldFacelets[FaceletIdx] = pFacelets[FaceletIdx];
+	// Copy current brightness to determine later if any facelet has changed.
+	uint8_t OldBrightness[Cube::NumBrightnessBytes];
+	const uint8_t* const pBrightness = Cube::GetBrightness();
+	for (uint8_t i = 0; i < Cube::NumBrightnessBytes; ++i)
+		OldBrightness[i] = pBrightness[i];
 
 	Cube::DimAll();
 
 	// Brighten all facelets whose sensor is currently ON.
 	for (uint8_t SensorIdx = 0; SensorIdx < NumSensors; ++SensorIdx)
 	{
-		if (g_SensorCounters[SensorIdx] > 0)
+		if ((g_SensorsOn & SENSOR_BIT(SensorIdx)) != 0)
 		{
 			Facelet::Type FaceletIdx = pgm_read_byte(&f_SensorToFacelet[SensorIdx]);
 			Cube::BrightenFacelet(FaceletIdx);
@@ -286,13 +462,15 @@ bool UpdateCubeBrightness()
 	// Check if there is an active rotation with a very low threshold.
 	// This allows to see the corresponding face brighten for a while
 	// before the rotation, while still allowing to cancel the movement.
-	Action::Type Rot = DetectRotation(1);
+	Action::Type Rot = DetectRotation(g_SensorsOn);
 	if (Rotation::IsRotation(Rot))
 		Cube::BrightenFace(Rot);
+	else
+		Hint::Show();
 
 	// Determine if any facelet brightness has changed.
-	for (uint8_t FaceletIdx = 0; FaceletIdx < Cube::NumFacelets; ++FaceletIdx)
-		if (OldFacelets[FaceletIdx] != pFacelets[FaceletIdx])
+	for (uint8_t i = 0; i < Cube::NumBrightnessBytes; ++i)
+		if (OldBrightness[i] != pBrightness[i])
 			return true;
 	return false;
 }
@@ -300,43 +478,113 @@ bool UpdateCubeBrightness()
 // Returns the current action to perform according to the sensors state.
 Action::Type DetermineAction()
 {
-	Action::Type CurAction = DetectReset(DetectionThreshold);
-	if (CurAction != Action::None)
-		return CurAction;
+	// Gestures held in place are detected after DetectionThreshold reads.
+	Action::Type CurAction = DetectReset(g_SensorsHeld);
+	if (CurAction == Action::None)
+		CurAction = DetectUndo(g_SensorsHeld);
 
-	CurAction = DetectUndo(DetectionThreshold);
-	if (CurAction != Action::None)
-		return CurAction;
+	// Swipes are detected as soon as the finger leaves the first sensor.
+	if (CurAction == Action::None)
+	{
+		CurAction = DetectSwipe();
+		if (CurAction != Action::None)
+			return CurAction;
+	}
 
 	// The first call ensures there is only one active rotation, whatever
 	// the threshold. The second call ensures the rotation is above the
 	// detection threshold.
-	CurAction = DetectRotation(1);
-	if (CurAction != Action::None)
-		return DetectRotation(DetectionThreshold);
+	if (CurAction == Action::None && DetectRotation(g_SensorsOn) != Action::None)
+		CurAction = DetectRotation(g_SensorsHeld);
 
-	return Action::None;
+	if (CurAction == Action::None)
+		return Action::None;
+
+	// A gesture held while its action is underway waits for it to end.
+	if (IsActionUnderway(CurAction))
+	{
+		RestartHoldCounters(g_SensorsHeld);
+		return Action::None;
+	}
+	g_ActionLatency = DetectionThreshold;
+	return CurAction;
+}
+
+// Set the action being performed, or Action::None once it is done.
+void SetActiveAction(Action::Type CurAction)
+{
+	g_ActiveAction = CurAction;
 }
 
-// Added the given rotation to the front of the queue.
+// Number of reads (about 25 ms each) between the first touch of the last
+// detected action and its detection.
+uint8_t GetActionLatency()
+{
+	return g_ActionLatency;
+}
+
+// Add the given move to the queue. It may merge with or cancel the most
+// recent moves.
 void PushAction(Rotation::Type Rot)
 {
-	assert(Rotation::IsRotation(Rot));
-	for (uint8_t QueueIdx = ActionQueueSize-1; QueueIdx > 0; --QueueIdx)
-		g_ActionQueue[QueueIdx] = g_ActionQueue[QueueIdx - 1];
-	g_ActionQueue[0] = Rot;
+	assert(Rotation::IsMove(Rot));
+	g_ActionQueueLength = Sequence::Append(g_ActionQueue, g_ActionQueueLength, Rot);
+	if (g_ActionQueueLength > ActionQueueSize)
+	{
+		// Forget the oldest rotation.
+		for (uint8_t QueueIdx = 0; QueueIdx < ActionQueueSize; ++QueueIdx)
+			g_ActionQueue[QueueIdx] = g_ActionQueue[QueueIdx + 1];
+		g_ActionQueueLength = ActionQueueSize;
+	}
 }
 
-// Remove the rotation at the front of the queue. If the queue is empty, returns Rotation::None.
+// Remove the most recent rotation of the queue. If the queue is empty, returns Rotation::None.
 Rotation::Type PopAction()
 {
-	// Since the queue is always filled with Rotation::None, we don't need
-	// a special case to detect an empty queue.
-	Rotation::Type Rot = g_ActionQueue[0];
-	for (uint8_t QueueIdx = 0; QueueIdx < ActionQueueSize-1; ++QueueIdx)
-		g_ActionQueue[QueueIdx] = g_ActionQueue[QueueIdx + 1];
-	g_ActionQueue[ActionQueueSize-1] = Rotation::None;
-	return Rot;
+	if (g_ActionQueueLength == 0)
+		return Rotation::None;
+	return g_ActionQueue[--g_ActionQueueLength];
+}
+
+// Add an action to perform after the current animation. Returns false, and
+// drops the action, if the pending action queue is full.
+bool PushPendingAction(Action::Type CurAction)
+{
+	if (g_NumPendingActions == PendingQueueSize)
+		return false;
+	g_PendingActions[(g_FirstPendingAction + g_NumPendingActions) & (PendingQueueSize - 1)] = CurAction;
+	++g_NumPendingActions;
+	return true;
+}
+
+// Remove the oldest pending action. If there is none, returns Action::None.
+Action::Type PopPendingAction()
+{
+	if (g_NumPendingActions == 0)
+		return Action::None;
+	Action::Type CurAction = g_PendingActions[g_FirstPendingAction];
+	g_FirstPendingAction = (g_FirstPendingAction + 1) & (PendingQueueSize - 1);
+	--g_NumPendingActions;
+	return CurAction;
+}
+
+// Oldest pending action, left in the queue. If there is none, returns
+// Action::None.
+Action::Type PeekPendingAction()
+{
+	return (g_NumPendingActions == 0 ? Action::None : g_PendingActions[g_FirstPendingAction]);
+}
+
+// Number of actions waiting for the current animation to end.
+uint8_t GetNumPendingActions()
+{
+	return g_NumPendingActions;
+}
+
+// Number of times the animation delays are halved, given the pending actions.
+uint8_t GetAnimationSpeedUp()
+{
+	return (g_NumPendingActions < MaxAnimationSpeedUp ? g_NumPendingActions : MaxAnimationSpeedUp);
 }
 
 }
@@ -10,24 +10,49 @@ using namespace Rotation;
 const Type Reset    = 254;
 const Type Scramble = 253;
 const Type Undo     = 252;
+const Type Hint     = 251;
 }
 
 namespace Controls
 {
 const uint8_t NumSensors = 24;	// Number of facelets used as sensors.
+const uint8_t NumSensorBytes = (NumSensors + 7) / 8;	// Size of a sensor mask, one bit per sensor.
 
 void ResetSensors();		// Set all sensor counters to 0.
 void ResetActionQueue();	// Empty the action queue.
-void UpdateCounter(uint8_t SensorIdx, bool SensorIsOn);	// Increment (or reset) counter of specified sensor according to SensorIsOn
+void ResetPendingActions();	// Empty the pending action queue.
+void UpdateSensors(const uint8_t* pSensorsOn);	// Count how long each sensor has been ON, given the sensors ON during the last read (bit i%8 of byte i/8 for sensor i).
 
 // Set the brightness of every facelet according to the sensors currently ON
 // and the rotation that is about to happen.
 bool UpdateCubeBrightness();
 
 // Returns the current action to perform according to the sensors state.
+// Rotations are performed by holding two opposite sensors around a face,
+// or, faster, by swiping a finger from one corner to the other of a row.
+// A gesture held in place is not detected again while its action is being
+// performed (see SetActiveAction()) or is pending: it repeats afterwards.
 Action::Type DetermineAction();
+void SetActiveAction(Action::Type CurAction);	// Set the action being performed, or Action::None once it is done.
+
+// Number of reads (about 25 ms each) between the first touch of the last
+// detected action and its detection: DetectionThreshold for the gestures
+// held in place, a few reads for the swipes.
+uint8_t GetActionLatency();
 
 // Manage the action queue for undo operations.
 void PushAction(Rotation::Type Rot);
 Rotation::Type PopAction();
+
+// Queue of the actions detected while an animation is running, performed in
+// order as the animations end (at most 4; the newest ones are dropped).
+bool PushPendingAction(Action::Type CurAction);
+Action::Type PopPendingAction();
+Action::Type PeekPendingAction();
+uint8_t GetNumPendingActions();
+
+// The animation delays are divided by 2 to the power of this value: once
+// for each pending action, up to MaxAnimationSpeedUp times.
+const uint8_t MaxAnimationSpeedUp = 2;
+uint8_t GetAnimationSpeedUp();
 }
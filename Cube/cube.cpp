@@ -1,5 +1,6 @@
 #include "cube.h"
 #include "config.h"
+#include "layout.h"
 #include "rand8.h"
 
 STATIC_ASSERT(Facelet::Bright == 8, "This constant must be bitwise-exclusive with the others.");
@@ -62,52 +63,135 @@ const SColor Colors[15] =
 // Unnamed namespace for internal details.
 namespace 
 {
-Facelet::Type g_Facelets[Cube::NumFacelets]; // Global cube state.
+Cube::SState g_Cube; // Default cube state, used by the free functions of namespace Cube.
 
 #if DEBUG_CODE
 const uint8_t NumBackupFacelets = 9;
 Facelet::Type g_BackupFacelets[NumBackupFacelets]; // Backup of the cube state for debug display.
 #endif
 
-const uint8_t NumSideFacelets     = 12; // Number of facelets on the side of a turning face.
-const uint8_t NumFrontFacelets    =  8; // Number of facelets on the front of a turning face, excluding the center.
-const uint8_t NumAffectedFacelets = NumSideFacelets + NumFrontFacelets + 1; // Number of facelets of a face.
+const uint8_t NumAffectedFacelets = Cube::NumSideFacelets + Cube::NumFrontFacelets + 1; // Number of facelets of a face.
 
 typedef uint8_t FaceletIndex;
 
 // Static data structure containing all affected facelets for a single rotation.
 struct SRotation
 {
-	FaceletIndex Side[NumSideFacelets];	// indices of facelets on the side of the turning face.
-	FaceletIndex Front[NumFrontFacelets];	// indices of facelets on the front of the turning face, excluding the center.
+	FaceletIndex Side[Cube::NumSideFacelets];	// indices of facelets on the side of the turning face.
+	FaceletIndex Front[Cube::NumFrontFacelets];	// indices of facelets on the front of the turning face, excluding the center.
 	FaceletIndex Fixed;			// index of the center facelet of the turning face.
 	// contains a total of NumAffectedFacelets facelets.
 };
 
 // These are in the same order as namespace Rotation.
 // This is stored in flash memory and must be accessed using pgm_read_byte().
-#ifdef USE_SIMULATOR
 const SRotation f_Rot[Cube::NumFaces] PROGMEM =
 {
-	{{ 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42}, { 2,  5,  8,  7,  6,  3,  0,  1},  4},	// top
-	{{45, 48, 51, 20, 19, 18,  8,  5,  2, 42, 43, 44}, {11, 14, 17, 16, 15, 12,  9, 10}, 13},	// front
-	{{51, 52, 53, 29, 28, 27,  6,  7,  8, 15, 16, 17}, {20, 23, 26, 25, 24, 21, 18, 19}, 22},	// right
-	{{53, 50, 47, 38, 37, 36,  0,  3,  6, 24, 25, 26}, {29, 32, 35, 34, 33, 30, 27, 28}, 31},	// back
-	{{47, 46, 45, 11, 10,  9,  2,  1,  0, 33, 34, 35}, {38, 41, 44, 43, 42, 39, 36, 37}, 40},	// left
-	{{35, 32, 29, 26, 23, 20, 17, 14, 11, 44, 41, 38}, {47, 50, 53, 52, 51, 48, 45, 46}, 49}	// bottom
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_TOP),		// top
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_FRONT),	// front
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_RIGHT),	// right
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_BACK),	// back
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_LEFT),	// left
+	LAYOUT_ROTATION_INITIALIZER(LAYOUT_NATIVE_BOTTOM)	// bottom
+};
+
+// Brightness mask of the facelets affected by each rotation, in the same
+// order as f_Rot. This is stored in flash memory and must be accessed using
+// pgm_read_byte().
+const uint8_t f_FaceBrightness[Cube::NumFaces][Cube::NumBrightnessBytes] PROGMEM =
+{
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_TOP),		// top
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_FRONT),		// front
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_RIGHT),		// right
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_BACK),		// back
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_LEFT),		// left
+	LAYOUT_MASK_INITIALIZER(LAYOUT_NATIVE_BOTTOM)		// bottom
+};
+
+#ifdef USE_SIMULATOR
+
+// Side facelets of each middle slice, in the order of namespace Rotation
+// from Rotation::Middle. This is stored in flash memory and must be accessed
+// using pgm_read_byte().
+const FaceletIndex f_SliceSide[Cube::NumFaces / 2][Cube::NumSideFacelets] PROGMEM =
+{
+	LAYOUT_SLICE_INITIALIZER(LAYOUT_NATIVE_MIDDLE),		// middle
+	LAYOUT_SLICE_INITIALIZER(LAYOUT_NATIVE_EQUATOR),	// equator
+	LAYOUT_SLICE_INITIALIZER(LAYOUT_NATIVE_STANDING)	// standing
+};
+
+#endif
+
+// Layers are the faces, in the same order as f_Rot, then the slices, in the
+// same order as f_SliceSide.
+const uint8_t FirstSliceLayer = Cube::NumFaces;
+const uint8_t ReversedLayer   = 0x80;	// additive, the layer turns the other way
+const uint8_t NoLayer         = 0xFF;
+
+#ifdef USE_SIMULATOR
+
+// Layers turned by the moves other than rotations, in the order of namespace
+// Rotation from Rotation::Middle, each ending with NoLayer if it has fewer
+// than Cube::MaxLayersPerMove layers. A rotation turns its face only.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const uint8_t f_MoveLayers[Cube::NumFaces][Cube::MaxLayersPerMove] PROGMEM =
+{
+	{FirstSliceLayer + 0, NoLayer, NoLayer},	// M
+	{FirstSliceLayer + 1, NoLayer, NoLayer},	// E
+	{FirstSliceLayer + 2, NoLayer, NoLayer},	// S
+	{Rotation::Right, FirstSliceLayer + 0 + ReversedLayer, Rotation::Left   + ReversedLayer},	// x = R M' L'
+	{Rotation::Top,   FirstSliceLayer + 1 + ReversedLayer, Rotation::Bottom + ReversedLayer},	// y = U E' D'
+	{Rotation::Front, FirstSliceLayer + 2,                 Rotation::Back   + ReversedLayer}	// z = F S B'
+};
+
+#endif
+
+// Center facelet of each block of 9 facelets, in LED order, and of each
+// facelet (the center of its block).
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+#define BLOCK_CENTER(C)	C, C, C, C, C, C, C, C, C
+#ifdef USE_SIMULATOR
+const FaceletIndex f_BlockCenters[Cube::NumFaces] PROGMEM = { 4, 13, 22, 31, 40, 49 };
+const FaceletIndex f_FaceletCenters[Cube::NumFacelets] PROGMEM =
+{
+	BLOCK_CENTER(4), BLOCK_CENTER(13), BLOCK_CENTER(22), BLOCK_CENTER(31), BLOCK_CENTER(40), BLOCK_CENTER(49)
 };
 #else
-const SRotation f_Rot[Cube::NumFaces] PROGMEM =
+const FaceletIndex f_BlockCenters[Cube::NumFaces] PROGMEM = { 2, 11, 22, 29, 38, 49 };
+const FaceletIndex f_FaceletCenters[Cube::NumFacelets] PROGMEM =
 {
-	{{ 6,  7,  8,  9, 12, 13, 33, 34, 35, 36, 39, 40}, {47, 48, 53, 52, 51, 50, 45, 46}, 49},	// top
-	{{24, 23, 18, 17, 10,  9, 53, 48, 47, 40, 41, 42}, { 4,  3,  0,  1,  8,  7,  6,  5},  2},	// front
-	{{18, 19, 20, 31, 32, 33, 51, 52, 53,  8,  1,  0}, {17, 16, 15, 14, 13, 12,  9, 10}, 11},	// right
-	{{20, 21, 26, 44, 37, 36, 45, 50, 51, 13, 14, 15}, {31, 30, 27, 28, 35, 34, 33, 32}, 29},	// back
-	{{26, 25, 24,  4,  5,  6, 47, 46, 45, 35, 28, 27}, {44, 43, 42, 41, 40, 39, 36, 37}, 38},	// left
-	{{27, 30, 31, 15, 16, 17,  0,  3,  4, 42, 43, 44}, {26, 21, 20, 19, 18, 23, 24, 25}, 22}	// bottom
+	BLOCK_CENTER(2), BLOCK_CENTER(11), BLOCK_CENTER(22), BLOCK_CENTER(29), BLOCK_CENTER(38), BLOCK_CENTER(49)
 };
 #endif
 
+// Value of the last byte of the brightness mask when all facelets are bright.
+const uint8_t LastBrightnessByte = (1 << (Cube::NumFacelets % 8)) - 1;
+
+// Value of SState::m_NumMisplaced when it must be recomputed.
+const uint8_t UnknownNumMisplaced = 0xFF;
+
+#ifdef USE_SIMULATOR
+
+// Straight-line code of each rotation for Cube::SState::Apply(), generated from
+// the lists of layout.h. A clockwise rotation moves the side facelets by 3
+// positions and the front facelets by 2 positions, i.e. 5 cycles of 4 facelets.
+#define CYCLE_FACELETS(A, B, C, D) \
+	{ Facelet::Type T = pFacelets[A]; pFacelets[A] = pFacelets[B]; pFacelets[B] = pFacelets[C]; pFacelets[C] = pFacelets[D]; pFacelets[D] = T; }
+#define APPLY_CW(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C) \
+	CYCLE_FACELETS(S0, S3, S6, S9) CYCLE_FACELETS(S1, S4, S7, S10) CYCLE_FACELETS(S2, S5, S8, S11) \
+	CYCLE_FACELETS(F0, F2, F4, F6) CYCLE_FACELETS(F1, F3, F5, F7)
+#define APPLY_CCW(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C) \
+	CYCLE_FACELETS(S0, S9, S6, S3) CYCLE_FACELETS(S1, S10, S7, S4) CYCLE_FACELETS(S2, S11, S8, S5) \
+	CYCLE_FACELETS(F0, F6, F4, F2) CYCLE_FACELETS(F1, F7, F5, F3)
+
+// Same for the slices, which only have side facelets.
+#define APPLY_SLICE_CW(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11) \
+	CYCLE_FACELETS(S0, S3, S6, S9) CYCLE_FACELETS(S1, S4, S7, S10) CYCLE_FACELETS(S2, S5, S8, S11)
+#define APPLY_SLICE_CCW(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11) \
+	CYCLE_FACELETS(S0, S9, S6, S3) CYCLE_FACELETS(S1, S10, S7, S4) CYCLE_FACELETS(S2, S11, S8, S5)
+
+#endif
+
 #if DEBUG_CODE
 #ifdef USE_SIMULATOR
 const FaceletIndex g_DebugIndexes[NumBackupFacelets] = {17, 14, 11, 16, 13, 10, 15, 12, 9};
@@ -123,114 +207,205 @@ const FaceletIndex g_DebugIndexes[NumBackupFacelets] = {0, 3, 4, 1, 2, 5, 8, 7,
 #define VICTORY_ANIMATION_DELAY_MS		400
 #define NUM_VICTORY_ANIMATION_ITER		15
 
-#define ROTATION_ANIMATION_VERSION		2
+// Can be overridden by the build (e.g. to benchmark every version).
+#ifndef ROTATION_ANIMATION_VERSION
+	#define ROTATION_ANIMATION_VERSION	2
+#endif
+
+uint16_t DoRotation(Cube::SState& State);
+uint16_t DoVictory(Cube::SState& State);
+
+uint16_t EndAnim(Cube::SState& State);
+
+// Returns true if a facelet of the given color is misplaced on a face whose
+// center has the color SolvedColor. Black facelets are always misplaced.
+bool IsMisplaced(Facelet::Type Color, Facelet::Type SolvedColor)
+{
+	return Color != SolvedColor || Color == Facelet::Black;
+}
+
+// Returns the number of facelets whose color differs from the center of
+// their face.
+uint8_t CountMisplaced(const Facelet::Type* pFacelets)
+{
+	uint8_t NumMisplaced = 0;
+	const Facelet::Type* pFacelet = pFacelets;
+	for (uint8_t Block = 0; Block < Cube::NumFaces; ++Block)
+	{
+		// A face whose center is black is fully misplaced (see IsMisplaced()).
+		Facelet::Type SolvedColor = pFacelets[pgm_read_byte(&f_BlockCenters[Block])];
+		if (SolvedColor == Facelet::Black)
+			NumMisplaced += Cube::NumFaceletsPerFace;
+		else
+			for (uint8_t i = 0; i < Cube::NumFaceletsPerFace; ++i)
+				NumMisplaced += (pFacelet[i] != SolvedColor);
+		pFacelet += Cube::NumFaceletsPerFace;
+	}
+	return NumMisplaced;
+}
 
-typedef uint16_t (*AnimFuncType)();
+// Change of the number of misplaced facelets made by a rotation, from the
+// facelets before it. Only its 12 side facelets can change status: the front
+// ones stay on the turning face, whose center does not move.
+int8_t GetRotationDelta(const Facelet::Type* pFacelets, Rotation::Type Rot)
+{
+	const FaceletIndex* f_Indices = &f_Rot[Rotation::GetFace(Rot)].Side[0];
+	// A clockwise rotation moves the side facelets by 3 positions.
+	uint8_t SrcIdx = (Rot < Rotation::CCW ? 3 : Cube::NumSideFacelets - 3);
+	int8_t Delta = 0;
+	for (uint8_t i = 0; i < Cube::NumSideFacelets; ++i)
+	{
+		FaceletIndex Index = pgm_read_byte(&f_Indices[i]);
+		Facelet::Type SolvedColor = pFacelets[pgm_read_byte(&f_FaceletCenters[Index])];
+		Delta -= IsMisplaced(pFacelets[Index], SolvedColor);
+		Delta += IsMisplaced(pFacelets[pgm_read_byte(&f_Indices[SrcIdx])], SolvedColor);
+		if (++SrcIdx == Cube::NumSideFacelets)
+			SrcIdx = 0;
+	}
+	return Delta;
+}
 
-uint16_t NoAnim();
+#ifndef USE_SIMULATOR
 
-uint16_t DoRotation();
-uint16_t DoVictory();
+// Cycles 4 facelets, Step positions apart in the given list of f_Rot: each
+// takes the color of the next one (of the previous one if CCW).
+void CycleFacelets(Facelet::Type* pFacelets, const FaceletIndex* f_Indices, uint8_t Step, bool CCW)
+{
+	FaceletIndex Indexes[4];
+	for (uint8_t i = 0; i < 4; ++i)
+		Indexes[CCW ? (4 - i) & 3 : i] = pgm_read_byte(&f_Indices[i * Step]);
+	Facelet::Type First = pFacelets[Indexes[0]];
+	for (uint8_t i = 0; i < 3; ++i)
+		pFacelets[Indexes[i]] = pFacelets[Indexes[i + 1]];
+	pFacelets[Indexes[3]] = First;
+}
 
-uint16_t EndAnim();
+#endif
 
-AnimFuncType   g_AnimFunc = &NoAnim;
-uint8_t        g_AnimStepIdx;
-Rotation::Type g_AnimRotationFace;
+// Returns the bit of the given facelet within its byte of the brightness mask.
+uint8_t GetBrightnessBit(FaceletIndex Index)
+{
+	return 1 << (Index & 7);
+}
 
-uint16_t NoAnim()
+uint16_t NoAnim(Cube::SState&)
 {
 	return 0;
 }
 
+// Layer LayerIdx turned by a move, possibly with ReversedLayer, or NoLayer.
+uint8_t GetLayer(Rotation::Type Move, uint8_t LayerIdx)
+{
+	assert(LayerIdx < Cube::MaxLayersPerMove);
+	Move = Rotation::GetClockwise(Move);
+#ifdef USE_SIMULATOR
+	if (Move >= Rotation::NumRotations)
+		return pgm_read_byte(&f_MoveLayers[Move - Rotation::NumRotations][LayerIdx]);
+#endif
+	return (LayerIdx == 0 ? Move : NoLayer);
+}
+
+// Returns true if a layer (without ReversedLayer) is a face rather than a
+// middle slice. The firmware only turns faces (see Cube::MaxLayersPerMove).
+bool IsFaceLayer(uint8_t Layer)
+{
+#ifdef USE_SIMULATOR
+	return Layer < FirstSliceLayer;
+#else
+	(void)Layer;
+	return true;
+#endif
+}
+
+// Returns true if a layer of a move (see GetLayer()) turns counter-clockwise.
+bool IsLayerCCW(Rotation::Type Move, uint8_t Layer)
+{
+	return (Rotation::GetClockwise(Move) != Move) != ((Layer & ReversedLayer) != 0);
+}
+
+// Side facelets of a layer (without ReversedLayer), in flash memory.
+const FaceletIndex* GetSideFacelets(uint8_t Layer)
+{
+	assert(Layer < FirstSliceLayer + Cube::NumFaces / 2);
+#ifdef USE_SIMULATOR
+	if (!IsFaceLayer(Layer))
+		return &f_SliceSide[Layer - FirstSliceLayer][0];
+#endif
+	return &f_Rot[Layer].Side[0];
+}
+
 #if ROTATION_ANIMATION_VERSION == 1
 
 #define ROTATION_DELAY_MS			200
 
 // Swap the facelets of the cube in clockwise order.
-void RotateCW(const FaceletIndex* f_Indices, uint8_t NumFacelets)
+void RotateCW(Cube::SState& State, const FaceletIndex* f_Indices, uint8_t NumFacelets)
 {
 	assert(f_Indices != 0);
-	assert(NumFacelets == NumSideFacelets || NumFacelets == NumFrontFacelets);
+	assert(NumFacelets == Cube::NumSideFacelets || NumFacelets == Cube::NumFrontFacelets);
 
 	FaceletIndex CurIndex = pgm_read_byte(f_Indices++);
-	Facelet::Type Temp = g_Facelets[CurIndex];
+	Facelet::Type Temp = State.m_Facelets[CurIndex];
 
 	uint8_t Count = NumFacelets - 1;
 	do
 	{
 		FaceletIndex NextIndex = pgm_read_byte(f_Indices++);
-		g_Facelets[CurIndex] = g_Facelets[NextIndex];
+		State.m_Facelets[CurIndex] = State.m_Facelets[NextIndex];
 		CurIndex = NextIndex;
 	} while (--Count);
 
-	g_Facelets[CurIndex] = Temp;
+	State.m_Facelets[CurIndex] = Temp;
 }
 
 // Swap the facelets of the cube in counter-clockwise order.
-void RotateCCW(const FaceletIndex* f_Indices, uint8_t NumFacelets)
+void RotateCCW(Cube::SState& State, const FaceletIndex* f_Indices, uint8_t NumFacelets)
 {
 	assert(f_Indices != 0);
-	assert(NumFacelets == NumSideFacelets || NumFacelets == NumFrontFacelets);
+	assert(NumFacelets == Cube::NumSideFacelets || NumFacelets == Cube::NumFrontFacelets);
 
 	f_Indices += NumFacelets;
 	FaceletIndex CurIndex = pgm_read_byte(--f_Indices);
-	Facelet::Type Temp = g_Facelets[CurIndex];
+	Facelet::Type Temp = State.m_Facelets[CurIndex];
 
 	uint8_t Count = NumFacelets - 1;
 	do
 	{
 		FaceletIndex NextIndex = pgm_read_byte(--f_Indices);
-		g_Facelets[CurIndex] = g_Facelets[NextIndex];
+		State.m_Facelets[CurIndex] = State.m_Facelets[NextIndex];
 		CurIndex = NextIndex;
 	} while (--Count);
 
-	g_Facelets[CurIndex] = Temp;
-}
-
-// Move facelets on the side of a face, one step, according to a given rotation.
-void RotateSide(Rotation::Type Face)
-{
-	assert(Face < 2 * Rotation::CCW);
-
-	if (Face >= Rotation::CCW)
-	{
-		Face -= Rotation::CCW;
-		const FaceletIndex* f_Indices = &f_Rot[Face].Side[0];
-		RotateCCW(f_Indices, NumSideFacelets);
-	}
-	else
-	{
-		const FaceletIndex* f_Indices = &f_Rot[Face].Side[0];
-		RotateCW(f_Indices, NumSideFacelets);
-	}
+	State.m_Facelets[CurIndex] = Temp;
 }
 
-// Move facelets on the front of a face, one step, according to a given rotation.
-void RotateFront(Rotation::Type Face)
+// Move the facelets of each layer of the animated move one step: the side
+// ones at each step, the front ones of the faces at the first and last steps.
+uint16_t DoRotation(Cube::SState& State)
 {
-	assert(Face < 2 * Rotation::CCW);
-
-	if (Face >= Rotation::CCW)
-	{
-		Face -= Rotation::CCW;
-		const FaceletIndex* f_Indices = &f_Rot[Face].Front[0];
-		RotateCCW(f_Indices, NumFrontFacelets);
-	}
-	else
+	for (uint8_t LayerIdx = 0; LayerIdx < Cube::MaxLayersPerMove; ++LayerIdx)
 	{
-		const FaceletIndex* f_Indices = &f_Rot[Face].Front[0];
-		RotateCW(f_Indices, NumFrontFacelets);
+		uint8_t Layer = GetLayer(State.m_AnimRotationFace, LayerIdx);
+		if (Layer == NoLayer)
+			break;
+		bool IsCCW = IsLayerCCW(State.m_AnimRotationFace, Layer);
+		Layer &= ~ReversedLayer;
+
+		if (IsCCW)
+			RotateCCW(State, GetSideFacelets(Layer), Cube::NumSideFacelets);
+		else
+			RotateCW(State, GetSideFacelets(Layer), Cube::NumSideFacelets);
+
+		if (State.m_AnimStepIdx != 1 && IsFaceLayer(Layer))
+		{
+			if (IsCCW)
+				RotateCCW(State, &f_Rot[Layer].Front[0], Cube::NumFrontFacelets);
+			else
+				RotateCW(State, &f_Rot[Layer].Front[0], Cube::NumFrontFacelets);
+		}
 	}
-}
-
-uint16_t DoRotation()
-{
-	RotateSide(g_AnimRotationFace);
-	if (g_AnimStepIdx != 1)
-		RotateFront(g_AnimRotationFace);
-	if (++g_AnimStepIdx == 3)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 3)
+		State.m_AnimFunc = &EndAnim;
 	return ROTATION_DELAY_MS;
 }
 
@@ -238,84 +413,132 @@ uint16_t DoRotation()
 
 #if ROTATION_ANIMATION_VERSION != 1
 
-// Get the rotation index structure according to the face.
-const SRotation& GetRot()
+uint8_t GetSideIdx(bool IsCCW, uint8_t StepIdx)
 {
-	Rotation::Type Face = g_AnimRotationFace;
-	if (Face >= Rotation::CCW)
-		Face -= Rotation::CCW;
-	return f_Rot[Face];
+	uint8_t SideIdx = (IsCCW ? StepIdx : 11 - StepIdx);
+	assert(SideIdx < Cube::NumSideFacelets);
+	return SideIdx;
 }
 
-uint8_t GetSideIdx(uint8_t StepIdx)
+// Front facelet next to each side facelet. A switch would compile to a
+// lookup table in SRAM, this one is in flash.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const uint8_t f_SideIdxToFrontIdx[Cube::NumSideFacelets] PROGMEM =
 {
-	uint8_t SideIdx = (g_AnimRotationFace >= Rotation::CCW ? StepIdx : 11 - StepIdx);
-	assert(SideIdx < NumSideFacelets);
-	return SideIdx;
-}
+	0, 1, 2, 2, 3, 4, 4, 5, 6, 6, 7, 0
+};
 
 uint8_t SideIdxToFrontIdx(uint8_t SideIdx)
 {
-	uint8_t FrontIdx = 0;
-	switch (SideIdx)
-	{
-	case  0: FrontIdx = 0; break;
-	case  1: FrontIdx = 1; break;
-	case  2: FrontIdx = 2; break;
-	case  3: FrontIdx = 2; break;
-	case  4: FrontIdx = 3; break;
-	case  5: FrontIdx = 4; break;
-	case  6: FrontIdx = 4; break;
-	case  7: FrontIdx = 5; break;
-	case  8: FrontIdx = 6; break;
-	case  9: FrontIdx = 6; break;
-	case 10: FrontIdx = 7; break;
-	case 11: FrontIdx = 0; break;
-	}
-	assert(FrontIdx < NumFrontFacelets);
+	assert(SideIdx < Cube::NumSideFacelets);
+	uint8_t FrontIdx = pgm_read_byte(&f_SideIdxToFrontIdx[SideIdx]);
+	assert(FrontIdx < Cube::NumFrontFacelets);
 	return FrontIdx;
 }
 
-uint8_t GetBkpSideIdx(uint8_t SideIdx)
+uint8_t GetBkpSideIdx(bool IsCCW, uint8_t SideIdx)
 {
-	uint8_t BkpIdx = SideIdx + (g_AnimRotationFace >= Rotation::CCW ? 9 : 3); // 9 == - 3 + 12
-	if (BkpIdx >= NumSideFacelets)
-		BkpIdx -= NumSideFacelets;
-	assert(SideIdx < NumSideFacelets);
+	uint8_t BkpIdx = SideIdx + (IsCCW ? 9 : 3); // 9 == - 3 + 12
+	if (BkpIdx >= Cube::NumSideFacelets)
+		BkpIdx -= Cube::NumSideFacelets;
+	assert(SideIdx < Cube::NumSideFacelets);
 	return BkpIdx;
 }
 
-uint8_t GetBkpFrontIdx(uint8_t FrontIdx)
+uint8_t GetBkpFrontIdx(bool IsCCW, uint8_t FrontIdx)
 {
-	uint8_t BkpIdx = FrontIdx + (g_AnimRotationFace >= Rotation::CCW ? 6 : 2); // 6 == - 2 + 8
-	if (BkpIdx >= NumFrontFacelets)
-		BkpIdx -= NumFrontFacelets;
-	assert(FrontIdx < NumFrontFacelets);
+	uint8_t BkpIdx = FrontIdx + (IsCCW ? 6 : 2); // 6 == - 2 + 8
+	if (BkpIdx >= Cube::NumFrontFacelets)
+		BkpIdx -= Cube::NumFrontFacelets;
+	assert(FrontIdx < Cube::NumFrontFacelets);
 	return BkpIdx;
 }
 
-Facelet::Type g_RotBackupSideFacelets[NumSideFacelets];
-Facelet::Type g_RotBackupFrontFacelets[NumFrontFacelets];
-
-void BackupForRotation()
+void BackupForRotation(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
+	uint8_t FaceIdx = 0;
+	for (uint8_t LayerIdx = 0; LayerIdx < Cube::MaxLayersPerMove; ++LayerIdx)
+	{
+		uint8_t Layer = GetLayer(State.m_AnimRotationFace, LayerIdx);
+		if (Layer == NoLayer)
+			break;
+		Layer &= ~ReversedLayer;
+
+		// Backup the side facelets.
+		const FaceletIndex* f_Indices = GetSideFacelets(Layer);
+		for (uint8_t i = 0; i < Cube::NumSideFacelets; ++i)
+		{
+			FaceletIndex Index = pgm_read_byte(f_Indices++);
+			State.m_RotBackupSideFacelets[LayerIdx][i] = State.m_Facelets[Index];
+		}
+
+		// Backup the front facelets of the faces.
+		if (!IsFaceLayer(Layer))
+			continue;
+		f_Indices = &f_Rot[Layer].Front[0];
+		for (uint8_t i = 0; i < Cube::NumFrontFacelets; ++i)
+		{
+			FaceletIndex Index = pgm_read_byte(f_Indices++);
+			State.m_RotBackupFrontFacelets[FaceIdx][i] = State.m_Facelets[Index];
+		}
+		++FaceIdx;
+	}
+}
+
+#if ROTATION_ANIMATION_VERSION != 6
 
-	// Backup the side facelets.
-	const FaceletIndex* f_Indices = &CurRot.Side[0];
-	for (uint8_t i = 0; i < NumSideFacelets; ++i)
+// Turn off the facelets of one step of the animated move: on each layer, one
+// side facelet and, on the faces, the front facelet next to it.
+void TurnOffStep(Cube::SState& State, uint8_t StepIdx)
+{
+	for (uint8_t LayerIdx = 0; LayerIdx < Cube::MaxLayersPerMove; ++LayerIdx)
 	{
-		FaceletIndex Index = pgm_read_byte(f_Indices++);
-		g_RotBackupSideFacelets[i] = g_Facelets[Index];
+		uint8_t Layer = GetLayer(State.m_AnimRotationFace, LayerIdx);
+		if (Layer == NoLayer)
+			break;
+		uint8_t SideIdx = GetSideIdx(IsLayerCCW(State.m_AnimRotationFace, Layer), StepIdx);
+		Layer &= ~ReversedLayer;
+
+		FaceletIndex Index = pgm_read_byte(GetSideFacelets(Layer) + SideIdx);
+		State.m_Facelets[Index] = Facelet::Black;
+
+		if (IsFaceLayer(Layer))
+		{
+			Index = pgm_read_byte(&f_Rot[Layer].Front[SideIdxToFrontIdx(SideIdx)]);
+			State.m_Facelets[Index] = Facelet::Black;
+		}
 	}
+}
 
-	// Backup the front facelets.
-	f_Indices = &CurRot.Front[0];
-	for (uint8_t i = 0; i < NumFrontFacelets; ++i)
+#endif
+
+// Turn the facelets of one step of the animated move back on, with their
+// colors after the move, using the backup. They are dimmed if IsDimmed.
+void RestoreStep(Cube::SState& State, uint8_t StepIdx, bool IsDimmed)
+{
+	uint8_t FaceIdx = 0;
+	for (uint8_t LayerIdx = 0; LayerIdx < Cube::MaxLayersPerMove; ++LayerIdx)
 	{
-		FaceletIndex Index = pgm_read_byte(f_Indices++);
-		g_RotBackupFrontFacelets[i] = g_Facelets[Index];
+		uint8_t Layer = GetLayer(State.m_AnimRotationFace, LayerIdx);
+		if (Layer == NoLayer)
+			break;
+		bool IsCCW = IsLayerCCW(State.m_AnimRotationFace, Layer);
+		uint8_t SideIdx = GetSideIdx(IsCCW, StepIdx);
+		Layer &= ~ReversedLayer;
+
+		FaceletIndex Index = pgm_read_byte(GetSideFacelets(Layer) + SideIdx);
+		State.m_Facelets[Index] = State.m_RotBackupSideFacelets[LayerIdx][GetBkpSideIdx(IsCCW, SideIdx)];
+		if (IsDimmed)
+			State.DimFacelet(Index);
+
+		if (!IsFaceLayer(Layer))
+			continue;
+		uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
+		Index = pgm_read_byte(&f_Rot[Layer].Front[FrontIdx]);
+		State.m_Facelets[Index] = State.m_RotBackupFrontFacelets[FaceIdx][GetBkpFrontIdx(IsCCW, FrontIdx)];
+		if (IsDimmed)
+			State.DimFacelet(Index);
+		++FaceIdx;
 	}
 }
 
@@ -323,58 +546,38 @@ void BackupForRotation()
 
 #if ROTATION_ANIMATION_VERSION == 2
 
-uint16_t DoRotationFadeToBlack();
-uint16_t DoRotationSetFinalColors();
+uint16_t DoRotationFadeToBlack(Cube::SState& State);
+uint16_t DoRotationSetFinalColors(Cube::SState& State);
 
-uint16_t DoRotation()
+uint16_t DoRotation(Cube::SState& State)
 {
-	BackupForRotation();
+	BackupForRotation(State);
 
 	// Start turning LEDs off.
-	g_AnimFunc = &DoRotationFadeToBlack;
-	return DoRotationFadeToBlack();
+	State.m_AnimFunc = &DoRotationFadeToBlack;
+	return DoRotationFadeToBlack(State);
 }
 
-uint16_t DoRotationFadeToBlack()
+uint16_t DoRotationFadeToBlack(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED off.
-	uint8_t SideIdx = GetSideIdx(g_AnimStepIdx);
-	FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-	g_Facelets[Index] = Facelet::Black;
-
-	uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-	Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-	g_Facelets[Index] = Facelet::Black;
+	TurnOffStep(State, State.m_AnimStepIdx);
 
-	if (++g_AnimStepIdx == 12)
+	if (++State.m_AnimStepIdx == 12)
 	{
-		g_AnimFunc = &DoRotationSetFinalColors;
-		g_AnimStepIdx = 0;
+		State.m_AnimFunc = &DoRotationSetFinalColors;
+		State.m_AnimStepIdx = 0;
 	}
 	return 16;
 }
 
-uint16_t DoRotationSetFinalColors()
+uint16_t DoRotationSetFinalColors(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED back on using the backup.
-	uint8_t SideIdx = GetSideIdx(g_AnimStepIdx);
-	FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-	uint8_t BkpIdx = GetBkpSideIdx(SideIdx);
-	g_Facelets[Index] = g_RotBackupSideFacelets[BkpIdx];
-
-	uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-	Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-	BkpIdx = GetBkpFrontIdx(FrontIdx);
-	g_Facelets[Index] = g_RotBackupFrontFacelets[BkpIdx];
+	RestoreStep(State, State.m_AnimStepIdx, false);
 
-	if (++g_AnimStepIdx == 12)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 12)
+		State.m_AnimFunc = &EndAnim;
 
 	return 16;
 }
@@ -383,50 +586,29 @@ uint16_t DoRotationSetFinalColors()
 
 #if ROTATION_ANIMATION_VERSION == 3
 
-uint16_t DoRotationForReal();
+uint16_t DoRotationForReal(Cube::SState& State);
 
-uint16_t DoRotation()
+uint16_t DoRotation(Cube::SState& State)
 {
-	BackupForRotation();
+	BackupForRotation(State);
 
 	// Start turning LEDs off.
-	g_AnimFunc = &DoRotationForReal;
-	return DoRotationForReal();
+	State.m_AnimFunc = &DoRotationForReal;
+	return DoRotationForReal(State);
 }
 
-uint16_t DoRotationForReal()
+uint16_t DoRotationForReal(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED off.
-	if (g_AnimStepIdx < 12)
-	{
-		uint8_t SideIdx = GetSideIdx(g_AnimStepIdx);
-		FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-		g_Facelets[Index] = Facelet::Black;
-
-		uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-		Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-		g_Facelets[Index] = Facelet::Black;
-	}
+	if (State.m_AnimStepIdx < 12)
+		TurnOffStep(State, State.m_AnimStepIdx);
 
 	// Turn next LED back on using the backup.
-	if (g_AnimStepIdx > 0)
-	{
-		uint8_t SideIdx = GetSideIdx(g_AnimStepIdx - 1);
-		FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-		uint8_t BkpIdx = GetBkpSideIdx(SideIdx);
-		g_Facelets[Index] = g_RotBackupSideFacelets[BkpIdx];
-
-		uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-		Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-		BkpIdx = GetBkpFrontIdx(FrontIdx);
-		g_Facelets[Index] = g_RotBackupFrontFacelets[BkpIdx];
-	}
+	if (State.m_AnimStepIdx > 0)
+		RestoreStep(State, State.m_AnimStepIdx - 1, false);
 
-	if (++g_AnimStepIdx == 13)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 13)
+		State.m_AnimFunc = &EndAnim;
 
 	return 75;
 }
@@ -435,64 +617,40 @@ uint16_t DoRotationForReal()
 
 #if ROTATION_ANIMATION_VERSION == 4
 
-uint16_t DoRotationFadeToBlack();
-uint16_t DoRotationSetFinalColors();
+uint16_t DoRotationFadeToBlack(Cube::SState& State);
+uint16_t DoRotationSetFinalColors(Cube::SState& State);
 
-uint16_t DoRotation()
+uint16_t DoRotation(Cube::SState& State)
 {
-	BackupForRotation();
+	BackupForRotation(State);
 
 	// Start turning LEDs off.
-	g_AnimFunc = &DoRotationFadeToBlack;
-	return DoRotationFadeToBlack();
+	State.m_AnimFunc = &DoRotationFadeToBlack;
+	return DoRotationFadeToBlack(State);
 }
 
-uint16_t DoRotationFadeToBlack()
+uint16_t DoRotationFadeToBlack(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED off.
 	for (uint8_t i = 0; i < 4; ++i)
-	{
-		uint8_t SideIdx = GetSideIdx(g_AnimStepIdx + i*3);
-		FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-		g_Facelets[Index] = Facelet::Black;
-
-		uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-		Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-		g_Facelets[Index] = Facelet::Black;
-	}
+		TurnOffStep(State, State.m_AnimStepIdx + i*3);
 
-	if (++g_AnimStepIdx == 3)
+	if (++State.m_AnimStepIdx == 3)
 	{
-		g_AnimFunc = &DoRotationSetFinalColors;
-		g_AnimStepIdx = 0;
+		State.m_AnimFunc = &DoRotationSetFinalColors;
+		State.m_AnimStepIdx = 0;
 	}
 	return 200;
 }
 
-uint16_t DoRotationSetFinalColors()
+uint16_t DoRotationSetFinalColors(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED back on using the backup.
 	for (uint8_t i = 0; i < 4; ++i)
-	{
-		uint8_t SideIdx = GetSideIdx(g_AnimStepIdx + i*3);
-		FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-		uint8_t BkpIdx = GetBkpSideIdx(SideIdx);
-		g_Facelets[Index] = g_RotBackupSideFacelets[BkpIdx];
+		RestoreStep(State, State.m_AnimStepIdx + i*3, false);
 
-		uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-		Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-		BkpIdx = GetBkpFrontIdx(FrontIdx);
-		g_Facelets[Index] = g_RotBackupFrontFacelets[BkpIdx];
-	}
-
-	if (++g_AnimStepIdx == 3)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 3)
+		State.m_AnimFunc = &EndAnim;
 
 	return 200;
 }
@@ -501,56 +659,35 @@ uint16_t DoRotationSetFinalColors()
 
 #if ROTATION_ANIMATION_VERSION == 5
 
-uint16_t DoRotationForReal();
+uint16_t DoRotationForReal(Cube::SState& State);
 
-uint16_t DoRotation()
+uint16_t DoRotation(Cube::SState& State)
 {
-	BackupForRotation();
+	BackupForRotation(State);
 
 	// Start turning LEDs off.
-	g_AnimFunc = &DoRotationForReal;
-	return DoRotationForReal();
+	State.m_AnimFunc = &DoRotationForReal;
+	return DoRotationForReal(State);
 }
 
-uint16_t DoRotationForReal()
+uint16_t DoRotationForReal(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED off.
-	if (g_AnimStepIdx < 3)
+	if (State.m_AnimStepIdx < 3)
 	{
 		for (uint8_t i = 0; i < 4; ++i)
-		{
-			uint8_t SideIdx = GetSideIdx(g_AnimStepIdx + i*3);
-			FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-			g_Facelets[Index] = Facelet::Black;
-
-			uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-			Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-			g_Facelets[Index] = Facelet::Black;
-		}
+			TurnOffStep(State, State.m_AnimStepIdx + i*3);
 	}
 
 	// Turn next LED back on using the backup.
-	if (g_AnimStepIdx > 0)
+	if (State.m_AnimStepIdx > 0)
 	{
 		for (uint8_t i = 0; i < 4; ++i)
-		{
-			uint8_t SideIdx = GetSideIdx(g_AnimStepIdx + i*3 - 1);
-			FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-			uint8_t BkpIdx = GetBkpSideIdx(SideIdx);
-			g_Facelets[Index] = g_RotBackupSideFacelets[BkpIdx];
-
-			uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-			Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-			BkpIdx = GetBkpFrontIdx(FrontIdx);
-			g_Facelets[Index] = g_RotBackupFrontFacelets[BkpIdx];
-		}
+			RestoreStep(State, State.m_AnimStepIdx + i*3 - 1, false);
 	}
 
-	if (++g_AnimStepIdx == 4)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 4)
+		State.m_AnimFunc = &EndAnim;
 
 	return 200;
 }
@@ -559,42 +696,31 @@ uint16_t DoRotationForReal()
 
 #if ROTATION_ANIMATION_VERSION == 6
 
-uint16_t DoRotationFadeToBlack();
-uint16_t DoRotationSetFinalColors();
+uint16_t DoRotationFadeToBlack(Cube::SState& State);
+uint16_t DoRotationSetFinalColors(Cube::SState& State);
 
-uint16_t DoRotation()
+uint16_t DoRotation(Cube::SState& State)
 {
-	BackupForRotation();
+	BackupForRotation(State);
 
 	// Start turning LEDs off.
-	g_AnimFunc = &DoRotationFadeToBlack;
-	return DoRotationFadeToBlack();
+	State.m_AnimFunc = &DoRotationFadeToBlack;
+	return DoRotationFadeToBlack(State);
 }
 
-uint16_t DoRotationFadeToBlack()
+uint16_t DoRotationFadeToBlack(Cube::SState& State)
 {
-	g_AnimFunc = &DoRotationSetFinalColors;
+	State.m_AnimFunc = &DoRotationSetFinalColors;
 	return 32;
 }
 
-uint16_t DoRotationSetFinalColors()
+uint16_t DoRotationSetFinalColors(Cube::SState& State)
 {
-	// Get the rotation index structure.
-	const SRotation& CurRot = GetRot();
-
 	// Turn next LED back on using the backup.
-	uint8_t SideIdx = GetSideIdx(g_AnimStepIdx);
-	FaceletIndex Index = pgm_read_byte(&CurRot.Side[SideIdx]);
-	uint8_t BkpIdx = GetBkpSideIdx(SideIdx);
-	g_Facelets[Index] = (g_RotBackupSideFacelets[BkpIdx] & ~Facelet::Bright);
-
-	uint8_t FrontIdx = SideIdxToFrontIdx(SideIdx);
-	Index = pgm_read_byte(&CurRot.Front[FrontIdx]);
-	BkpIdx = GetBkpFrontIdx(FrontIdx);
-	g_Facelets[Index] = (g_RotBackupFrontFacelets[BkpIdx] & ~Facelet::Bright);
+	RestoreStep(State, State.m_AnimStepIdx, true);
 
-	if (++g_AnimStepIdx == 12)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == 12)
+		State.m_AnimFunc = &EndAnim;
 
 	return 32;
 }
@@ -602,23 +728,23 @@ uint16_t DoRotationSetFinalColors()
 #endif
 
 // Set brightness state randomly to all facelets.
-uint16_t DoVictory()
+uint16_t DoVictory(Cube::SState& State)
 {
-	Cube::DimAll();
+	State.DimAll();
 	for (uint8_t i = 0; i < NUM_BRIGHT_FACELETS_DURING_VICTORY; ++i)
 	{
 		FaceletIndex Index = Rand8::Get(0, Cube::NumFacelets-1);
-		g_Facelets[Index] |= Facelet::Bright;
+		State.BrightenFacelet(Index);
 	}
-	if (++g_AnimStepIdx == NUM_VICTORY_ANIMATION_ITER)
-		g_AnimFunc = &EndAnim;
+	if (++State.m_AnimStepIdx == NUM_VICTORY_ANIMATION_ITER)
+		State.m_AnimFunc = &EndAnim;
 	return VICTORY_ANIMATION_DELAY_MS;
 }
 
-uint16_t EndAnim()
+uint16_t EndAnim(Cube::SState& State)
 {
-	Cube::DimAll();
-	g_AnimFunc = &NoAnim;
+	State.DimAll();
+	State.m_AnimFunc = &NoAnim;
 	return 0;
 }
 
@@ -627,78 +753,276 @@ uint16_t EndAnim()
 namespace Cube
 {
 
-// Get pointer to 54 facelets, in LED order.
-const Facelet::Type* GetFacelets()
+// Create a solved cube, without animation.
+SState::SState()
+	: m_AnimFunc(&NoAnim)
+	, m_AnimStepIdx(0)
+	, m_AnimRotationFace(Rotation::None)
 {
-	return g_Facelets;
+	Reset();
 }
 
 // Reset cube to solved state.
-void Reset()
+void SState::Reset()
 {
 	// Numerical order of colors in Facelet match initialization order.
-	Facelet::Type* pFacelet = g_Facelets;
-	for (Facelet::Type Color = 1; Color <= Cube::NumFaces; ++Color)
+	Facelet::Type* pFacelet = m_Facelets;
+	for (Facelet::Type Color = 1; Color <= NumFaces; ++Color)
 		for (uint8_t i = 0; i < NumFaceletsPerFace; ++i)
 			*pFacelet++ = Color;
+	m_NumMisplaced = 0;
+	DimAll();
 }
 
-// Returns true if the cube is in the solved state.
-bool IsSolved()
+// Returns true if each face has the color of its center, so that the
+// whole-cube rotations and the slice moves keep a solved cube solved.
+// Brightness is ignored.
+bool SState::IsSolved() const
 {
-	// Numerical order of colors in Facelet match initialization order.
-	const Facelet::Type* pFacelet = g_Facelets;
-	for (Facelet::Type Color = 1; Color <= Cube::NumFaces; ++Color)
-		for (uint8_t i = 0; i < NumFaceletsPerFace; ++i)
-			if (*pFacelet++ != Color)
-				return false;
-	return true;
+	if (m_NumMisplaced == UnknownNumMisplaced)
+		m_NumMisplaced = CountMisplaced(m_Facelets);
+	return m_NumMisplaced == 0;
+}
+
+// Set the color of one facelet. The number of misplaced facelets is computed
+// again by the next call to IsSolved().
+void SState::SetFacelet(FaceletIndex Index, Facelet::Type Color)
+{
+	assert(Index < NumFacelets);
+	assert(Color < Facelet::Bright);
+	m_Facelets[Index] = Color;
+	m_NumMisplaced = UnknownNumMisplaced;
+}
+
+// Do a move instantly, without animation nor change of brightness. A move is
+// a plain permutation: the number of misplaced facelets is computed again by
+// the next call to IsSolved(). The firmware only applies rotations.
+void SState::Apply(Rotation::Type Move)
+{
+	assert(Rotation::IsMove(Move));
+	Facelet::Type* pFacelets = m_Facelets;
+#ifdef USE_SIMULATOR
+	switch (Move)
+	{
+	case Rotation::Top:                    LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_TOP)    break;
+	case Rotation::Front:                  LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_FRONT)  break;
+	case Rotation::Right:                  LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_RIGHT)  break;
+	case Rotation::Back:                   LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_BACK)   break;
+	case Rotation::Left:                   LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_LEFT)   break;
+	case Rotation::Bottom:                 LAYOUT_CALL(APPLY_CW,  LAYOUT_NATIVE_BOTTOM) break;
+	case Rotation::Top    + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_TOP)    break;
+	case Rotation::Front  + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_FRONT)  break;
+	case Rotation::Right  + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_RIGHT)  break;
+	case Rotation::Back   + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_BACK)   break;
+	case Rotation::Left   + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_LEFT)   break;
+	case Rotation::Bottom + Rotation::CCW: LAYOUT_CALL(APPLY_CCW, LAYOUT_NATIVE_BOTTOM) break;
+	case Rotation::Middle:                     LAYOUT_CALL(APPLY_SLICE_CW,  LAYOUT_NATIVE_MIDDLE)   break;
+	case Rotation::Equator:                    LAYOUT_CALL(APPLY_SLICE_CW,  LAYOUT_NATIVE_EQUATOR)  break;
+	case Rotation::Standing:                   LAYOUT_CALL(APPLY_SLICE_CW,  LAYOUT_NATIVE_STANDING) break;
+	case Rotation::Middle   + Rotation::CCW:   LAYOUT_CALL(APPLY_SLICE_CCW, LAYOUT_NATIVE_MIDDLE)   break;
+	case Rotation::Equator  + Rotation::CCW:   LAYOUT_CALL(APPLY_SLICE_CCW, LAYOUT_NATIVE_EQUATOR)  break;
+	case Rotation::Standing + Rotation::CCW:   LAYOUT_CALL(APPLY_SLICE_CCW, LAYOUT_NATIVE_STANDING) break;
+	default:
+		// Whole-cube rotations turn their layers one by one.
+		for (uint8_t LayerIdx = 0; LayerIdx < MaxLayersPerMove; ++LayerIdx)
+		{
+			uint8_t Layer = GetLayer(Move, LayerIdx);
+			Rotation::Type LayerMove = (Layer & ~ReversedLayer);
+			if (LayerMove >= FirstSliceLayer)
+				LayerMove += Rotation::Middle - FirstSliceLayer;
+			if (IsLayerCCW(Move, Layer))
+				LayerMove += Rotation::CCW;
+			Apply(LayerMove);
+		}
+		break;
+	}
+#else
+	// The firmware cycles the facelets listed in f_Rot: 12 copies of the
+	// straight-line code would not fit in flash.
+	const SRotation* f_Rotation = &f_Rot[Rotation::GetFace(Move)];
+	bool IsCCW = (Move >= Rotation::CCW);
+	for (uint8_t i = 0; i < 3; ++i)
+		CycleFacelets(pFacelets, &f_Rotation->Side[i], 3, IsCCW);
+	for (uint8_t i = 0; i < 2; ++i)
+		CycleFacelets(pFacelets, &f_Rotation->Front[i], 2, IsCCW);
+#endif
+	m_NumMisplaced = UnknownNumMisplaced;
+}
+
+// Returns true if the given facelet is bright.
+bool SState::IsBright(FaceletIndex Index) const
+{
+	assert(Index < NumFacelets);
+	return (m_Brightness[Index >> 3] & GetBrightnessBit(Index)) != 0;
 }
 
 // Set all facelets to black. Previous configuration is lost.
-void SetToBlack()
+void SState::SetToBlack()
 {
 	for (FaceletIndex i = 0; i < NumFacelets; ++i)
-		g_Facelets[i] = Facelet::Black;
+		m_Facelets[i] = Facelet::Black;
+	m_NumMisplaced = NumFacelets;
+	DimAll();
 }
 
 // Dim all facelets of the cube.
-void DimAll()
+void SState::DimAll()
 {
-	for (FaceletIndex i = 0; i < NumFacelets; ++i)
-		g_Facelets[i] &= ~Facelet::Bright;
+	for (uint8_t i = 0; i < NumBrightnessBytes; ++i)
+		m_Brightness[i] = 0;
 }
 
 // Brighten all facelets.
-void BrightenAll()
+void SState::BrightenAll()
 {
-	for (FaceletIndex i = 0; i < NumFacelets; ++i)
-		g_Facelets[i] |= Facelet::Bright;
+	for (uint8_t i = 0; i < NumBrightnessBytes - 1; ++i)
+		m_Brightness[i] = 0xFF;
+	m_Brightness[NumBrightnessBytes - 1] = LastBrightnessByte;
 }
 
 // Brighten the given facelet.
-void BrightenFacelet(Facelet::Type FaceletIdx)
+void SState::BrightenFacelet(Facelet::Type FaceletIdx)
 {
 	assert(FaceletIdx < NumFacelets);
-	g_Facelets[FaceletIdx] |= Facelet::Bright;
+	m_Brightness[FaceletIdx >> 3] |= GetBrightnessBit(FaceletIdx);
+}
+
+// Dim the given facelet.
+void SState::DimFacelet(Facelet::Type FaceletIdx)
+{
+	assert(FaceletIdx < NumFacelets);
+	m_Brightness[FaceletIdx >> 3] &= ~GetBrightnessBit(FaceletIdx);
 }
 
 // Brighten facelets according to a given rotation.
-void BrightenFace(Rotation::Type Face)
+void SState::BrightenFace(Rotation::Type Face)
 {
-	STATIC_ASSERT(sizeof(SRotation) == NumAffectedFacelets * sizeof(FaceletIndex),
-		      "SRotation is expected to contain NumAffectedFacelets contiguous indices.");
 	assert(Face < 2 * Rotation::CCW);
 
 	if (Face >= Rotation::CCW)
 		Face -= Rotation::CCW;
 
-	const FaceletIndex* f_Indices = &f_Rot[Face].Side[0];
-	for (uint8_t i = 0; i < NumAffectedFacelets; ++i)
+	const uint8_t* f_Mask = &f_FaceBrightness[Face][0];
+	for (uint8_t i = 0; i < NumBrightnessBytes; ++i)
+		m_Brightness[i] |= pgm_read_byte(f_Mask++);
+}
+
+// Initiate the animation of the given move: its layers are brightened. The
+// number of misplaced facelets is updated at once for the state after the
+// move, since the frames write the facelets directly.
+void SState::AnimateRotation(Rotation::Type Move)
+{
+	if (!Rotation::IsRotation(Move))
+		m_NumMisplaced = UnknownNumMisplaced;
+	else if (m_NumMisplaced != UnknownNumMisplaced)
+		m_NumMisplaced += GetRotationDelta(m_Facelets, Move);
+
+	DimAll();
+	for (uint8_t LayerIdx = 0; LayerIdx < MaxLayersPerMove; ++LayerIdx)
 	{
-		FaceletIndex Index = pgm_read_byte(f_Indices++);
-		g_Facelets[Index] |= Facelet::Bright;
+		uint8_t Layer = GetLayer(Move, LayerIdx);
+		if (Layer == NoLayer)
+			break;
+		Layer &= ~ReversedLayer;
+		if (IsFaceLayer(Layer))
+			BrightenFace(Layer);
+		else
+		{
+			const FaceletIndex* f_Indices = GetSideFacelets(Layer);
+			for (uint8_t i = 0; i < NumSideFacelets; ++i)
+				BrightenFacelet(pgm_read_byte(f_Indices++));
+		}
 	}
+	m_AnimFunc         = &DoRotation;
+	m_AnimStepIdx      = 0;
+	m_AnimRotationFace = Move;
+}
+
+// Initiate the victory animation.
+void SState::AnimateVictory()
+{
+	m_AnimFunc         = &DoVictory;
+	m_AnimStepIdx      = 0;
+}
+
+// Update the cube according to the current animation. Return the delay before
+// the next "frame". A returned delay of 0 indicates this is the last frame.
+uint16_t SState::NextFrame()
+{
+	return (*m_AnimFunc)(*this);
+}
+
+// Get pointer to 54 facelets, in LED order.
+const Facelet::Type* GetFacelets()
+{
+	return g_Cube.m_Facelets;
+}
+
+// Get pointer to the 7-byte brightness mask, see SState::m_Brightness.
+const uint8_t* GetBrightness()
+{
+	return g_Cube.m_Brightness;
+}
+
+// Returns true if the given facelet is bright.
+bool IsBright(uint8_t FaceletIdx)
+{
+	return g_Cube.IsBright(FaceletIdx);
+}
+
+// Reset cube to solved state.
+void Reset()
+{
+	g_Cube.Reset();
+}
+
+// Returns true if the cube is in the solved state.
+bool IsSolved()
+{
+	return g_Cube.IsSolved();
+}
+
+// Do a move instantly, without animation nor change of brightness.
+void Apply(Rotation::Type Move)
+{
+	g_Cube.Apply(Move);
+}
+
+// Index of the center facelet of the face of a facelet.
+FaceletIndex GetCenterFacelet(FaceletIndex Index)
+{
+	assert(Index < NumFacelets);
+	return pgm_read_byte(&f_FaceletCenters[Index]);
+}
+
+// Set all facelets to black. Previous configuration is lost.
+void SetToBlack()
+{
+	g_Cube.SetToBlack();
+}
+
+// Dim all facelets of the cube.
+void DimAll()
+{
+	g_Cube.DimAll();
+}
+
+// Brighten all facelets.
+void BrightenAll()
+{
+	g_Cube.BrightenAll();
+}
+
+// Brighten the given facelet.
+void BrightenFacelet(Facelet::Type FaceletIdx)
+{
+	g_Cube.BrightenFacelet(FaceletIdx);
+}
+
+// Brighten facelets according to a given rotation.
+void BrightenFace(Rotation::Type Face)
+{
+	g_Cube.BrightenFace(Face);
 }
 
 #if DEBUG_CODE
@@ -707,14 +1031,14 @@ void BrightenFace(Rotation::Type Face)
 void Backup()
 {
 	for (FaceletIndex i = 0; i < NumBackupFacelets; ++i)
-		g_BackupFacelets[i] = g_Facelets[i];
+		g_BackupFacelets[i] = g_Cube.m_Facelets[i];
 }
 
 // Restore the facelets used by the printing functions
 void Restore()
 {
 	for (FaceletIndex i = 0; i < NumBackupFacelets; ++i)
-		g_Facelets[i] = g_BackupFacelets[i];
+		g_Cube.SetFacelet(i, g_BackupFacelets[i]);
 }
 
 // Print a uint8_t in binary using one face of the cube.
@@ -722,9 +1046,9 @@ void PrintUInt8(uint8_t Value)
 {
 	for (FaceletIndex i = 0; i < NumBackupFacelets; ++i)
 	{
-		g_Facelets[g_DebugIndexes[i]] = ((Value & 1) != 0)
+		g_Cube.SetFacelet(g_DebugIndexes[i], ((Value & 1) != 0)
 			? Facelet::White
-			: Facelet::Black;
+			: Facelet::Black);
 		Value >>= 1;
 	}
 }
@@ -734,28 +1058,23 @@ void PrintUInt8(uint8_t Value)
 namespace Animation
 {
 
-// Initiate a rotation animation for the given face.
-void Rotate(Rotation::Type Face)
+// Initiate the animation of the given move.
+void Rotate(Rotation::Type Move)
 {
-	Cube::DimAll();
-	Cube::BrightenFace(Face);
-	g_AnimFunc         = &DoRotation;
-	g_AnimStepIdx      = 0;
-	g_AnimRotationFace = Face;
+	g_Cube.AnimateRotation(Move);
 }
 
 // Initiate the victory animation.
 void Victory()
 {
-	g_AnimFunc         = &DoVictory;
-	g_AnimStepIdx      = 0;
+	g_Cube.AnimateVictory();
 }
 
 // Update the cube according to the current animation. Return the delay before
 // the next "frame". A returned delay of 0 indicates this is the last frame.
 uint16_t Next()
 {
-	return (*g_AnimFunc)();
+	return g_Cube.NextFrame();
 }
 
 }
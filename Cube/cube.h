@@ -29,7 +29,7 @@ const Type Yellow = 3;	// At reset: bottom
 
 const Type Unused = 7;
 
-const Type Bright = 8;	// additive bit
+const Type Bright = 8;	// additive, offset of the bright colors in the Colors LUT
 }
 
 // Structure holding a 24-bit color in the RGB order, as used by the LEDs.
@@ -41,6 +41,12 @@ struct SColor
 // Color LUT:  Facelet::Type --> SColor
 extern const SColor Colors[15];
 
+// Returns the LED color of a facelet, given its color and brightness.
+inline const SColor& GetColor(Facelet::Type Color, bool IsBright)
+{
+	return Colors[IsBright ? Color + Facelet::Bright : Color];
+}
+
 // "enum" representing the possible rotation operations on the cube.
 namespace Rotation
 {
@@ -57,6 +63,18 @@ const Type CCW    = 6; // additive, means counter-clockwise
 
 const Type NumRotations = 12;
 
+// Moves other than the rotations of a face, after them: a middle slice
+// turning as the face it follows in the standard notation, or the whole
+// cube turning as a face. CCW is additive as well.
+const Type Middle   = 12;	// M, turns as Left
+const Type Equator  = 13;	// E, turns as Bottom
+const Type Standing = 14;	// S, turns as Front
+const Type CubeX    = 15;	// x, turns as Right
+const Type CubeY    = 16;	// y, turns as Top
+const Type CubeZ    = 17;	// z, turns as Front
+
+const Type NumMoves = 24;	// Rotations, slice moves and whole-cube rotations.
+
 const Type None   = 255;
 
 inline bool IsRotation(Type Face)
@@ -64,10 +82,39 @@ inline bool IsRotation(Type Face)
 	return Face < NumRotations;
 }
 
-inline Type Opposite(Type Face)
+// Returns true for any move: a rotation, a slice move or a whole-cube rotation.
+inline bool IsMove(Type Move)
+{
+	return Move < NumMoves;
+}
+
+// Returns the clockwise move of the same face, slice or axis as a move.
+inline Type GetClockwise(Type Move)
+{
+	assert(IsMove(Move));
+	Type First = (Move < NumRotations ? 0 : NumRotations);
+	return (Move - First < CCW ? Move : Move - CCW);
+}
+
+// Returns the move undoing the given one.
+inline Type Opposite(Type Move)
+{
+	assert(IsMove(Move));
+	return (GetClockwise(Move) == Move ? Move + CCW : Move - CCW);
+}
+
+// Returns the face turned by a rotation, i.e. the clockwise rotation of that face.
+inline Type GetFace(Type Rot)
+{
+	assert(IsRotation(Rot));
+	return (Rot < CCW ? Rot : Rot - CCW);
+}
+
+// Returns the face opposite to the given face (e.g. Bottom for Top).
+inline Type OppositeFace(Type Face)
 {
-	assert(IsRotation(Face));
-	return (Face < CCW ? Face + CCW : Face - CCW);
+	assert(Face < CCW);
+	return (Face == Top ? Bottom : Face == Bottom ? Top : (Face + 1) % 4 + 1);
 }
 
 }
@@ -80,9 +127,73 @@ const uint8_t NumFaces = 6;
 const uint8_t NumFacelets = NumFaceletsPerFace * NumFaces;
 const uint8_t NumVertices = 8;
 
+const uint8_t NumSideFacelets  = 12; // Number of facelets on the side of a turning face.
+const uint8_t NumFrontFacelets =  8; // Number of facelets on the front of a turning face, excluding the center.
+
+const uint8_t NumBrightnessBytes = (NumFacelets + 7) / 8; // Size of the brightness mask, one bit per facelet.
+
+// The slice moves and the whole-cube rotations have no sensor gesture, so
+// only the simulator and the host tools can perform them: the firmware only
+// turns faces, and keeps the backups of a single face. Its scrambles and
+// hints do not use them either: the backups of 3 layers and the animations
+// of the other moves would not fit in its SRAM and flash, and the nibbles
+// of Scrambles::f_Rotations and HintTables::f_Rotations only have room for
+// the moves before End (15).
+#ifdef USE_SIMULATOR
+const uint8_t MaxLayersPerMove = 3; // Faces and slices turned by a whole-cube rotation.
+const uint8_t MaxFacesPerMove  = 2; // Faces turned by a whole-cube rotation.
+#else
+const uint8_t MaxLayersPerMove = 1; // A face.
+const uint8_t MaxFacesPerMove  = 1;
+#endif
+
+// State of one cube: its facelets and its current animation. Any number of
+// instances can be used independently (e.g. to simulate many cubes on a PC).
+// The free functions below all operate on a single, default instance.
+struct SState
+{
+	typedef uint16_t (*AnimFuncType)(SState& State);
+
+	Facelet::Type  m_Facelets[NumFacelets];	// Facelets, in LED order. Use SetFacelet() to change colors.
+	uint8_t        m_Brightness[NumBrightnessBytes];	// Bit i%8 of byte i/8 is set if facelet i is bright.
+	mutable uint8_t m_NumMisplaced;		// Number of facelets whose color differs from the center of their face, updated by the rotations, computed lazily after SetFacelet() and the moves that move centers.
+
+	// Animation-related
+	AnimFuncType   m_AnimFunc;		// Function computing the next frame.
+	uint8_t        m_AnimStepIdx;		// Step within the current animation.
+	Rotation::Type m_AnimRotationFace;	// Move being animated, if any.
+	Facelet::Type  m_RotBackupSideFacelets[MaxLayersPerMove][NumSideFacelets];	// Side facelets of each layer before the move.
+	Facelet::Type  m_RotBackupFrontFacelets[MaxFacesPerMove][NumFrontFacelets];	// Front facelets of each face before the move.
+
+	SState();				// Create a solved cube, without animation.
+
+	void Reset();				// Reset cube to solved state.
+	bool IsSolved() const;			// Returns true if each face has the color of its center.
+	void SetFacelet(uint8_t FaceletIdx, Facelet::Type Color);	// Set the color of one facelet.
+	void Apply(Rotation::Type Move);	// Do a move instantly, without animation nor change of brightness.
+	bool IsBright(uint8_t FaceletIdx) const;	// Returns true if the given facelet is bright.
+
+	// Brightness-related.
+	void SetToBlack();			// Set all facelets to black. Previous configuration is lost.
+	void DimAll();				// Dim all facelets of the cube.
+	void BrightenAll();			// Brighten all facelets.
+	void BrightenFacelet(Facelet::Type FaceletIdx);	// Brighten the given facelet.
+	void DimFacelet(Facelet::Type FaceletIdx);	// Dim the given facelet.
+	void BrightenFace(Rotation::Type Face);	// Brighten facelets according to a given rotation.
+
+	// Animation-related, see namespace Cube::Animation.
+	void AnimateRotation(Rotation::Type Move);	// Initiate the animation of the given move.
+	void AnimateVictory();			// Initiate the victory animation.
+	uint16_t NextFrame();			// Update the cube according to the current animation.
+};
+
 const Facelet::Type* GetFacelets();	// Get pointer to 54 facelets, in LED order.
+const uint8_t* GetBrightness();		// Get pointer to the 7-byte brightness mask, see SState::m_Brightness.
+bool IsBright(uint8_t FaceletIdx);	// Returns true if the given facelet is bright.
 void Reset();				// Reset cube to solved state.
-bool IsSolved();			// Returns true if the cube is in the solved state.
+bool IsSolved();			// Returns true if each face has the color of its center.
+void Apply(Rotation::Type Move);	// Do a move instantly, without animation nor change of brightness.
+uint8_t GetCenterFacelet(uint8_t FaceletIdx);	// Index of the center facelet of the face of a facelet.
 
 // Brightness-related.
 void SetToBlack();			// Set all facelets to black. Previous configuration is lost.
@@ -99,7 +210,7 @@ void PrintUInt8(uint8_t Value);		// Print a uint8_t in binary using one face of
 
 namespace Animation
 {
-void Rotate(Rotation::Type Face);	// Initiate a rotation animation for the given face.
+void Rotate(Rotation::Type Move);	// Initiate the animation of the given move.
 void Victory();				// Initiate the victory animation.
 
 // Update the cube according to the current animation. Return the delay before
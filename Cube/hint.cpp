@@ -0,0 +1,245 @@
+#include "hint.h"
+#include "hinttables.h"
+#include "config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+// "enum" of the states of the hint engine.
+const uint8_t Idle      = 0;	// No hint.
+const uint8_t Searching = 1;	// Looking for the first misplaced piece, from g_Target.
+const uint8_t Ready     = 2;	// The plan places g_Target, its next rotation is the hint.
+
+const uint8_t NumSides       = 4;	// Side faces, Front to Left.
+const uint8_t NumStages      = Hint::NumTargets / NumSides;
+const uint8_t UnusedFacelet  = 0xFF;
+
+// Counter-clockwise hints are shown every other 8 ring scans.
+const uint8_t BlinkMask = 0x08;
+
+uint8_t  g_State;
+uint8_t  g_Target;		// Target piece being searched or placed.
+uint16_t g_NibbleIdx;		// Next rotation of the plan in HintTables::f_Rotations.
+uint8_t  g_NumScans;		// Ring scans, for blinking.
+
+// Facelet indices of the stickers of each position (see Hint::GetFacelet()).
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+#ifdef USE_SIMULATOR
+const uint8_t f_PositionFacelets[Hint::NumPositions][3] PROGMEM =
+{
+	{ 5, 12, UnusedFacelet}, { 7, 21, UnusedFacelet}, { 3, 30, UnusedFacelet}, { 1, 39, UnusedFacelet},	// top edges
+	{16, 19, UnusedFacelet}, {25, 28, UnusedFacelet}, {34, 37, UnusedFacelet}, {43, 10, UnusedFacelet},	// middle edges
+	{48, 14, UnusedFacelet}, {52, 23, UnusedFacelet}, {50, 32, UnusedFacelet}, {46, 41, UnusedFacelet},	// bottom edges
+	{ 8, 15, 18}, { 6, 24, 27}, { 0, 33, 36}, { 2, 42,  9},	// top corners
+	{51, 20, 17}, {53, 29, 26}, {47, 38, 35}, {45, 11, 44}	// bottom corners
+};
+#else
+const uint8_t f_PositionFacelets[Hint::NumPositions][3] PROGMEM =
+{
+	{48,  7, UnusedFacelet}, {52, 12, UnusedFacelet}, {50, 34, UnusedFacelet}, {46, 39, UnusedFacelet},	// top edges
+	{ 1, 10, UnusedFacelet}, {14, 32, UnusedFacelet}, {28, 37, UnusedFacelet}, {41,  5, UnusedFacelet},	// middle edges
+	{23,  3, UnusedFacelet}, {19, 16, UnusedFacelet}, {21, 30, UnusedFacelet}, {25, 43, UnusedFacelet},	// bottom edges
+	{53,  8,  9}, {51, 13, 33}, {45, 35, 36}, {47, 40,  6},	// top corners
+	{18, 17,  0}, {20, 31, 15}, {26, 44, 27}, {24,  4, 42}	// bottom corners
+};
+#endif
+
+// Position of the first target of each stage.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const uint8_t f_StageHomes[NumStages] PROGMEM =
+{
+	 0,	// top edges
+	12,	// top corners
+	 4,	// middle edges
+	 8,	// bottom edges
+	16	// bottom corners
+};
+
+// Returns true if the piece whose home is Home is at Pos, with the given
+// orientation.
+bool IsPieceAt(const Facelet::Type* pFacelets, uint8_t Home, uint8_t Pos, uint8_t Ori)
+{
+	uint8_t NumStickers = Hint::GetNumStickers(Pos);
+	for (uint8_t Sticker = 0; Sticker < NumStickers; ++Sticker)
+	{
+		uint8_t PosSticker = Sticker + Ori;
+		if (PosSticker >= NumStickers)
+			PosSticker -= NumStickers;
+		Facelet::Type Color = pFacelets[Cube::GetCenterFacelet(Hint::GetFacelet(Home, Sticker))];
+		if (pFacelets[Hint::GetFacelet(Pos, PosSticker)] != Color)
+			return false;
+	}
+	return true;
+}
+
+// Case of the target piece, relative to its home, or Hint::NumCases if its
+// colors are nowhere to be found.
+uint8_t FindCase(const Facelet::Type* pFacelets, uint8_t Target)
+{
+	uint8_t Home = Hint::GetHome(Target);
+	uint8_t Pos = (Home < Hint::FirstCorner ? 0 : Hint::FirstCorner);
+	uint8_t End = (Home < Hint::FirstCorner ? Hint::FirstCorner : Hint::NumPositions);
+	uint8_t NumStickers = Hint::GetNumStickers(Home);
+	for (; Pos < End; ++Pos)
+		for (uint8_t Ori = 0; Ori < NumStickers; ++Ori)
+			if (IsPieceAt(pFacelets, Home, Pos, Ori))
+			{
+				// The cube is seen from the side of the target.
+				uint8_t RelPos = Hint::RotatePosition(Pos, NumSides - (Target & (NumSides - 1)));
+				return (RelPos - (Home < Hint::FirstCorner ? 0 : Hint::FirstCorner)) * NumStickers + Ori;
+			}
+	return Hint::NumCases;
+}
+
+// Rotation Idx of f_Rotations (two per byte, the first one in the low nibble).
+Rotation::Type ReadNibble(uint16_t Idx)
+{
+	uint8_t Byte = pgm_read_byte(&HintTables::f_Rotations[Idx >> 1]);
+	return ((Idx & 1) ? Byte >> 4 : Byte & 0x0F);
+}
+
+// Start the plan placing g_Target. The sequences of all the cases of all
+// the tables follow each other, each one ending with HintTables::End.
+void StartPlan()
+{
+	// The last bottom corner is placed along with the others, unless a piece
+	// was taken apart and the cube cannot be solved anymore.
+	uint8_t Table = Hint::GetTable(g_Target);
+	uint8_t Case  = FindCase(Cube::GetFacelets(), g_Target);
+	if (Table >= Hint::NumTables || Case >= Hint::NumCases)
+	{
+		g_State = Idle;
+		return;
+	}
+
+	uint16_t NumSkipped = Table * Hint::NumCases + Case;
+	uint16_t Idx = 0;
+	for (; NumSkipped > 0; ++Idx)
+		if (ReadNibble(Idx) == HintTables::End)
+			--NumSkipped;
+	g_NibbleIdx = Idx;
+
+	// Cases that cannot happen have an empty plan.
+	g_State = (ReadNibble(Idx) == HintTables::End ? Idle : Ready);
+}
+
+}
+
+namespace Hint
+{
+
+// Hide the hint and forget the plan.
+void Reset()
+{
+	g_State = Idle;
+}
+
+// Start looking for a hint for the current state of the cube.
+void Request()
+{
+	g_State  = Searching;
+	g_Target = 0;
+}
+
+// Do the next step of the search, if any: check the pieces of one stage.
+void Step()
+{
+	++g_NumScans;
+	if (g_State != Searching)
+		return;
+
+	uint8_t LastTarget = g_Target | (NumSides - 1);
+	for (; g_Target <= LastTarget; ++g_Target)
+	{
+		uint8_t Home = GetHome(g_Target);
+		if (!IsPieceAt(Cube::GetFacelets(), Home, Home, 0))
+		{
+			StartPlan();
+			return;
+		}
+	}
+
+	// Solved: there is nothing to hint.
+	if (g_Target == NumTargets)
+		g_State = Idle;
+}
+
+// Current hint, or Rotation::None if there is none (yet).
+Rotation::Type Get()
+{
+	if (g_State != Ready)
+		return Rotation::None;
+	return RotateRotation(ReadNibble(g_NibbleIdx), g_Target & (NumSides - 1));
+}
+
+// Brighten the face of the hint, if any. Counter-clockwise hints blink.
+void Show()
+{
+	Rotation::Type Rot = Get();
+	if (Rot != Rotation::None && (Rot < Rotation::CCW || (g_NumScans & BlinkMask) != 0))
+		Cube::BrightenFace(Rot);
+}
+
+// Follow the plan if Rot is the hint, else forget it. At the end of the
+// plan, the search goes on from the piece just placed.
+void OnRotation(Rotation::Type Rot)
+{
+	if (g_State != Ready || Rot != Get())
+	{
+		Reset();
+		return;
+	}
+	if (ReadNibble(++g_NibbleIdx) == HintTables::End)
+		g_State = Searching;
+}
+
+uint8_t GetNumStickers(uint8_t Pos)
+{
+	assert(Pos < NumPositions);
+	return (Pos < FirstCorner ? 2 : 3);
+}
+
+// Facelet index of a sticker of a position.
+uint8_t GetFacelet(uint8_t Pos, uint8_t Sticker)
+{
+	assert(Pos < NumPositions && Sticker < GetNumStickers(Pos));
+	return pgm_read_byte(&f_PositionFacelets[Pos][Sticker]);
+}
+
+// Position of a target piece, in the order they are placed.
+uint8_t GetHome(uint8_t Target)
+{
+	assert(Target < NumTargets);
+	return pgm_read_byte(&f_StageHomes[Target / NumSides]) + (Target & (NumSides - 1));
+}
+
+// Table of the plans placing a target piece. The bottom corners have one
+// table each: the last two cannot be swapped with the others in place, so
+// each one only keeps the corners placed before it.
+uint8_t GetTable(uint8_t Target)
+{
+	assert(Target < NumTargets);
+	uint8_t Stage = Target / NumSides;
+	return (Stage < NumStageTables ? Stage : NumStageTables + (Target & (NumSides - 1)));
+}
+
+// Position after turning the whole cube by quarter turns about the
+// top-bottom axis.
+uint8_t RotatePosition(uint8_t Pos, uint8_t NumQuarterTurns)
+{
+	assert(Pos < NumPositions);
+	return (Pos & ~(NumSides - 1)) | ((Pos + NumQuarterTurns) & (NumSides - 1));
+}
+
+// Rotation after turning the whole cube by quarter turns about the
+// top-bottom axis.
+Rotation::Type RotateRotation(Rotation::Type Rot, uint8_t NumQuarterTurns)
+{
+	assert(Rotation::IsRotation(Rot));
+	Rotation::Type Face = Rotation::GetFace(Rot);
+	if (Face == Rotation::Top || Face == Rotation::Bottom)
+		return Rot;
+	return Rot - Face + Rotation::Front + ((Face - Rotation::Front + NumQuarterTurns) & (NumSides - 1));
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "cube.h"
+
+// "Next move" hints for the default cube, following a layer-by-layer method.
+//
+// The pieces are placed one after the other: the 4 edges and the 4 corners
+// of the top face, the 4 middle edges, then the 4 edges and the 4 corners of
+// the bottom face. Where the first misplaced piece lies, relative to its home
+// (up to quarter turns of the whole cube around the top-bottom axis), selects
+// a sequence of rotations that places it without moving the pieces placed
+// before: the plan. The sequences are stored in flash (see hinttables.h,
+// generated by RubikHint). The hint is the next rotation of the plan, so
+// while the player follows the hints, there is nothing to compute at all.
+//
+// Finding the first misplaced piece is split into steps that each look at
+// one layer of the pieces, done by Step() between two ring scans, so that
+// touch scanning never waits. Only a few bytes of RAM are used.
+namespace Hint
+{
+const uint8_t NumTargets = 20;	// Pieces placed in order, see GetHome().
+
+void Reset();			// Hide the hint and forget the plan.
+void Request();			// Start looking for a hint for the current state of the cube.
+void Step();			// Do the next step of the search, if any. Called once per ring scan.
+Rotation::Type Get();		// Current hint, or Rotation::None if there is none (yet).
+void Show();			// Brighten the face of the hint, if any. Counter-clockwise hints blink.
+void OnRotation(Rotation::Type Rot);	// Follow the plan if Rot is the hint, else forget it.
+
+// Geometry of the pieces and of the tables, shared with RubikHint.
+//
+// Positions 0 to 11 are edges: the top, middle and bottom layers, each in
+// the order front, right, back, left. Positions 12 to 19 are the top then
+// bottom corners, in the same order. Turning the whole cube a quarter turn
+// about the top-bottom axis moves each layer of 4 positions by one, and maps
+// each face to the next in the order Front, Right, Back, Left.
+//
+// Sticker 0 of a position is on the top or bottom face (for middle edges, on
+// the first side face in that order), and the others follow
+// counter-clockwise. The orientation of a piece is the sticker of its
+// position that holds its own sticker 0. A case is 2 * edge position +
+// orientation, or 3 * (corner position - 12) + orientation, relative to the
+// home of the piece.
+const uint8_t NumPositions   = 20;
+const uint8_t FirstCorner    = 12;
+const uint8_t NumTables      = 7;
+const uint8_t NumCases       = 24;
+const uint8_t NumStageTables = 4;	// One table per layer, then one per bottom corner except the last.
+
+uint8_t GetNumStickers(uint8_t Pos);
+uint8_t GetFacelet(uint8_t Pos, uint8_t Sticker);	// Facelet index of a sticker of a position.
+uint8_t GetHome(uint8_t Target);	// Position of a target piece, in the order they are placed.
+uint8_t GetTable(uint8_t Target);	// Table of the plans placing a target piece.
+uint8_t RotatePosition(uint8_t Pos, uint8_t NumQuarterTurns);	// Position after turning the whole cube.
+Rotation::Type RotateRotation(Rotation::Type Rot, uint8_t NumQuarterTurns);	// Same, for a rotation.
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+
+// Plans of the hint engine (see hint.h). Generated by RubikHint.
+namespace HintTables
+{
+const uint8_t End = 0x0F;
+
+// Rotations, two per byte (the first one in the low nibble), each plan
+// ending with End: the 24 cases of each of the 7 tables, in order.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const uint8_t f_Rotations[393] PROGMEM =
+{
+	0x1F, 0x26, 0xF0, 0x68, 0x02, 0x8F, 0xF7, 0x09, 0x30, 0x00, 0x9F, 0x86,
+	0xF0, 0x76, 0x10, 0x4F, 0xF1, 0x26, 0xF0, 0xF7, 0x00, 0x03, 0xF0, 0x86,
+	0xF0, 0x40, 0xF6, 0x00, 0x09, 0xF0, 0xF1, 0xA0, 0xF6, 0x11, 0x1F, 0xA0,
+	0xF6, 0x1B, 0xF1, 0x72, 0xF8, 0x55, 0x11, 0x4F, 0xA5, 0xF1, 0x15, 0xF1,
+	0x1A, 0xF4, 0x8F, 0x25, 0x51, 0xF7, 0xB1, 0x87, 0x2B, 0x9F, 0x1B, 0x75,
+	0xF3, 0x21, 0x1B, 0x58, 0xF7, 0x91, 0x7B, 0xF3, 0xA8, 0x55, 0x24, 0x3F,
+	0x95, 0x58, 0xF2, 0x1A, 0x55, 0x47, 0x4F, 0xAB, 0x58, 0xF2, 0x84, 0xA5,
+	0xF2, 0x54, 0x58, 0x5A, 0xF2, 0x21, 0x11, 0x78, 0x8F, 0x2B, 0x1F, 0x75,
+	0x1F, 0x12, 0x58, 0xF7, 0xB1, 0xF7, 0x1B, 0x75, 0x1F, 0x75, 0xB8, 0xF2,
+	0x51, 0x75, 0x5F, 0x58, 0xF2, 0x78, 0x18, 0x2B, 0x5F, 0xB8, 0xF2, 0x58,
+	0xF2, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x72, 0x68, 0x23, 0x10, 0x96, 0x8F,
+	0x87, 0x51, 0xF2, 0x18, 0x59, 0x75, 0x83, 0x8F, 0x59, 0x98, 0x32, 0xF2,
+	0x5A, 0x14, 0xBA, 0x41, 0x11, 0x7F, 0xAB, 0x41, 0xF1, 0x41, 0x58, 0xA5,
+	0x12, 0x1F, 0xB2, 0x54, 0x8A, 0xF7, 0x21, 0x57, 0xB1, 0x78, 0x0F, 0x62,
+	0x07, 0x68, 0xF1, 0x03, 0xB1, 0x67, 0x95, 0x1F, 0x7B, 0x72, 0x18, 0x5F,
+	0x27, 0x81, 0x51, 0xF7, 0x21, 0xA1, 0x87, 0x74, 0x8F, 0x2B, 0x15, 0x75,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xB7, 0x72, 0x18,
+	0x58, 0x12, 0x1F, 0x55, 0xB7, 0xB1, 0xB7, 0x1F, 0x10, 0x00, 0x29, 0x03,
+	0x18, 0x12, 0x1F, 0x40, 0xA9, 0xA3, 0xA9, 0x43, 0x76, 0x1F, 0x01, 0x61,
+	0x81, 0x41, 0xA5, 0x27, 0x3F, 0x95, 0x35, 0x55, 0x59, 0x1F, 0x00, 0x43,
+	0x09, 0x10, 0x18, 0x12, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x98,
+	0x72, 0xA8, 0x83, 0x49, 0x23, 0x12, 0xBF, 0x07, 0x21, 0x80, 0x25, 0x86,
+	0x67, 0xF1, 0x98, 0x72, 0x38, 0x12, 0x5F, 0xB3, 0x57, 0xB9, 0xF1, 0x51,
+	0x15, 0x70, 0x55, 0x61, 0x11, 0x7F, 0x26, 0xA9, 0x83, 0x49, 0x03, 0xF1,
+	0x98, 0x3A, 0x92, 0x34, 0x8F, 0x23, 0x87, 0x29, 0xF1, 0x7A, 0x18, 0x74,
+	0x12, 0x8F, 0x55, 0x68, 0x52, 0x85, 0x20, 0xF2, 0x87, 0x29, 0x81, 0x23,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x98, 0x72, 0xB8, 0x57, 0xB3,
+	0x51, 0x12, 0xBF, 0x07, 0x21, 0x80, 0x25, 0x86, 0x67, 0xF1, 0x1A, 0x94,
+	0x7A, 0x34, 0x9F, 0x3A, 0x98, 0x34, 0xF2, 0x97, 0x3A, 0x22, 0x49, 0x23,
+	0x12, 0x7F, 0x26, 0xA9, 0x83, 0x49, 0x03, 0xF1, 0x98, 0x3A, 0x92, 0x34,
+	0xBF, 0x57, 0xB3, 0x51, 0xF9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x98, 0x72, 0xB8, 0x57, 0xB3, 0x51, 0x12, 0xBF, 0x07, 0x21, 0x80,
+	0x25, 0x86, 0x67, 0xF1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+}
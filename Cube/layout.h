@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+
+// "enum" representing the order in which the facelets are wired to the LEDs.
+namespace Layout
+{
+typedef uint8_t Type;
+
+const Type Simulator = 0;	// LED order of the OpenGL simulator.
+const Type Hardware  = 1;	// LED order of the physical cube.
+
+const Type NumLayouts = 2;
+
+// Layout of the cube this code is compiled for.
+#ifdef USE_SIMULATOR
+const Type Native = Simulator;
+#else
+const Type Native = Hardware;
+#endif
+}
+
+// Facelet indices affected by the rotation of each face, for both layouts.
+// Each list holds the 12 facelets on the side of the turning face, then the
+// 8 facelets on the front of the turning face (excluding the center), then
+// the center facelet. Side and front facelets are listed in counter-clockwise
+// order, as seen from the turning face.
+//                                   side                                            front                              center
+#define LAYOUT_SIMULATOR_TOP    ( 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42,     2,  5,  8,  7,  6,  3,  0,  1,      4)
+#define LAYOUT_SIMULATOR_FRONT  (45, 48, 51, 20, 19, 18,  8,  5,  2, 42, 43, 44,    11, 14, 17, 16, 15, 12,  9, 10,     13)
+#define LAYOUT_SIMULATOR_RIGHT  (51, 52, 53, 29, 28, 27,  6,  7,  8, 15, 16, 17,    20, 23, 26, 25, 24, 21, 18, 19,     22)
+#define LAYOUT_SIMULATOR_BACK   (53, 50, 47, 38, 37, 36,  0,  3,  6, 24, 25, 26,    29, 32, 35, 34, 33, 30, 27, 28,     31)
+#define LAYOUT_SIMULATOR_LEFT   (47, 46, 45, 11, 10,  9,  2,  1,  0, 33, 34, 35,    38, 41, 44, 43, 42, 39, 36, 37,     40)
+#define LAYOUT_SIMULATOR_BOTTOM (35, 32, 29, 26, 23, 20, 17, 14, 11, 44, 41, 38,    47, 50, 53, 52, 51, 48, 45, 46,     49)
+
+#define LAYOUT_HARDWARE_TOP     ( 6,  7,  8,  9, 12, 13, 33, 34, 35, 36, 39, 40,    47, 48, 53, 52, 51, 50, 45, 46,     49)
+#define LAYOUT_HARDWARE_FRONT   (24, 23, 18, 17, 10,  9, 53, 48, 47, 40, 41, 42,     4,  3,  0,  1,  8,  7,  6,  5,      2)
+#define LAYOUT_HARDWARE_RIGHT   (18, 19, 20, 31, 32, 33, 51, 52, 53,  8,  1,  0,    17, 16, 15, 14, 13, 12,  9, 10,     11)
+#define LAYOUT_HARDWARE_BACK    (20, 21, 26, 44, 37, 36, 45, 50, 51, 13, 14, 15,    31, 30, 27, 28, 35, 34, 33, 32,     29)
+#define LAYOUT_HARDWARE_LEFT    (26, 25, 24,  4,  5,  6, 47, 46, 45, 35, 28, 27,    44, 43, 42, 41, 40, 39, 36, 37,     38)
+#define LAYOUT_HARDWARE_BOTTOM  (27, 30, 31, 15, 16, 17,  0,  3,  4, 42, 43, 44,    26, 21, 20, 19, 18, 23, 24, 25,     22)
+
+// Facelet indices affected by the move of each middle slice, for both
+// layouts: the 12 facelets around the slice, 3 per face, in counter-clockwise
+// order as seen from the face the slice turns as (see Rotation::Middle).
+#define LAYOUT_SIMULATOR_MIDDLE   (50, 49, 48, 14, 13, 12,  5,  4,  3, 30, 31, 32)
+#define LAYOUT_SIMULATOR_EQUATOR  (34, 31, 28, 25, 22, 19, 16, 13, 10, 43, 40, 37)
+#define LAYOUT_SIMULATOR_STANDING (46, 49, 52, 23, 22, 21,  7,  4,  1, 39, 40, 41)
+
+#define LAYOUT_HARDWARE_MIDDLE    (21, 22, 23,  3,  2,  7, 48, 49, 50, 34, 29, 30)
+#define LAYOUT_HARDWARE_EQUATOR   (28, 29, 32, 14, 11, 10,  1,  2,  5, 41, 38, 37)
+#define LAYOUT_HARDWARE_STANDING  (25, 22, 19, 16, 11, 12, 52, 49, 46, 39, 38, 43)
+
+// Lists of the layout of the cube this code is compiled for.
+#ifdef USE_SIMULATOR
+	#define LAYOUT_NATIVE_TOP	LAYOUT_SIMULATOR_TOP
+	#define LAYOUT_NATIVE_FRONT	LAYOUT_SIMULATOR_FRONT
+	#define LAYOUT_NATIVE_RIGHT	LAYOUT_SIMULATOR_RIGHT
+	#define LAYOUT_NATIVE_BACK	LAYOUT_SIMULATOR_BACK
+	#define LAYOUT_NATIVE_LEFT	LAYOUT_SIMULATOR_LEFT
+	#define LAYOUT_NATIVE_BOTTOM	LAYOUT_SIMULATOR_BOTTOM
+	#define LAYOUT_NATIVE_MIDDLE	LAYOUT_SIMULATOR_MIDDLE
+	#define LAYOUT_NATIVE_EQUATOR	LAYOUT_SIMULATOR_EQUATOR
+	#define LAYOUT_NATIVE_STANDING	LAYOUT_SIMULATOR_STANDING
+#else
+	#define LAYOUT_NATIVE_TOP	LAYOUT_HARDWARE_TOP
+	#define LAYOUT_NATIVE_FRONT	LAYOUT_HARDWARE_FRONT
+	#define LAYOUT_NATIVE_RIGHT	LAYOUT_HARDWARE_RIGHT
+	#define LAYOUT_NATIVE_BACK	LAYOUT_HARDWARE_BACK
+	#define LAYOUT_NATIVE_LEFT	LAYOUT_HARDWARE_LEFT
+	#define LAYOUT_NATIVE_BOTTOM	LAYOUT_HARDWARE_BOTTOM
+	#define LAYOUT_NATIVE_MIDDLE	LAYOUT_HARDWARE_MIDDLE
+	#define LAYOUT_NATIVE_EQUATOR	LAYOUT_HARDWARE_EQUATOR
+	#define LAYOUT_NATIVE_STANDING	LAYOUT_HARDWARE_STANDING
+#endif
+
+// Expands one of the lists above into an initializer of the form
+// {{side facelets}, {front facelets}, center}.
+#define LAYOUT_ROTATION_INITIALIZER(List) LAYOUT_ROTATION_INITIALIZER_ List
+#define LAYOUT_ROTATION_INITIALIZER_(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C) \
+	{{S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11}, {F0, F1, F2, F3, F4, F5, F6, F7}, C}
+
+// Expands one of the lists of the slices into an initializer of the form
+// {side facelets}.
+#define LAYOUT_SLICE_INITIALIZER(List) {LAYOUT_UNPACK_SLICE List}
+
+// Expands one of the lists above into an initializer of 7 bytes holding one
+// bit per facelet (bit i%8 of byte i/8 for facelet i), set for the 21
+// facelets affected by the rotation.
+#define LAYOUT_MASK_INITIALIZER(List) \
+	{LAYOUT_MASK_BYTE(0, List), LAYOUT_MASK_BYTE(1, List), LAYOUT_MASK_BYTE(2, List), LAYOUT_MASK_BYTE(3, List), \
+	 LAYOUT_MASK_BYTE(4, List), LAYOUT_MASK_BYTE(5, List), LAYOUT_MASK_BYTE(6, List)}
+#define LAYOUT_MASK_BYTE(Byte, List) LAYOUT_CALL(LAYOUT_MASK_BYTE_, (Byte, LAYOUT_UNPACK List))
+#define LAYOUT_MASK_BYTE_(Byte, S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C) \
+	(LAYOUT_MASK_BIT(Byte, S0) | LAYOUT_MASK_BIT(Byte, S1) | LAYOUT_MASK_BIT(Byte, S2)  | LAYOUT_MASK_BIT(Byte, S3)  | \
+	 LAYOUT_MASK_BIT(Byte, S4) | LAYOUT_MASK_BIT(Byte, S5) | LAYOUT_MASK_BIT(Byte, S6)  | LAYOUT_MASK_BIT(Byte, S7)  | \
+	 LAYOUT_MASK_BIT(Byte, S8) | LAYOUT_MASK_BIT(Byte, S9) | LAYOUT_MASK_BIT(Byte, S10) | LAYOUT_MASK_BIT(Byte, S11) | \
+	 LAYOUT_MASK_BIT(Byte, F0) | LAYOUT_MASK_BIT(Byte, F1) | LAYOUT_MASK_BIT(Byte, F2)  | LAYOUT_MASK_BIT(Byte, F3)  | \
+	 LAYOUT_MASK_BIT(Byte, F4) | LAYOUT_MASK_BIT(Byte, F5) | LAYOUT_MASK_BIT(Byte, F6)  | LAYOUT_MASK_BIT(Byte, F7)  | \
+	 LAYOUT_MASK_BIT(Byte, C))
+#define LAYOUT_MASK_BIT(Byte, Index) ((Index) / 8 == (Byte) ? 1 << ((Index) % 8) : 0)
+
+// Helpers to pass the content of a list as separate macro arguments.
+#define LAYOUT_CALL(Macro, Args) Macro Args
+#define LAYOUT_UNPACK(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C) \
+	S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, F0, F1, F2, F3, F4, F5, F6, F7, C
+#define LAYOUT_UNPACK_SLICE(S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11) \
+	S0, S1, S2, S3, S4, S5, S6, S7, S8, S9, S10, S11
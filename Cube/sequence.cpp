@@ -0,0 +1,105 @@
+#include "sequence.h"
+#include "config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+const uint8_t NumAxes      = 3;
+const uint8_t NumAxisMoves = 4;	// Moves of an axis, which all commute.
+
+// Clockwise moves of each axis, in the order they are written in a canonical
+// sequence: lower face, upper face, middle slice, whole cube.
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const Rotation::Type f_AxisMoves[NumAxes][NumAxisMoves] PROGMEM =
+{
+	{Rotation::Top,   Rotation::Bottom, Rotation::Equator,  Rotation::CubeY},
+	{Rotation::Front, Rotation::Back,   Rotation::Standing, Rotation::CubeZ},
+	{Rotation::Right, Rotation::Left,   Rotation::Middle,   Rotation::CubeX}
+};
+
+// Axis of each clockwise move, in the order of namespace Rotation, without
+// the counter-clockwise ones (Top to Bottom, then Middle to CubeZ).
+// This is stored in flash memory and must be accessed using pgm_read_byte().
+const uint8_t f_MoveAxes[Rotation::NumMoves / 2] PROGMEM =
+{
+	0, 1, 2, 1, 2, 0,
+	2, 0, 1, 2, 0, 1
+};
+
+// Axis of a move, and index of the move within f_AxisMoves[Axis], in the low
+// and high nibbles.
+uint8_t GetAxisAndSlot(Rotation::Type Move)
+{
+	Rotation::Type Clockwise = Rotation::GetClockwise(Move);
+	uint8_t Axis = pgm_read_byte(&f_MoveAxes[Clockwise < Rotation::NumRotations ? Clockwise : Clockwise - Rotation::CCW]);
+	uint8_t Slot = 0;
+	while (pgm_read_byte(&f_AxisMoves[Axis][Slot]) != Clockwise)
+		++Slot;
+	return Axis | (Slot << 4);
+}
+
+// Net clockwise quarter turns of a move (CCW counts as 3).
+uint8_t GetTurns(Rotation::Type Move)
+{
+	return (Rotation::GetClockwise(Move) == Move ? 1 : 3);
+}
+
+}
+
+namespace Sequence
+{
+
+// Append a move to a canonical sequence of Len moves, which stays canonical.
+// pSeq must have room for Len + 1 moves. Returns the new length.
+uint8_t Append(Rotation::Type* pSeq, uint8_t Len, Rotation::Type Move)
+{
+	uint8_t AxisAndSlot = GetAxisAndSlot(Move);
+	uint8_t Axis = AxisAndSlot & 0x0F;
+
+	// Remove the moves of the same axis at the end of the sequence and count
+	// their net clockwise quarter turns, modulo 4.
+	uint8_t Turns[NumAxisMoves] = {0, 0, 0, 0};
+	while (Len > 0)
+	{
+		Rotation::Type Last = pSeq[Len - 1];
+		uint8_t LastAxisAndSlot = GetAxisAndSlot(Last);
+		if ((LastAxisAndSlot & 0x0F) != Axis)
+			break;
+		Turns[LastAxisAndSlot >> 4] += GetTurns(Last);
+		--Len;
+	}
+	Turns[AxisAndSlot >> 4] += GetTurns(Move);
+
+	// Write back the net turns of each move of the axis, in canonical order.
+	for (uint8_t Slot = 0; Slot < NumAxisMoves; ++Slot)
+	{
+		Rotation::Type CurMove = pgm_read_byte(&f_AxisMoves[Axis][Slot]);
+		switch (Turns[Slot] & 3)
+		{
+		case 2:
+			pSeq[Len++] = CurMove;
+			// fall through
+		case 1:
+			pSeq[Len++] = CurMove;
+			break;
+		case 3:
+			pSeq[Len++] = CurMove + Rotation::CCW;
+			break;
+		}
+	}
+	return Len;
+}
+
+// Reduce a sequence of Len moves in place to its canonical form. Returns the
+// new length.
+uint8_t Canonicalize(Rotation::Type* pSeq, uint8_t Len)
+{
+	// The canonical prefix never grows faster than the input is read, so
+	// Append() only overwrites moves that have already been read.
+	uint8_t NewLen = 0;
+	for (uint8_t i = 0; i < Len; ++i)
+		NewLen = Append(pSeq, NewLen, pSeq[i]);
+	return NewLen;
+}
+
+}
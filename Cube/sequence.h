@@ -0,0 +1,24 @@
+#pragma once
+
+#include "cube.h"
+
+// Functions for reducing sequences of moves, such as the undo history or a
+// scramble, so that no move is wasted.
+//
+// A sequence is canonical when it contains no redundant moves: the moves of
+// a same axis (its two faces, its middle slice and the whole cube) commute,
+// so each run of moves of a same axis is reduced to the net number of quarter
+// turns of each of them, modulo 4, in this order, the face with the lowest
+// index first. A net turn is written X, X X or X'. Thus X X' cancels out,
+// X X X becomes X' and Top Bottom Top becomes Top Top Bottom.
+namespace Sequence
+{
+// Append a move to a canonical sequence of Len moves, which stays canonical.
+// pSeq must have room for Len + 1 moves. Returns the new length, which is
+// shorter than Len if the move cancels previous ones.
+uint8_t Append(Rotation::Type* pSeq, uint8_t Len, Rotation::Type Move);
+
+// Reduce a sequence of Len moves in place to its canonical form. Returns the
+// new length.
+uint8_t Canonicalize(Rotation::Type* pSeq, uint8_t Len);
+}
@@ -0,0 +1,272 @@
+#include "census.h"
+#include "optimal.h"
+#include "workstealing.h"
+#include "../Cube/config.h"
+#include <string.h>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Cubies::SCubies;
+using Census::SEntry;
+using Census::SShard;
+using Census::SBall;
+using Census::UnknownDistance;
+
+// The lowest bits of the hash select the shard, the next ones the slot.
+const unsigned NumShardBits     = 8;
+const size_t   NumShards        = size_t(1) << NumShardBits;
+const size_t   InitialShardSize = 1024;
+
+// States expanded by one task while building.
+const size_t ChunkSize = 4096;
+
+const unsigned DistanceShift = 56;
+const uint64_t EmptyCorners  = uint64_t(UnknownDistance) << DistanceShift;
+
+// Packed cubies of a state, as in SEntry.
+struct SKey
+{
+	uint64_t m_Edges;
+	uint64_t m_Corners;
+};
+
+inline SKey Pack(const SCubies& State)
+{
+	SKey Key = {0, 0};
+	for (uint8_t i = 0; i < Cubies::NumEdges; ++i)
+		Key.m_Edges |= uint64_t(State.m_Edges[i]) << (5 * i);
+	for (uint8_t i = 0; i < Cubies::NumCorners; ++i)
+		Key.m_Corners |= uint64_t(State.m_Corners[i]) << (6 * i);
+	return Key;
+}
+
+inline size_t GetHash(const SKey& Key)
+{
+	uint64_t H = (Key.m_Edges ^ Key.m_Corners * 0xC2B2AE3D27D4EB4Full) * 0x9E3779B97F4A7C15ull;
+	return size_t(H ^ (H >> 29));
+}
+
+inline uint8_t GetEntryDistance(const SEntry& Entry)
+{
+	return uint8_t(Entry.m_Corners >> DistanceShift);
+}
+
+inline bool IsEqual(const SEntry& Entry, const SKey& Key)
+{
+	return Entry.m_Edges == Key.m_Edges && (Entry.m_Corners & ~EmptyCorners) == Key.m_Corners;
+}
+
+// Add Key with Distance to the shard if it is not there already. Returns true
+// if it was added. The caller holds the lock of the shard.
+bool Insert(SShard& Shard, const SKey& Key, size_t Hash, uint8_t Distance);
+
+// Double the size of a shard, keeping it at most 3/4 full.
+void Grow(SShard& Shard)
+{
+	std::vector<SEntry> Old(Shard.m_Entries.size() * 2);
+	Old.swap(Shard.m_Entries);
+	for (SEntry& Entry : Shard.m_Entries)
+		Entry.m_Corners = EmptyCorners;
+	Shard.m_NumEntries = 0;
+	for (const SEntry& Entry : Old)
+	{
+		if (GetEntryDistance(Entry) == UnknownDistance)
+			continue;
+		SKey Key;
+		Key.m_Edges   = Entry.m_Edges;
+		Key.m_Corners = Entry.m_Corners & ~EmptyCorners;
+		Insert(Shard, Key, GetHash(Key), GetEntryDistance(Entry));
+	}
+}
+
+bool Insert(SShard& Shard, const SKey& Key, size_t Hash, uint8_t Distance)
+{
+	if (4 * (Shard.m_NumEntries + 1) > 3 * Shard.m_Entries.size())
+		Grow(Shard);
+	size_t Mask = Shard.m_Entries.size() - 1;
+	for (size_t Slot = (Hash >> NumShardBits) & Mask; ; Slot = (Slot + 1) & Mask)
+	{
+		SEntry& Entry = Shard.m_Entries[Slot];
+		if (GetEntryDistance(Entry) == UnknownDistance)
+		{
+			Entry.m_Edges   = Key.m_Edges;
+			Entry.m_Corners = Key.m_Corners | uint64_t(Distance) << DistanceShift;
+			++Shard.m_NumEntries;
+			return true;
+		}
+		if (IsEqual(Entry, Key))
+			return false;
+	}
+}
+
+// Add a state to the ball, locking its shard. Returns true if it was added.
+bool Insert(SBall& Ball, const SCubies& State, uint8_t Distance)
+{
+	SKey Key = Pack(State);
+	size_t Hash = GetHash(Key);
+	SShard& Shard = Ball.m_Shards[Hash & (NumShards - 1)];
+	std::lock_guard<std::mutex> Lock(Shard.m_Mutex);
+	return Insert(Shard, Key, Hash, Distance);
+}
+
+// Distance of a packed state in the ball, or UnknownDistance.
+uint8_t Find(const SBall& Ball, const SKey& Key, size_t Hash)
+{
+	const SShard& Shard = Ball.m_Shards[Hash & (NumShards - 1)];
+	size_t Mask = Shard.m_Entries.size() - 1;
+	for (size_t Slot = (Hash >> NumShardBits) & Mask; ; Slot = (Slot + 1) & Mask)
+	{
+		const SEntry& Entry = Shard.m_Entries[Slot];
+		if (GetEntryDistance(Entry) == UnknownDistance || IsEqual(Entry, Key))
+			return GetEntryDistance(Entry);
+	}
+}
+
+// Search the states exactly ToGo rotations away from State, in the canonical
+// order of Optimal::IsAllowed(). Returns true as soon as one is in the ball.
+bool SearchLeaves(const SBall& Ball, const SCubies& State, uint8_t ToGo, Rotation::Type PrevRot, Rotation::Type PrevPrevRot,
+                  uint64_t& NumNodes)
+{
+	if (ToGo > 1)
+	{
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			if (!Optimal::IsAllowed(Rot, PrevRot, PrevPrevRot))
+				continue;
+			SCubies Next = State;
+			Cubies::Apply(Next, Rot);
+			if (SearchLeaves(Ball, Next, ToGo - 1, Rot, PrevRot, NumNodes))
+				return true;
+		}
+		return false;
+	}
+
+	// The ball is far larger than the caches: the slots of all the leaves are
+	// fetched at once before being looked up.
+	SKey Keys[Rotation::NumRotations];
+	size_t Hashes[Rotation::NumRotations];
+	uint8_t NumLeaves = 0;
+	for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+	{
+		if (!Optimal::IsAllowed(Rot, PrevRot, PrevPrevRot))
+			continue;
+		SCubies Next = State;
+		Cubies::Apply(Next, Rot);
+		Keys[NumLeaves]   = Pack(Next);
+		Hashes[NumLeaves] = GetHash(Keys[NumLeaves]);
+		const SShard& Shard = Ball.m_Shards[Hashes[NumLeaves] & (NumShards - 1)];
+		__builtin_prefetch(&Shard.m_Entries[(Hashes[NumLeaves] >> NumShardBits) & (Shard.m_Entries.size() - 1)]);
+		++NumLeaves;
+	}
+	NumNodes += NumLeaves;
+	for (uint8_t LeafIdx = 0; LeafIdx < NumLeaves; ++LeafIdx)
+		if (Find(Ball, Keys[LeafIdx], Hashes[LeafIdx]) != UnknownDistance)
+			return true;
+	return false;
+}
+
+}
+
+namespace Census
+{
+
+// Build the ball of all states within Depth rotations of the solved cube.
+void Build(SBall& Ball, uint8_t Depth, unsigned NumThreads)
+{
+	assert(Depth <= MaxBallDepth && NumThreads > 0);
+	Ball.m_Depth = Depth;
+	std::vector<SShard>(NumShards).swap(Ball.m_Shards);
+	for (SShard& Shard : Ball.m_Shards)
+	{
+		SEntry Empty;
+		Empty.m_Edges   = 0;
+		Empty.m_Corners = EmptyCorners;
+		Shard.m_Entries.assign(InitialShardSize, Empty);
+		Shard.m_NumEntries = 0;
+	}
+	memset(Ball.m_NumStates, 0, sizeof(Ball.m_NumStates));
+
+	std::vector<SCubies> Frontier(1);
+	Cubies::Reset(Frontier[0]);
+	Insert(Ball, Frontier[0], 0);
+	Ball.m_NumStates[0] = 1;
+
+	// Each level is expanded in chunks, whose new states are kept apart until
+	// the level is done. The last level is not expanded.
+	for (uint8_t Distance = 0; Distance < Depth; ++Distance)
+	{
+		bool KeepNext = (Distance + 1 < Depth);
+		size_t NumChunks = (Frontier.size() + ChunkSize - 1) / ChunkSize;
+		std::vector<std::vector<SCubies> > NextPerChunk(NumChunks);
+		std::vector<uint64_t> NumNewPerChunk(NumChunks);
+		WorkStealing::Run(NumThreads, NumChunks, [&](size_t ChunkIdx, unsigned)
+		{
+			size_t Begin = ChunkIdx * ChunkSize;
+			size_t End   = (Begin + ChunkSize < Frontier.size() ? Begin + ChunkSize : Frontier.size());
+			uint64_t NumNew = 0;
+			for (size_t Idx = Begin; Idx < End; ++Idx)
+			{
+				for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+				{
+					SCubies Next = Frontier[Idx];
+					Cubies::Apply(Next, Rot);
+					if (!Insert(Ball, Next, Distance + 1))
+						continue;
+					++NumNew;
+					if (KeepNext)
+						NextPerChunk[ChunkIdx].push_back(Next);
+				}
+			}
+			NumNewPerChunk[ChunkIdx] = NumNew;
+		});
+
+		Frontier.clear();
+		for (size_t ChunkIdx = 0; ChunkIdx < NumChunks; ++ChunkIdx)
+		{
+			Ball.m_NumStates[Distance + 1] += NumNewPerChunk[ChunkIdx];
+			Frontier.insert(Frontier.end(), NextPerChunk[ChunkIdx].begin(), NextPerChunk[ChunkIdx].end());
+			std::vector<SCubies>().swap(NextPerChunk[ChunkIdx]);
+		}
+	}
+}
+
+// Bytes used by the hash tables.
+size_t GetMemorySize(const SBall& Ball)
+{
+	size_t Size = 0;
+	for (const SShard& Shard : Ball.m_Shards)
+		Size += Shard.m_Entries.size() * sizeof(SEntry);
+	return Size;
+}
+
+// Distance of a state that is in the ball, or UnknownDistance.
+uint8_t Find(const SBall& Ball, const Cubies::SCubies& State)
+{
+	SKey Key = Pack(State);
+	return ::Find(Ball, Key, GetHash(Key));
+}
+
+// Distance of a valid state, searching up to SearchDepth rotations from it.
+uint8_t GetDistance(const SBall& Ball, const Cubies::SCubies& State, uint8_t SearchDepth, SSearchStats& Stats)
+{
+	assert(Cubies::IsValid(State) && SearchDepth <= MaxSearchDepth);
+	++Stats.m_NumNodes;
+	uint8_t Distance = Find(Ball, State);
+	if (Distance != UnknownDistance)
+		return Distance;
+
+	// The state is farther than the ball. Searching the depths one after the
+	// other, the first states met are exactly on its border: their distance
+	// is Ball.m_Depth. Since every rotation changes the parity of the corner
+	// permutation, only every other depth can meet the ball.
+	uint8_t Depth = 1;
+	if ((Ball.m_Depth + Depth) % 2 != Cubies::IsOddPermutation(State.m_Corners, Cubies::NumCorners))
+		++Depth;
+	for (; Depth <= SearchDepth; Depth += 2)
+		if (SearchLeaves(Ball, State, Depth, Rotation::None, Rotation::None, Stats.m_NumNodes))
+			return Ball.m_Depth + Depth;
+	return UnknownDistance;
+}
+
+}
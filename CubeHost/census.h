@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+#include "../Cube/cube.h"
+#include "cubies.h"
+
+// Host-only: exact distance to the solved cube, in rotations (quarter turns),
+// of states up to about 14 rotations away, by meet-in-the-middle search.
+//
+// The "ball" holds every state within BallDepth rotations of the solved cube
+// with its distance. It is built by a breadth-first search on several
+// threads, into a hash set split into shards that each have their own lock,
+// so that threads rarely wait for each other. The distance of a state is then
+// found by searching from it, one depth after the other, until a state of the
+// ball is met: at most BallDepth more rotations are searched than with the
+// ball alone.
+namespace Census
+{
+const uint8_t MaxBallDepth = 8;		// About 86 million states, 2 GB.
+const uint8_t MaxSearchDepth = 10;	// Rotations searched from the state, about 10^10 nodes.
+const uint8_t UnknownDistance = 0xFF;	// Farther than the ball and the search.
+
+// State of the ball and its distance. The cubies of Cubies::SCubies are
+// packed as is, which is much cheaper than ranking them (Cubies::GetKey()).
+struct SEntry
+{
+	uint64_t m_Edges;		// 5 bits per edge.
+	uint64_t m_Corners;		// 6 bits per corner, and the distance in bits 56-63 (UnknownDistance if empty).
+};
+
+// Part of the ball, open-addressing hash table guarded by m_Mutex while
+// building.
+struct SShard
+{
+	std::mutex          m_Mutex;
+	std::vector<SEntry> m_Entries;	// Size is a power of two.
+	size_t              m_NumEntries;
+};
+
+struct SBall
+{
+	uint8_t             m_Depth;
+	std::vector<SShard> m_Shards;
+	uint64_t            m_NumStates[MaxBallDepth + 1];	// Number of states at each distance.
+};
+
+struct SSearchStats
+{
+	uint64_t m_NumNodes;		// Nodes searched, each looked up in the ball.
+};
+
+// Build the ball of all states within Depth rotations of the solved cube, on
+// NumThreads threads.
+void Build(SBall& Ball, uint8_t Depth, unsigned NumThreads);
+size_t GetMemorySize(const SBall& Ball);	// Bytes used by the hash tables.
+
+// Distance of a state that is in the ball, or UnknownDistance.
+uint8_t Find(const SBall& Ball, const Cubies::SCubies& State);
+
+// Distance of a valid state, searching up to SearchDepth rotations from it
+// (at most MaxSearchDepth). Returns UnknownDistance if it is farther than
+// Ball.m_Depth + SearchDepth. The ball can be shared by several threads.
+uint8_t GetDistance(const SBall& Ball, const Cubies::SCubies& State, uint8_t SearchDepth, SSearchStats& Stats);
+}
@@ -0,0 +1,203 @@
+#include "corpus.h"
+#include "../Cube/config.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Corpus::SHeader;
+
+const char Magic[sizeof(SHeader().m_Magic)] = {'R', 'U', 'B', 'I', 'K', 'C', 'R', 'P'};
+
+const size_t FileBufferSize = 1 << 20;	// Buffer of the written files.
+
+// Returns true if the header describes a valid corpus of the given size.
+bool IsValid(const SHeader& Header, size_t FileSize)
+{
+	if (memcmp(Header.m_Magic, Magic, sizeof(Magic)) != 0 || Header.m_Version != Corpus::Version)
+		return false;
+	if (Header.m_Layout >= Layout::NumLayouts || Header.m_Encoding >= Corpus::NumEncodings)
+		return false;
+	if (Header.m_RecordSize != Corpus::GetRecordSize(Header.m_Encoding))
+		return false;
+	return Header.m_NumRecords <= (FileSize - Corpus::HeaderSize) / Header.m_RecordSize;
+}
+
+}
+
+namespace Corpus
+{
+
+size_t GetRecordSize(Encoding Enc)
+{
+	assert(Enc < NumEncodings);
+	return (Enc == FaceletsEncoding ? FaceletsRecordSize : CubiesRecordSize);
+}
+
+// Facelets --> FaceletsEncoding.
+void Pack(const Facelet::Type* pFacelets, uint8_t* pRecord)
+{
+	uint16_t Bits = 0;
+	uint8_t NumBits = 0;
+	for (uint8_t i = 0; i < Cube::NumFacelets; ++i)
+	{
+		assert(pFacelets[i] < Facelet::Bright);
+		Bits |= pFacelets[i] << NumBits;
+		NumBits += 3;
+		if (NumBits >= 8)
+		{
+			*pRecord++ = uint8_t(Bits);
+			Bits >>= 8;
+			NumBits -= 8;
+		}
+	}
+	*pRecord = uint8_t(Bits);
+}
+
+// FaceletsEncoding --> facelets.
+void Unpack(const uint8_t* pRecord, Facelet::Type* pFacelets)
+{
+	uint16_t Bits = 0;
+	uint8_t NumBits = 0;
+	for (uint8_t i = 0; i < Cube::NumFacelets; ++i)
+	{
+		if (NumBits < 3)
+		{
+			Bits |= *pRecord++ << NumBits;
+			NumBits += 8;
+		}
+		pFacelets[i] = Bits & 7;
+		Bits >>= 3;
+		NumBits -= 3;
+	}
+}
+
+// Map the given file. Returns false if it cannot be read or is not a valid
+// corpus.
+bool Open(SReader& Reader, const char* pPath)
+{
+	memset(&Reader, 0, sizeof(Reader));
+	int File = open(pPath, O_RDONLY);
+	if (File < 0)
+		return false;
+
+	struct stat Stat;
+	void* pData = MAP_FAILED;
+	if (fstat(File, &Stat) == 0 && size_t(Stat.st_size) >= HeaderSize)
+		pData = mmap(NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);	// The mapping stays valid.
+	if (pData == MAP_FAILED)
+		return false;
+
+	Reader.m_pData    = static_cast<const uint8_t*>(pData);
+	Reader.m_Size     = Stat.st_size;
+	Reader.m_pHeader  = static_cast<const SHeader*>(pData);
+	Reader.m_pRecords = Reader.m_pData + HeaderSize;
+	if (!IsValid(*Reader.m_pHeader, Reader.m_Size))
+	{
+		Close(Reader);
+		return false;
+	}
+
+	// Records are usually read in order, let the kernel read ahead.
+	madvise(pData, Reader.m_Size, MADV_SEQUENTIAL);
+	return true;
+}
+
+void Close(SReader& Reader)
+{
+	if (Reader.m_pData != NULL)
+		munmap(const_cast<uint8_t*>(Reader.m_pData), Reader.m_Size);
+	memset(&Reader, 0, sizeof(Reader));
+}
+
+// Facelets of a record, whatever the encoding. Returns false if a
+// CubiesEncoding record is not a valid cube.
+bool GetFacelets(const SReader& Reader, uint64_t RecordIdx, Facelet::Type* pFacelets)
+{
+	const uint8_t* pRecord = GetRecord(Reader, RecordIdx);
+	if (Reader.m_pHeader->m_Encoding == FaceletsEncoding)
+	{
+		Unpack(pRecord, pFacelets);
+		return true;
+	}
+
+	const Cubies::SCubies& State = *reinterpret_cast<const Cubies::SCubies*>(pRecord);
+	if (!Cubies::IsValid(State))
+		return false;
+	Cubies::ToFacelets(Reader.m_pHeader->m_Layout, State, pFacelets);
+	return true;
+}
+
+// Create a corpus file. Returns false if it cannot be created.
+bool Create(SWriter& Writer, const char* pPath, Layout::Type L, Encoding Enc)
+{
+	STATIC_ASSERT(sizeof(SHeader) == HeaderSize, "The header must have a fixed size.");
+	assert(L < Layout::NumLayouts);
+
+	memset(&Writer.m_Header, 0, sizeof(Writer.m_Header));
+	memcpy(Writer.m_Header.m_Magic, Magic, sizeof(Magic));
+	Writer.m_Header.m_Version    = Version;
+	Writer.m_Header.m_Layout     = L;
+	Writer.m_Header.m_Encoding   = Enc;
+	Writer.m_Header.m_RecordSize = uint16_t(GetRecordSize(Enc));
+
+	// The header is written again by Close() with the number of records.
+	Writer.m_pFile = fopen(pPath, "wb");
+	if (Writer.m_pFile == NULL)
+		return false;
+	setvbuf(Writer.m_pFile, NULL, _IOFBF, FileBufferSize);
+	if (fwrite(&Writer.m_Header, sizeof(Writer.m_Header), 1, Writer.m_pFile) != 1)
+	{
+		fclose(Writer.m_pFile);
+		Writer.m_pFile = NULL;
+		return false;
+	}
+	return true;
+}
+
+// Append one state. With CubiesEncoding, the facelets are converted and false
+// is returned if they do not describe a valid cube.
+bool Write(SWriter& Writer, const Facelet::Type* pFacelets)
+{
+	if (Writer.m_Header.m_Encoding == CubiesEncoding)
+	{
+		Cubies::SCubies State;
+		return Cubies::FromFacelets(Writer.m_Header.m_Layout, pFacelets, State) && Write(Writer, State);
+	}
+
+	uint8_t Record[FaceletsRecordSize];
+	Pack(pFacelets, Record);
+	++Writer.m_Header.m_NumRecords;
+	return fwrite(Record, sizeof(Record), 1, Writer.m_pFile) == 1;
+}
+
+bool Write(SWriter& Writer, const Cubies::SCubies& State)
+{
+	if (Writer.m_Header.m_Encoding == FaceletsEncoding)
+	{
+		Facelet::Type Facelets[Cube::NumFacelets];
+		Cubies::ToFacelets(Writer.m_Header.m_Layout, State, Facelets);
+		return Write(Writer, Facelets);
+	}
+
+	++Writer.m_Header.m_NumRecords;
+	return fwrite(&State, sizeof(State), 1, Writer.m_pFile) == 1;
+}
+
+// Write the final header and close the file. Returns false on I/O errors.
+bool Close(SWriter& Writer)
+{
+	bool Ok = (ferror(Writer.m_pFile) == 0);
+	Ok = Ok && fseek(Writer.m_pFile, 0, SEEK_SET) == 0;
+	Ok = Ok && fwrite(&Writer.m_Header, sizeof(Writer.m_Header), 1, Writer.m_pFile) == 1;
+	Ok = (fclose(Writer.m_pFile) == 0) && Ok;
+	Writer.m_pFile = NULL;
+	return Ok;
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+#include "cubies.h"
+
+// Host-only: binary file of cube states ("corpus"), made of a 32-byte header
+// followed by fixed-width records. All fields are little-endian. Records
+// start at offset HeaderSize and can be read in place from a memory-mapped
+// file, without parsing.
+namespace Corpus
+{
+typedef uint8_t Encoding;
+
+// 3 bits per facelet (its Facelet::Type color, brightness is not stored),
+// facelet i at bits 3*i to 3*i+2 of the record read as a little-endian
+// integer. The facelets are in the LED order of the layout of the header.
+const Encoding FaceletsEncoding = 0;
+
+// A Cubies::SCubies structure as is (cubie | orientation << OriShift for
+// each corner then each edge). Records can be used directly as SCubies.
+const Encoding CubiesEncoding = 1;
+
+const Encoding NumEncodings = 2;
+
+const size_t FaceletsRecordSize = (3 * Cube::NumFacelets + 7) / 8;	// 21 bytes
+const size_t CubiesRecordSize   = sizeof(Cubies::SCubies);		// 20 bytes
+
+const uint32_t Version    = 1;
+const size_t   HeaderSize = 32;
+
+struct SHeader
+{
+	char     m_Magic[8];		// "RUBIKCRP"
+	uint32_t m_Version;		// Corpus::Version
+	uint8_t  m_Layout;		// Layout::Type of the facelets (also used to convert cubies to facelets).
+	uint8_t  m_Encoding;		// Encoding of the records.
+	uint16_t m_RecordSize;		// Size of one record, in bytes.
+	uint64_t m_NumRecords;
+	uint8_t  m_Reserved[8];		// Always 0.
+};
+
+// Memory-mapped corpus being read.
+struct SReader
+{
+	const uint8_t* m_pData;		// Whole file.
+	size_t         m_Size;
+	const SHeader* m_pHeader;
+	const uint8_t* m_pRecords;	// First record.
+};
+
+// Corpus being written, through a buffered file.
+struct SWriter
+{
+	FILE*   m_pFile;
+	SHeader m_Header;
+};
+
+size_t GetRecordSize(Encoding Enc);
+
+// Conversions between the facelets and the FaceletsEncoding.
+void Pack(const Facelet::Type* pFacelets, uint8_t* pRecord);
+void Unpack(const uint8_t* pRecord, Facelet::Type* pFacelets);
+
+// Map the given file. Returns false if it cannot be read or is not a valid
+// corpus.
+bool Open(SReader& Reader, const char* pPath);
+void Close(SReader& Reader);
+
+// Access to records, without copy. GetCubies() requires CubiesEncoding.
+inline uint64_t GetNumRecords(const SReader& Reader)
+{
+	return Reader.m_pHeader->m_NumRecords;
+}
+
+inline const uint8_t* GetRecord(const SReader& Reader, uint64_t RecordIdx)
+{
+	assert(RecordIdx < GetNumRecords(Reader));
+	return Reader.m_pRecords + RecordIdx * Reader.m_pHeader->m_RecordSize;
+}
+
+inline const Cubies::SCubies& GetCubies(const SReader& Reader, uint64_t RecordIdx)
+{
+	assert(Reader.m_pHeader->m_Encoding == CubiesEncoding);
+	return *reinterpret_cast<const Cubies::SCubies*>(GetRecord(Reader, RecordIdx));
+}
+
+// Facelets of a record, whatever the encoding. Returns false if a CubiesEncoding
+// record is not a valid cube.
+bool GetFacelets(const SReader& Reader, uint64_t RecordIdx, Facelet::Type* pFacelets);
+
+// Create a corpus file. Returns false if it cannot be created.
+bool Create(SWriter& Writer, const char* pPath, Layout::Type L, Encoding Enc);
+
+// Append one state. With CubiesEncoding, the facelets are converted and
+// false is returned if they do not describe a valid cube.
+bool Write(SWriter& Writer, const Facelet::Type* pFacelets);
+bool Write(SWriter& Writer, const Cubies::SCubies& State);
+
+// Write the final header and close the file. Returns false on I/O errors.
+bool Close(SWriter& Writer);
+}
@@ -0,0 +1,443 @@
+#include "cubies.h"
+#include "permutation.h"
+#include "../Cube/config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Cubies::SCubies;
+using Cubies::NumCorners;
+using Cubies::NumEdges;
+using Cubies::CubieMask;
+using Cubies::OriShift;
+
+const uint8_t Invalid = 0xFF;
+
+const uint8_t U = Rotation::Top;
+const uint8_t F = Rotation::Front;
+const uint8_t R = Rotation::Right;
+const uint8_t B = Rotation::Back;
+const uint8_t L = Rotation::Left;
+const uint8_t D = Rotation::Bottom;
+
+// Faces of each corner and edge cubie, in the order of their definition in
+// cubies.h. A cubie with orientation 0 has its first face on the first face
+// of its position.
+const uint8_t g_CornerFaces[NumCorners][3] =
+{
+	{U, R, F}, {U, F, L}, {U, L, B}, {U, B, R},
+	{D, F, R}, {D, L, F}, {D, B, L}, {D, R, B}
+};
+const uint8_t g_EdgeFaces[NumEdges][2] =
+{
+	{U, R}, {U, F}, {U, L}, {U, B},
+	{D, R}, {D, F}, {D, L}, {D, B},
+	{F, R}, {F, L}, {B, L}, {B, R}
+};
+
+// Facelet indices of each cubie position for one layout.
+struct SFaceletMap
+{
+	uint8_t m_Corners[NumCorners][3];
+	uint8_t m_Edges[NumEdges][2];
+	uint8_t m_Centers[Cube::NumFaces];
+};
+
+// All tables, built on first use.
+struct STables
+{
+	SFaceletMap m_Maps[Layout::NumLayouts];
+
+	// Face triplet (or pair) seen on a position --> cubie | orientation << OriShift.
+	uint8_t m_CornerLut[Cube::NumFaces][Cube::NumFaces][Cube::NumFaces];
+	uint8_t m_EdgeLut[Cube::NumFaces][Cube::NumFaces];
+
+	SCubies m_Rotations[Rotation::NumRotations];
+
+	STables();
+};
+
+bool Contains(const uint8_t* pIndices, uint8_t NumIndices, uint8_t Index)
+{
+	for (uint8_t i = 0; i < NumIndices; ++i)
+		if (pIndices[i] == Index)
+			return true;
+	return false;
+}
+
+// Find the facelet on the front of Face that is also on the side of all the
+// faces in pNeighbors, and on no other side except the opposite face's.
+uint8_t FindFacelet(Layout::Type Lay, uint8_t Face, const uint8_t* pNeighbors, uint8_t NumNeighbors)
+{
+	const Permutation::SRotationIndices& Front = Permutation::GetRotationIndices(Lay, Face);
+	for (uint8_t i = 0; i < Cube::NumFrontFacelets; ++i)
+	{
+		uint8_t Index = Front.m_Front[i];
+		uint8_t NumSides = 0;
+		bool IsMatch = true;
+		for (uint8_t Other = 0; Other < Cube::NumFaces; ++Other)
+		{
+			const Permutation::SRotationIndices& Side = Permutation::GetRotationIndices(Lay, Other);
+			if (!Contains(Side.m_Side, Cube::NumSideFacelets, Index))
+				continue;
+			++NumSides;
+			if (!Contains(pNeighbors, NumNeighbors, Other))
+				IsMatch = false;
+		}
+		if (IsMatch && NumSides == NumNeighbors)
+			return Index;
+	}
+	assert(false);
+	return Invalid;
+}
+
+// Color of the given face in the solved state.
+Facelet::Type GetFaceColor(const SFaceletMap& Map, uint8_t Face)
+{
+	// Numerical order of colors in Facelet match initialization order.
+	return Map.m_Centers[Face] / Cube::NumFaceletsPerFace + 1;
+}
+
+bool FromFacelets(const STables& Tables, Layout::Type Lay, const Facelet::Type* pFacelets, SCubies& State)
+{
+	const SFaceletMap& Map = Tables.m_Maps[Lay];
+
+	// Centers never move: they give the color of each face.
+	uint8_t ColorToFace[Facelet::Bright];
+	for (uint8_t Color = 0; Color < Facelet::Bright; ++Color)
+		ColorToFace[Color] = Invalid;
+	for (uint8_t Face = 0; Face < Cube::NumFaces; ++Face)
+	{
+		Facelet::Type Color = GetFaceColor(Map, Face);
+		if ((pFacelets[Map.m_Centers[Face]] & ~Facelet::Bright) != Color)
+			return false;
+		ColorToFace[Color] = Face;
+	}
+
+	uint8_t Faces[3];
+	for (uint8_t Pos = 0; Pos < NumCorners; ++Pos)
+	{
+		for (uint8_t k = 0; k < 3; ++k)
+			if ((Faces[k] = ColorToFace[pFacelets[Map.m_Corners[Pos][k]] & ~Facelet::Bright]) == Invalid)
+				return false;
+		if ((State.m_Corners[Pos] = Tables.m_CornerLut[Faces[0]][Faces[1]][Faces[2]]) == Invalid)
+			return false;
+	}
+	for (uint8_t Pos = 0; Pos < NumEdges; ++Pos)
+	{
+		for (uint8_t k = 0; k < 2; ++k)
+			if ((Faces[k] = ColorToFace[pFacelets[Map.m_Edges[Pos][k]] & ~Facelet::Bright]) == Invalid)
+				return false;
+		if ((State.m_Edges[Pos] = Tables.m_EdgeLut[Faces[0]][Faces[1]]) == Invalid)
+			return false;
+	}
+
+	return Cubies::IsValid(State);
+}
+
+STables::STables()
+{
+	// Find the facelets of each cubie position from the rotation indices.
+	for (Layout::Type Lay = 0; Lay < Layout::NumLayouts; ++Lay)
+	{
+		SFaceletMap& Map = m_Maps[Lay];
+		for (uint8_t Face = 0; Face < Cube::NumFaces; ++Face)
+			Map.m_Centers[Face] = Permutation::GetRotationIndices(Lay, Face).m_Center;
+		for (uint8_t Pos = 0; Pos < NumCorners; ++Pos)
+			for (uint8_t k = 0; k < 3; ++k)
+			{
+				const uint8_t Neighbors[2] = { g_CornerFaces[Pos][(k + 1) % 3], g_CornerFaces[Pos][(k + 2) % 3] };
+				Map.m_Corners[Pos][k] = FindFacelet(Lay, g_CornerFaces[Pos][k], Neighbors, 2);
+			}
+		for (uint8_t Pos = 0; Pos < NumEdges; ++Pos)
+			for (uint8_t k = 0; k < 2; ++k)
+				Map.m_Edges[Pos][k] = FindFacelet(Lay, g_EdgeFaces[Pos][k], &g_EdgeFaces[Pos][1 - k], 1);
+	}
+
+	// Sticker k of a cubie with orientation Ori lies on facelet (k + Ori) of its position.
+	for (uint8_t i = 0; i < Cube::NumFaces; ++i)
+		for (uint8_t j = 0; j < Cube::NumFaces; ++j)
+		{
+			m_EdgeLut[i][j] = Invalid;
+			for (uint8_t k = 0; k < Cube::NumFaces; ++k)
+				m_CornerLut[i][j][k] = Invalid;
+		}
+	for (uint8_t Cubie = 0; Cubie < NumCorners; ++Cubie)
+		for (uint8_t Ori = 0; Ori < 3; ++Ori)
+		{
+			const uint8_t* pFaces = g_CornerFaces[Cubie];
+			m_CornerLut[pFaces[(3 - Ori) % 3]][pFaces[(4 - Ori) % 3]][pFaces[(5 - Ori) % 3]] = Cubie | (Ori << OriShift);
+		}
+	for (uint8_t Cubie = 0; Cubie < NumEdges; ++Cubie)
+		for (uint8_t Ori = 0; Ori < 2; ++Ori)
+		{
+			const uint8_t* pFaces = g_EdgeFaces[Cubie];
+			m_EdgeLut[pFaces[Ori]][pFaces[1 - Ori]] = Cubie | (Ori << OriShift);
+		}
+
+	// Rotations are the same in both layouts, use the first one.
+	for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+	{
+		Permutation::SFacelets Facelets;
+		Permutation::Reset(Facelets);
+		Permutation::Apply(Facelets, Layout::Simulator, Rot);
+		bool IsValid = FromFacelets(*this, Layout::Simulator, Facelets.m_Facelets, m_Rotations[Rot]);
+		assert(IsValid);
+		(void)IsValid;
+	}
+}
+
+const STables& GetTables()
+{
+	static const STables s_Tables;
+	return s_Tables;
+}
+
+}
+
+namespace Cubies
+{
+
+// Reset cube to solved state.
+void Reset(SCubies& State)
+{
+	for (uint8_t i = 0; i < NumCorners; ++i)
+		State.m_Corners[i] = i;
+	for (uint8_t i = 0; i < NumEdges; ++i)
+		State.m_Edges[i] = i;
+}
+
+// Returns true if the cube is in the solved state.
+bool IsSolved(const SCubies& State)
+{
+	for (uint8_t i = 0; i < NumCorners; ++i)
+		if (State.m_Corners[i] != i)
+			return false;
+	for (uint8_t i = 0; i < NumEdges; ++i)
+		if (State.m_Edges[i] != i)
+			return false;
+	return true;
+}
+
+// Returns true if the state is reachable by rotations: each cubie appears
+// once, the orientations sum to 0 and both permutations have the same parity.
+bool IsValid(const SCubies& State)
+{
+	uint16_t Seen = 0;
+	uint8_t Twist = 0;
+	for (uint8_t i = 0; i < NumCorners; ++i)
+	{
+		uint8_t Cubie = State.m_Corners[i] & CubieMask;
+		uint8_t Ori = State.m_Corners[i] >> OriShift;
+		if (Cubie >= NumCorners || Ori >= 3 || (Seen & (1u << Cubie)))
+			return false;
+		Seen |= (1u << Cubie);
+		Twist += Ori;
+	}
+
+	Seen = 0;
+	uint8_t Flip = 0;
+	for (uint8_t i = 0; i < NumEdges; ++i)
+	{
+		uint8_t Cubie = State.m_Edges[i] & CubieMask;
+		uint8_t Ori = State.m_Edges[i] >> OriShift;
+		if (Cubie >= NumEdges || Ori >= 2 || (Seen & (1u << Cubie)))
+			return false;
+		Seen |= (1u << Cubie);
+		Flip += Ori;
+	}
+
+	return Twist % 3 == 0 && Flip % 2 == 0 &&
+	       IsOddPermutation(State.m_Corners, NumCorners) == IsOddPermutation(State.m_Edges, NumEdges);
+}
+
+// State after rotating a solved cube.
+const SCubies& GetRotation(Rotation::Type Rot)
+{
+	assert(Rotation::IsRotation(Rot));
+	return GetTables().m_Rotations[Rot];
+}
+
+// State A followed by the moves of state B: the cubie at position i comes
+// from position B[i] of A, twisted by both orientations.
+void Multiply(const SCubies& A, const SCubies& B, SCubies& Result)
+{
+	assert(&Result != &A && &Result != &B);
+	for (uint8_t i = 0; i < NumCorners; ++i)
+	{
+		uint8_t CubieB = B.m_Corners[i];
+		uint8_t CubieA = A.m_Corners[CubieB & CubieMask];
+		uint8_t Ori = (CubieA >> OriShift) + (CubieB >> OriShift);
+		if (Ori >= 3)
+			Ori -= 3;
+		Result.m_Corners[i] = (CubieA & CubieMask) | (Ori << OriShift);
+	}
+	for (uint8_t i = 0; i < NumEdges; ++i)
+	{
+		uint8_t CubieB = B.m_Edges[i];
+		uint8_t CubieA = A.m_Edges[CubieB & CubieMask];
+		Result.m_Edges[i] = CubieA ^ (CubieB & ~CubieMask);
+	}
+}
+
+// Apply one rotation.
+void Apply(SCubies& State, Rotation::Type Rot)
+{
+	SCubies Old = State;
+	Multiply(Old, GetRotation(Rot), State);
+}
+
+// Apply a sequence of rotations.
+void Apply(SCubies& State, const Rotation::Type* pRots, size_t NumRots)
+{
+	const SCubies* pRotations = GetTables().m_Rotations;
+	for (size_t i = 0; i < NumRots; ++i)
+	{
+		assert(Rotation::IsRotation(pRots[i]));
+		SCubies Old = State;
+		Multiply(Old, pRotations[pRots[i]], State);
+	}
+}
+
+// Convert 54 facelets in LED order of the given layout. Brightness is ignored.
+// Returns false if the facelets do not describe a valid cube.
+bool FromFacelets(Layout::Type L, const Facelet::Type* pFacelets, SCubies& State)
+{
+	assert(L < Layout::NumLayouts);
+	return ::FromFacelets(GetTables(), L, pFacelets, State);
+}
+
+// Convert to 54 facelets in LED order of the given layout, all dimmed.
+void ToFacelets(Layout::Type L, const SCubies& State, Facelet::Type* pFacelets)
+{
+	assert(L < Layout::NumLayouts);
+	const SFaceletMap& Map = GetTables().m_Maps[L];
+
+	for (uint8_t Face = 0; Face < Cube::NumFaces; ++Face)
+		pFacelets[Map.m_Centers[Face]] = GetFaceColor(Map, Face);
+	for (uint8_t Pos = 0; Pos < NumCorners; ++Pos)
+	{
+		uint8_t Cubie = State.m_Corners[Pos] & CubieMask;
+		uint8_t Ori = State.m_Corners[Pos] >> OriShift;
+		for (uint8_t k = 0; k < 3; ++k)
+			pFacelets[Map.m_Corners[Pos][(k + Ori) % 3]] = GetFaceColor(Map, g_CornerFaces[Cubie][k]);
+	}
+	for (uint8_t Pos = 0; Pos < NumEdges; ++Pos)
+	{
+		uint8_t Cubie = State.m_Edges[Pos] & CubieMask;
+		uint8_t Ori = State.m_Edges[Pos] >> OriShift;
+		for (uint8_t k = 0; k < 2; ++k)
+			pFacelets[Map.m_Edges[Pos][(k + Ori) % 2]] = GetFaceColor(Map, g_EdgeFaces[Cubie][k]);
+	}
+}
+
+// Returns true if the permutation has an odd number of inversions.
+bool IsOddPermutation(const uint8_t* pCubies, uint8_t N)
+{
+	bool Odd = false;
+	for (uint8_t i = 0; i < N; ++i)
+		for (uint8_t j = i + 1; j < N; ++j)
+			if ((pCubies[j] & CubieMask) < (pCubies[i] & CubieMask))
+				Odd = !Odd;
+	return Odd;
+}
+
+// Returns the rank of a permutation of N elements, in [0, N![.
+uint64_t RankPermutation(const uint8_t* pCubies, uint8_t N)
+{
+	uint64_t Rank = 0;
+	for (uint8_t i = 0; i < N; ++i)
+	{
+		uint8_t NumSmaller = 0;
+		for (uint8_t j = i + 1; j < N; ++j)
+			if ((pCubies[j] & CubieMask) < (pCubies[i] & CubieMask))
+				++NumSmaller;
+		Rank = Rank * (N - i) + NumSmaller;
+	}
+	return Rank;
+}
+
+// Inverse of RankPermutation(). Orientations are cleared.
+void UnrankPermutation(uint64_t Rank, uint8_t* pCubies, uint8_t N)
+{
+	// Recover the Lehmer code, last digit first.
+	uint8_t Code[NumEdges];
+	for (uint8_t i = N; i-- > 0; )
+	{
+		Code[i] = uint8_t(Rank % (N - i));
+		Rank /= (N - i);
+	}
+
+	uint16_t Unused = uint16_t((1u << N) - 1);
+	for (uint8_t i = 0; i < N; ++i)
+	{
+		uint8_t Cubie = 0;
+		for (uint8_t Count = Code[i]; ; ++Cubie)
+			if ((Unused & (1u << Cubie)) && Count-- == 0)
+				break;
+		Unused &= ~(1u << Cubie);
+		pCubies[i] = Cubie;
+	}
+}
+
+// Orientations of the corners in base 3, the last one is implied by the others.
+uint16_t GetTwist(const SCubies& State)
+{
+	uint16_t Twist = 0;
+	for (uint8_t i = 0; i < NumCorners - 1; ++i)
+		Twist = Twist * 3 + (State.m_Corners[i] >> OriShift);
+	return Twist;
+}
+
+void SetTwist(SCubies& State, uint16_t Twist)
+{
+	uint8_t TwistSum = 0;
+	for (uint8_t i = NumCorners - 1; i-- > 0; )
+	{
+		uint8_t Ori = uint8_t(Twist % 3);
+		Twist /= 3;
+		TwistSum += Ori;
+		State.m_Corners[i] = (State.m_Corners[i] & CubieMask) | Ori << OriShift;
+	}
+	State.m_Corners[NumCorners - 1] = (State.m_Corners[NumCorners - 1] & CubieMask) | ((3 - TwistSum % 3) % 3) << OriShift;
+}
+
+// Orientations of the edges in base 2, the last one is implied by the others.
+uint16_t GetFlip(const SCubies& State)
+{
+	uint16_t Flip = 0;
+	for (uint8_t i = 0; i < NumEdges - 1; ++i)
+		Flip = Flip * 2 + (State.m_Edges[i] >> OriShift);
+	return Flip;
+}
+
+void SetFlip(SCubies& State, uint16_t Flip)
+{
+	uint8_t FlipSum = 0;
+	for (uint8_t i = NumEdges - 1; i-- > 0; )
+	{
+		uint8_t Ori = uint8_t(Flip % 2);
+		Flip /= 2;
+		FlipSum += Ori;
+		State.m_Edges[i] = (State.m_Edges[i] & CubieMask) | Ori << OriShift;
+	}
+	State.m_Edges[NumEdges - 1] = (State.m_Edges[NumEdges - 1] & CubieMask) | (FlipSum % 2) << OriShift;
+}
+
+SKey GetKey(const SCubies& State)
+{
+	SKey Key;
+	Key.m_Corners = uint32_t(RankPermutation(State.m_Corners, NumCorners)) * NumTwists + GetTwist(State);
+	Key.m_Edges   = RankPermutation(State.m_Edges, NumEdges) * NumFlips + GetFlip(State);
+	return Key;
+}
+
+void FromKey(const SKey& Key, SCubies& State)
+{
+	UnrankPermutation(Key.m_Corners / NumTwists, State.m_Corners, NumCorners);
+	UnrankPermutation(Key.m_Edges / NumFlips, State.m_Edges, NumEdges);
+	SetTwist(State, uint16_t(Key.m_Corners % NumTwists));
+	SetFlip(State, uint16_t(Key.m_Edges % NumFlips));
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+
+// Host-only: cube state described by the position and orientation of its 8
+// corner cubies and 12 edge cubies, instead of the color of its 54 facelets.
+namespace Cubies
+{
+const uint8_t NumCorners = 8;
+const uint8_t NumEdges   = 12;
+
+// Corner positions (and the cubies solved there). Faces are listed in
+// clockwise order, starting with the top or bottom face.
+const uint8_t URF = 0, UFL = 1, ULB = 2, UBR = 3, DFR = 4, DLF = 5, DBL = 6, DRB = 7;
+
+// Edge positions (and the cubies solved there).
+const uint8_t UR = 0, UF = 1, UL = 2, UB = 3, DR =  4, DF =  5, DL =  6, DB =  7;
+const uint8_t FR = 8, FL = 9, BL = 10, BR = 11;
+
+// Each byte holds the index of the cubie at that position (bits 0-3) and its
+// orientation (bits 4-7): the number of clockwise twists (corners, 0-2) or
+// whether it is flipped (edges, 0-1).
+const uint8_t CubieMask = 0x0F;
+const uint8_t OriShift  = 4;
+
+// Cube state at the cubie level, 20 bytes.
+struct SCubies
+{
+	uint8_t m_Corners[NumCorners];
+	uint8_t m_Edges[NumEdges];
+};
+
+// Dense key identifying a state, suitable for hashing and sorting.
+// m_Corners = rank of the corner permutation * 3^7 + corner twists (< 2^27).
+// m_Edges   = rank of the edge permutation * 2^11 + edge flips (< 2^40).
+struct SKey
+{
+	uint32_t m_Corners;
+	uint64_t m_Edges;
+};
+
+inline bool operator==(const SKey& A, const SKey& B)
+{
+	return A.m_Corners == B.m_Corners && A.m_Edges == B.m_Edges;
+}
+
+inline bool operator<(const SKey& A, const SKey& B)
+{
+	return A.m_Corners != B.m_Corners ? A.m_Corners < B.m_Corners : A.m_Edges < B.m_Edges;
+}
+
+// Hash functor for SKey, e.g. for std::unordered_set.
+struct SKeyHash
+{
+	size_t operator()(const SKey& Key) const
+	{
+		uint64_t H = (Key.m_Edges ^ (uint64_t(Key.m_Corners) << 37)) * 0x9E3779B97F4A7C15ull;
+		return size_t(H ^ (H >> 29));
+	}
+};
+
+void Reset(SCubies& State);		// Reset cube to solved state.
+bool IsSolved(const SCubies& State);	// Returns true if the cube is in the solved state.
+bool IsValid(const SCubies& State);	// Returns true if the state is reachable by rotations.
+
+const SCubies& GetRotation(Rotation::Type Rot);	// State after rotating a solved cube.
+void Multiply(const SCubies& A, const SCubies& B, SCubies& Result);	// State A followed by the moves of state B.
+void Apply(SCubies& State, Rotation::Type Rot);	// Apply one rotation.
+void Apply(SCubies& State, const Rotation::Type* pRots, size_t NumRots);	// Apply a sequence of rotations.
+
+// Conversions to and from the 54 facelets in LED order, for a given layout.
+// Brightness is ignored. FromFacelets() returns false if the facelets do not
+// describe a valid cube (State is then undefined).
+bool FromFacelets(Layout::Type L, const Facelet::Type* pFacelets, SCubies& State);
+void ToFacelets(Layout::Type L, const SCubies& State, Facelet::Type* pFacelets);
+
+SKey GetKey(const SCubies& State);
+void FromKey(const SKey& Key, SCubies& State);
+
+// Orientations of the corners in base 3 (twist) and of the edges in base 2
+// (flip), the last cubie being implied by the others. The Set functions only
+// change the orientations.
+const uint16_t NumTwists = 2187;	// 3^7
+const uint16_t NumFlips  = 2048;	// 2^11
+
+uint16_t GetTwist(const SCubies& State);
+void SetTwist(SCubies& State, uint16_t Twist);
+uint16_t GetFlip(const SCubies& State);
+void SetFlip(SCubies& State, uint16_t Flip);
+
+// Returns true if the permutation of N cubies has an odd number of
+// inversions. A rotation changes the parity of both permutations.
+bool IsOddPermutation(const uint8_t* pCubies, uint8_t N);
+
+// Lexicographic rank of the permutation of N cubies (orientations are
+// ignored), in [0, N![, and its inverse, which clears orientations.
+uint64_t RankPermutation(const uint8_t* pCubies, uint8_t N);
+void UnrankPermutation(uint64_t Rank, uint8_t* pCubies, uint8_t N);
+}
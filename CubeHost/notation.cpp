@@ -0,0 +1,194 @@
+#include "notation.h"
+#include "permutation.h"
+#include "../Cube/config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+// These are in the same order as namespace Rotation.
+const char FaceLetters[Cube::NumFaces + 1] = "UFRBLD";
+
+// Letters of the slice moves and whole-cube rotations, from Rotation::Middle.
+const char MoveLetters[Rotation::CCW + 1] = "MESxyz";
+
+// Returns the face of the given letter, or Rotation::None.
+Rotation::Type GetFace(char Letter)
+{
+	switch (Letter)
+	{
+	case 'U': return Rotation::Top;
+	case 'F': return Rotation::Front;
+	case 'R': return Rotation::Right;
+	case 'B': return Rotation::Back;
+	case 'L': return Rotation::Left;
+	case 'D': return Rotation::Bottom;
+	default:  return Rotation::None;
+	}
+}
+
+// Returns the clockwise move of the given letter, or Rotation::None.
+Rotation::Type GetMove(char Letter)
+{
+	switch (Letter)
+	{
+	case 'M': return Rotation::Middle;
+	case 'E': return Rotation::Equator;
+	case 'S': return Rotation::Standing;
+	case 'x': return Rotation::CubeX;
+	case 'y': return Rotation::CubeY;
+	case 'z': return Rotation::CubeZ;
+	default:  return GetFace(Letter);
+	}
+}
+
+// Letter of the given clockwise move.
+char GetMoveLetter(Rotation::Type Move)
+{
+	return (Rotation::IsRotation(Move) ? Notation::GetLetter(Move) : MoveLetters[Move - Rotation::Middle]);
+}
+
+// Color of the facelets of the given face in the solved state.
+Facelet::Type GetFaceColor(Layout::Type L, Rotation::Type Face)
+{
+	// In a solved cube, the color of the facelets of the i-th block of 9 LEDs
+	// is i + 1, whatever the layout.
+	return Permutation::GetRotationIndices(L, Face).m_Center / Cube::NumFaceletsPerFace + 1;
+}
+
+bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+}
+
+namespace Notation
+{
+
+// Prepare the parser for a new text.
+void Reset(SParser& Parser)
+{
+	Parser.m_Pending     = Rotation::None;
+	Parser.m_AfterDouble = false;
+	Parser.m_Invalid     = 0;
+	Parser.m_AllowMoves  = false;
+}
+
+// Parse Len characters, writing the resulting rotations to pRots, which must
+// have room for 2 * Len rotations. Returns the number of rotations written.
+size_t Parse(SParser& Parser, const char* pText, size_t Len, Rotation::Type* pRots)
+{
+	Rotation::Type* pOut = pRots;
+	for (const char* pEnd = pText + Len; pText != pEnd; ++pText)
+	{
+		char c = *pText;
+		bool AfterDouble = Parser.m_AfterDouble;
+		Parser.m_AfterDouble = false;
+
+		Rotation::Type Move = GetMove(c);
+		if (Move != Rotation::None && (Parser.m_AllowMoves || Rotation::IsRotation(Move)))
+		{
+			if (Parser.m_Pending != Rotation::None)
+				*pOut++ = Parser.m_Pending;
+			Parser.m_Pending = Move;
+		}
+		else if (c == '\'' && Parser.m_Pending != Rotation::None)
+		{
+			*pOut++ = Parser.m_Pending + Rotation::CCW;
+			Parser.m_Pending = Rotation::None;
+		}
+		else if (c == '2' && Parser.m_Pending != Rotation::None)
+		{
+			*pOut++ = Parser.m_Pending;
+			*pOut++ = Parser.m_Pending;
+			Parser.m_Pending = Rotation::None;
+			Parser.m_AfterDouble = true;
+		}
+		else if (c == '\'' && AfterDouble)
+		{
+			// R2' is the same as R2.
+		}
+		else if (IsSpace(c))
+		{
+			if (Parser.m_Pending != Rotation::None)
+				*pOut++ = Parser.m_Pending;
+			Parser.m_Pending = Rotation::None;
+		}
+		else
+		{
+			Parser.m_Invalid = c;
+			return ParseError;
+		}
+	}
+	return pOut - pRots;
+}
+
+// End of the text (or of a sequence). Writes the last rotation, if pending.
+size_t Finish(SParser& Parser, Rotation::Type* pRots)
+{
+	Parser.m_AfterDouble = false;
+	if (Parser.m_Pending == Rotation::None)
+		return 0;
+	*pRots = Parser.m_Pending;
+	Parser.m_Pending = Rotation::None;
+	return 1;
+}
+
+// Write NumRots rotations as text, two identical rotations in a row being
+// written as a half turn ("R2"). Returns the length of the text.
+size_t Format(const Rotation::Type* pRots, size_t NumRots, char* pText)
+{
+	char* pOut = pText;
+	for (size_t i = 0; i < NumRots; ++i)
+	{
+		if (pOut != pText)
+			*pOut++ = ' ';
+		Rotation::Type Move = Rotation::GetClockwise(pRots[i]);
+		*pOut++ = GetMoveLetter(Move);
+		if (i + 1 < NumRots && pRots[i + 1] == pRots[i])
+		{
+			*pOut++ = '2';
+			++i;
+		}
+		else if (pRots[i] != Move)
+			*pOut++ = '\'';
+	}
+	*pOut = 0;
+	return pOut - pText;
+}
+
+// Letter of the given face ('U' for Rotation::Top, etc).
+char GetLetter(Rotation::Type Face)
+{
+	assert(Face < Cube::NumFaces);
+	return FaceLetters[Face];
+}
+
+// Write the facelets as 54 face letters, followed by a 0. Black facelets
+// are written as '.', and the unused color as '?'.
+void FormatFacelets(Layout::Type L, const Facelet::Type* pFacelets, char* pText)
+{
+	char Letters[Facelet::Bright];
+	Letters[Facelet::Black]  = '.';
+	Letters[Facelet::Unused] = '?';
+	for (Rotation::Type Face = 0; Face < Cube::NumFaces; ++Face)
+		Letters[GetFaceColor(L, Face)] = FaceLetters[Face];
+	for (uint8_t i = 0; i < Cube::NumFacelets; ++i)
+		pText[i] = Letters[pFacelets[i]];
+	pText[Cube::NumFacelets] = 0;
+}
+
+// Read 54 face letters. Returns false if one is not a face letter.
+bool ParseFacelets(Layout::Type L, const char* pText, Facelet::Type* pFacelets)
+{
+	for (uint8_t i = 0; i < Cube::NumFacelets; ++i)
+	{
+		Rotation::Type Face = GetFace(pText[i]);
+		if (Face == Rotation::None)
+			return false;
+		pFacelets[i] = GetFaceColor(L, Face);
+	}
+	return true;
+}
+
+}
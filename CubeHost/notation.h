@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+
+// Host-only: incremental parser of the standard (Singmaster) notation of
+// rotations: U, F, R, B, L and D for the Top, Front, Right, Back, Left and
+// Bottom faces, followed by ' for a counter-clockwise rotation or by 2 (or 2')
+// for a half turn, which gives two quarter turns. Moves may be separated by
+// white space or written next to each other ("RUR'U'").
+//
+// If SParser::m_AllowMoves is set, M, E and S (slice moves) and x, y and z
+// (whole-cube rotations) are accepted too, with the same suffixes. Only
+// Cube::SState can apply them, so they are rejected by default.
+//
+// Text can be fed in chunks of any size, a move may span two chunks.
+namespace Notation
+{
+// Parsing state carried from one chunk to the next.
+struct SParser
+{
+	Rotation::Type m_Pending;	// Rotation whose suffix is not known yet, or Rotation::None.
+	bool           m_AfterDouble;	// The previous character was the 2 of a half turn.
+	char           m_Invalid;	// First invalid character found, 0 if none.
+	bool           m_AllowMoves;	// Accept the moves other than rotations, false after Reset().
+};
+
+// Returned by Parse() when the text contains an invalid character.
+const size_t ParseError = ~size_t(0);
+
+void Reset(SParser& Parser);		// Prepare the parser for a new text.
+
+// Parse Len characters, writing the resulting rotations to pRots, which must
+// have room for 2 * Len rotations. Returns the number of rotations written,
+// or ParseError (see SParser::m_Invalid).
+size_t Parse(SParser& Parser, const char* pText, size_t Len, Rotation::Type* pRots);
+
+// End of the text (or of a sequence). Writes the last rotation, if pending, to
+// pRots, which must have room for 1 rotation. Returns the number written.
+size_t Finish(SParser& Parser, Rotation::Type* pRots);
+
+// Write NumRots rotations (or any moves) as text, two identical rotations in a row being
+// written as a half turn ("R2"). pText must have room for 3 * NumRots + 1
+// characters. Returns the length of the text, which is 0-terminated.
+size_t Format(const Rotation::Type* pRots, size_t NumRots, char* pText);
+
+char GetLetter(Rotation::Type Face);	// Letter of the given face ('U' for Rotation::Top, etc).
+
+// Cube states as 54 face letters in LED order: each facelet is named after
+// the face whose center has its color, '.' for black.
+// FormatFacelets() writes 55 characters, with the terminating 0.
+// ParseFacelets() reads 54 characters, and returns false if one is not a
+// face letter.
+void FormatFacelets(Layout::Type L, const Facelet::Type* pFacelets, char* pText);
+bool ParseFacelets(Layout::Type L, const char* pText, Facelet::Type* pFacelets);
+}
@@ -0,0 +1,221 @@
+#include "optimal.h"
+#include "workstealing.h"
+#include "../Cube/config.h"
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Optimal::STables;
+
+// Number of tasks per thread for each iteration. More tasks balance the load
+// better, at the cost of a deeper split.
+const size_t TasksPerThread = 64;
+
+// Rotations left to search by every task: the split stops this many levels
+// above the limit, so that even shallow searches run in parallel tasks.
+const uint8_t MinTaskRotations = 4;
+
+// Subtree searched by one task.
+struct STask
+{
+	Pdb::SCoords   m_Coords;
+	uint8_t        m_Depth;
+	Rotation::Type m_Path[Optimal::MaxRotations];	// Rotations from the root.
+};
+
+// State of one thread, on its own cache lines.
+struct alignas(64) SWorker
+{
+	Rotation::Type m_Path[Optimal::MaxRotations];
+	uint64_t       m_NumNodes;
+	double         m_Seconds;
+};
+
+// Search shared by all threads.
+struct SSearch
+{
+	const STables*    m_pTables;
+	std::atomic<bool> m_IsFound;
+	std::mutex        m_Mutex;			// Protects m_Solution.
+	Rotation::Type    m_Solution[Optimal::MaxRotations];
+};
+
+// Returns true if the heuristic of the state is below Bound. The corner
+// index, the cheapest, is tried first.
+inline bool IsBelow(const STables& Tables, const Pdb::SCoords& Coords, uint8_t Bound)
+{
+	for (Pdb::Type T = 0; T < Pdb::NumTypes; ++T)
+		if (Pdb::GetDistance(Tables.m_pPdbs[T], Pdb::GetIndex(T, Coords)) >= Bound)
+			return false;
+	return true;
+}
+
+inline Rotation::Type GetPrevRot(const Rotation::Type* pPath, uint8_t Depth, uint8_t Back)
+{
+	return (Depth >= Back ? pPath[Depth - Back] : Rotation::None);
+}
+
+// Depth-first search below a node at the given depth, with exactly ToGo
+// rotations left. Returns true if a solution is found (in Worker.m_Path).
+bool SearchSubtree(SSearch& Search, SWorker& Worker, const Pdb::SCoords& Coords, uint8_t Depth, uint8_t ToGo)
+{
+	// Nodes are only kept if their heuristic is below ToGo: here it is 0,
+	// the state is solved.
+	if (ToGo == 0)
+		return true;
+	if (Search.m_IsFound.load(std::memory_order_relaxed))
+		return false;
+
+	Rotation::Type PrevRot = GetPrevRot(Worker.m_Path, Depth, 1), PrevPrevRot = GetPrevRot(Worker.m_Path, Depth, 2);
+	for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+	{
+		if (!Optimal::IsAllowed(Rot, PrevRot, PrevPrevRot))
+			continue;
+		Pdb::SCoords Next = Coords;
+		Pdb::Apply(Next, Rot);
+		++Worker.m_NumNodes;
+		if (!IsBelow(*Search.m_pTables, Next, ToGo))
+			continue;
+		Worker.m_Path[Depth] = Rot;
+		if (SearchSubtree(Search, Worker, Next, Depth + 1, ToGo - 1))
+			return true;
+	}
+	return false;
+}
+
+// Nodes at the split depth whose subtrees may hold a solution of Limit
+// rotations, for at least MinTasks tasks (or MinTaskRotations above Limit).
+// Returns the number of nodes generated.
+uint64_t Split(const STables& Tables, const Pdb::SCoords& Root, uint8_t Limit, size_t MinTasks, std::vector<STask>& Tasks)
+{
+	Tasks.resize(1);
+	Tasks[0].m_Coords = Root;
+	Tasks[0].m_Depth  = 0;
+	uint64_t NumNodes = 0;
+	std::vector<STask> Children;
+	while (Tasks.size() < MinTasks && !Tasks.empty() && Tasks[0].m_Depth + MinTaskRotations < Limit)
+	{
+		Children.clear();
+		for (const STask& Task : Tasks)
+		{
+			uint8_t Depth = Task.m_Depth;
+			Rotation::Type PrevRot = GetPrevRot(Task.m_Path, Depth, 1), PrevPrevRot = GetPrevRot(Task.m_Path, Depth, 2);
+			for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+			{
+				if (!Optimal::IsAllowed(Rot, PrevRot, PrevPrevRot))
+					continue;
+				STask Child = Task;
+				Pdb::Apply(Child.m_Coords, Rot);
+				++NumNodes;
+				if (Depth + 1 + Optimal::GetHeuristic(Tables, Child.m_Coords) > Limit)
+					continue;
+				Child.m_Path[Depth] = Rot;
+				Child.m_Depth = Depth + 1;
+				Children.push_back(Child);
+			}
+		}
+		Tasks.swap(Children);
+	}
+	return NumNodes;
+}
+
+}
+
+namespace Optimal
+{
+
+// Lower bound of the number of rotations solving the state.
+uint8_t GetHeuristic(const STables& Tables, const Pdb::SCoords& Coords)
+{
+	uint8_t Distance = 0;
+	for (Pdb::Type T = 0; T < Pdb::NumTypes; ++T)
+	{
+		uint8_t PdbDistance = Pdb::GetDistance(Tables.m_pPdbs[T], Pdb::GetIndex(T, Coords));
+		if (PdbDistance > Distance)
+			Distance = PdbDistance;
+	}
+	return Distance;
+}
+
+// Find a shortest solution of at most MaxRots rotations, using NumThreads
+// threads.
+bool Solve(const STables& Tables, const Cubies::SCubies& State, unsigned NumThreads, uint8_t MaxRots,
+           Rotation::Type* pRots, uint8_t& NumRots, SStats* pStats)
+{
+	assert(NumThreads > 0);
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	std::vector<SWorker> Workers(NumThreads);
+	for (SWorker& Worker : Workers)
+	{
+		Worker.m_NumNodes = 0;
+		Worker.m_Seconds  = 0.0;
+	}
+	uint64_t NumTasks = 0, NumSplitNodes = 0;
+	bool IsFound = false;
+	NumRots = 0;
+
+	if (Cubies::IsValid(State))
+	{
+		Pdb::Init();
+		Pdb::SCoords Root;
+		Pdb::FromCubies(State, Root);
+
+		SSearch Search;
+		Search.m_pTables = &Tables;
+		Search.m_IsFound = false;
+
+		// Solutions all have the parity of the state: skip half of the limits.
+		uint8_t Limit = GetHeuristic(Tables, Root);
+		if ((Limit & 1) != Cubies::IsOddPermutation(State.m_Corners, Cubies::NumCorners))
+			++Limit;
+		std::vector<STask> Tasks;
+		for (; Limit <= MaxRots && !IsFound; Limit += 2)
+		{
+			NumSplitNodes += Split(Tables, Root, Limit, TasksPerThread * NumThreads, Tasks);
+			NumTasks += Tasks.size();
+			WorkStealing::Run(NumThreads, Tasks.size(), [&](size_t TaskIdx, unsigned ThreadIdx)
+			{
+				const STask& Task = Tasks[TaskIdx];
+				SWorker& Worker = Workers[ThreadIdx];
+				std::chrono::steady_clock::time_point TaskStart = std::chrono::steady_clock::now();
+				memcpy(Worker.m_Path, Task.m_Path, Task.m_Depth);
+				if (SearchSubtree(Search, Worker, Task.m_Coords, Task.m_Depth, Limit - Task.m_Depth))
+				{
+					std::lock_guard<std::mutex> Lock(Search.m_Mutex);
+					if (!Search.m_IsFound)
+					{
+						memcpy(Search.m_Solution, Worker.m_Path, Limit);
+						Search.m_IsFound = true;
+					}
+				}
+				Worker.m_Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - TaskStart).count();
+			});
+			IsFound = Search.m_IsFound;
+			if (IsFound)
+			{
+				NumRots = Limit;
+				memcpy(pRots, Search.m_Solution, Limit);
+			}
+		}
+	}
+
+	if (pStats != NULL)
+	{
+		pStats->m_Seconds  = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		pStats->m_NumTasks = NumTasks;
+		pStats->m_NumSplitNodes = NumSplitNodes;
+		pStats->m_Threads.resize(NumThreads);
+		for (unsigned ThreadIdx = 0; ThreadIdx < NumThreads; ++ThreadIdx)
+		{
+			pStats->m_Threads[ThreadIdx].m_NumNodes = Workers[ThreadIdx].m_NumNodes;
+			pStats->m_Threads[ThreadIdx].m_Seconds  = Workers[ThreadIdx].m_Seconds;
+		}
+	}
+	return IsFound;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "../Cube/cube.h"
+#include "cubies.h"
+#include "pdb.h"
+
+// Host-only: optimal solver, finding a shortest sequence of rotations
+// (quarter turns) solving a state. IDA* search, with the pattern databases of
+// pdb.h as heuristic. The tree is split at a shallow depth into tasks that
+// are run by a work-stealing thread pool (see workstealing.h).
+//
+// Rotations are searched in a canonical order: a face is turned at most
+// twice in a row, clockwise, and of two opposite faces turned in a row, the
+// lower one (in Rotation order) comes first.
+namespace Optimal
+{
+const uint8_t MaxRotations = 30;	// Every state is solved in 26 quarter turns.
+
+// Pattern databases, Pdb::GetTableSize() bytes each.
+struct STables
+{
+	const uint8_t* m_pPdbs[Pdb::NumTypes];
+};
+
+struct SThreadStats
+{
+	uint64_t m_NumNodes;		// Nodes generated.
+	double   m_Seconds;		// Time spent running tasks.
+};
+
+struct SStats
+{
+	double   m_Seconds;		// Wall-clock time of the search.
+	uint64_t m_NumTasks;		// Tasks run, over all iterations.
+	uint64_t m_NumSplitNodes;	// Nodes generated by the calling thread to split the search into tasks.
+	std::vector<SThreadStats> m_Threads;
+};
+
+// Returns true if Rot may follow the previous rotations (Rotation::None if
+// none) in the canonical order.
+inline bool IsAllowed(Rotation::Type Rot, Rotation::Type PrevRot, Rotation::Type PrevPrevRot)
+{
+	if (PrevRot == Rotation::None)
+		return true;
+	Rotation::Type Face = Rotation::GetFace(Rot), PrevFace = Rotation::GetFace(PrevRot);
+	if (Face == PrevFace)
+		return Rot == PrevRot && Rot < Rotation::CCW && PrevPrevRot != Rot;
+	return !(Face < PrevFace && Face == Rotation::OppositeFace(PrevFace));
+}
+
+// Lower bound of the number of rotations solving the state.
+uint8_t GetHeuristic(const STables& Tables, const Pdb::SCoords& Coords);
+
+// Find a shortest solution of at most MaxRots rotations, using NumThreads
+// threads. pRots must have room for MaxRots rotations. Returns false if the
+// state is invalid or needs more than MaxRots rotations. pStats may be NULL.
+bool Solve(const STables& Tables, const Cubies::SCubies& State, unsigned NumThreads, uint8_t MaxRots,
+           Rotation::Type* pRots, uint8_t& NumRots, SStats* pStats);
+}
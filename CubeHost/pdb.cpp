@@ -0,0 +1,380 @@
+#include "pdb.h"
+#include "workstealing.h"
+#include "../Cube/config.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Cubies::SCubies;
+using Cubies::NumCorners;
+using Cubies::NumEdges;
+using Cubies::CubieMask;
+using Cubies::OriShift;
+using Pdb::NumSubsetEdges;
+using Pdb::UnknownDistance;
+
+const uint32_t NumCornerPerms = 40320;				// 8!
+const uint32_t NumPlacements  = 665280;				// 12!/6!: positions of 6 edges.
+const uint32_t NumSubsetFlips = 1 << NumSubsetEdges;
+
+// Weight of the i-th digit of the rank of a placement: (11-i)!/6!.
+const uint32_t PlacementWeights[NumSubsetEdges] = {55440, 5040, 504, 56, 7, 1};
+
+// Rank of the positions of 6 edges, in [0, NumPlacements[, and their flips.
+uint32_t GetEdgesIndex(const uint8_t* pLocs)
+{
+	uint32_t Placement = 0, Flips = 0;
+	uint16_t Used = 0;
+	for (uint8_t i = 0; i < NumSubsetEdges; ++i)
+	{
+		uint8_t Pos = pLocs[i] & CubieMask;
+		Placement += (Pos - __builtin_popcount(Used & ((1u << Pos) - 1))) * PlacementWeights[i];
+		Used |= 1u << Pos;
+		Flips = Flips << 1 | pLocs[i] >> OriShift;
+	}
+	return Placement * NumSubsetFlips + Flips;
+}
+
+// Inverse of GetEdgesIndex().
+void SetEdgesIndex(uint32_t Idx, uint8_t* pLocs)
+{
+	uint32_t Placement = Idx / NumSubsetFlips, Flips = Idx % NumSubsetFlips;
+	uint16_t Used = 0;
+	for (uint8_t i = 0; i < NumSubsetEdges; ++i)
+	{
+		uint8_t Count = uint8_t(Placement / PlacementWeights[i]);
+		Placement %= PlacementWeights[i];
+		uint8_t Pos = 0;
+		for (; ; ++Pos)
+			if (!(Used & (1u << Pos)) && Count-- == 0)
+				break;
+		Used |= 1u << Pos;
+		pLocs[i] = Pos | ((Flips >> (NumSubsetEdges - 1 - i)) & 1) << OriShift;
+	}
+}
+
+const char Magic[sizeof(Pdb::SFileHeader().m_Magic)] = {'R', 'U', 'B', 'I', 'K', 'P', 'D', 'B'};
+
+// Entries scanned by one task of the breadth-first search. Even, so that
+// tasks never share a byte.
+const uint64_t ChunkSize = 1 << 18;
+
+// Entries are read and written concurrently by the threads of the search:
+// bytes are accessed atomically, without ordering.
+inline uint8_t GetDistanceAtomic(const uint8_t* pTable, uint64_t Idx)
+{
+	return (__atomic_load_n(&pTable[Idx >> 1], __ATOMIC_RELAXED) >> ((Idx & 1) * 4)) & 0x0F;
+}
+
+// Set the distance of an unknown entry, which may be set concurrently by
+// another thread. Unknown entries have all bits set: clearing bits is enough.
+// Returns true if the entry was unknown.
+inline bool SetUnknownDistance(uint8_t* pTable, uint64_t Idx, uint8_t Distance)
+{
+	uint8_t Shift = (Idx & 1) * 4;
+	uint8_t Old = __atomic_fetch_and(&pTable[Idx >> 1], uint8_t(~((UnknownDistance ^ Distance) << Shift)), __ATOMIC_RELAXED);
+	return ((Old >> Shift) & 0x0F) == UnknownDistance;
+}
+
+// Breadth-first search from the entry Start. Neighbors(Idx, pNext) writes
+// the Rotation::NumRotations entries one rotation away from Idx.
+//
+// Each level is found by scanning the whole table in chunks, run in
+// parallel. While few entries are at the current distance, their unknown
+// neighbors are set (top-down). Once most of the table is reached, each
+// unknown entry looks for a neighbor at the current distance instead
+// (bottom-up), which stops at the first one found.
+template<typename NeighborsFunc>
+void BuildTable(uint8_t* pTable, uint64_t NumEntries, uint64_t Start, unsigned NumThreads, Pdb::SBuildStats* pStats,
+                NeighborsFunc Neighbors)
+{
+	memset(pTable, 0xFF, size_t((NumEntries + 1) / 2));
+	SetUnknownDistance(pTable, Start, 0);
+
+	size_t NumChunks = size_t((NumEntries + ChunkSize - 1) / ChunkSize);
+	std::vector<uint64_t> NumNewPerChunk(NumChunks);
+	uint64_t NumAtDistance = 1, NumUnknown = NumEntries - 1;
+	if (pStats != NULL)
+	{
+		memset(pStats, 0, sizeof(*pStats));
+		pStats->m_NumDistances  = 1;
+		pStats->m_NumEntries[0] = 1;
+	}
+
+	for (uint8_t Distance = 0; NumAtDistance > 0 && NumUnknown > 0; ++Distance)
+	{
+		assert(Distance + 1 < UnknownDistance);
+		bool IsBottomUp = (NumUnknown < 2 * NumAtDistance);
+		WorkStealing::Run(NumThreads, NumChunks, [&](size_t ChunkIdx, unsigned)
+		{
+			uint64_t Begin = ChunkIdx * ChunkSize;
+			uint64_t End   = (Begin + ChunkSize < NumEntries ? Begin + ChunkSize : NumEntries);
+			uint64_t NumNew = 0;
+			uint64_t Next[Rotation::NumRotations];
+			for (uint64_t Idx = Begin; Idx < End; ++Idx)
+			{
+				uint8_t IdxDistance = GetDistanceAtomic(pTable, Idx);
+				if (IsBottomUp && IdxDistance == UnknownDistance)
+				{
+					Neighbors(Idx, Next);
+					for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+					{
+						if (GetDistanceAtomic(pTable, Next[Rot]) == Distance)
+						{
+							SetUnknownDistance(pTable, Idx, Distance + 1);
+							++NumNew;
+							break;
+						}
+					}
+				}
+				else if (!IsBottomUp && IdxDistance == Distance)
+				{
+					Neighbors(Idx, Next);
+					for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+						if (GetDistanceAtomic(pTable, Next[Rot]) == UnknownDistance && SetUnknownDistance(pTable, Next[Rot], Distance + 1))
+							++NumNew;
+				}
+			}
+			NumNewPerChunk[ChunkIdx] = NumNew;
+		});
+
+		NumAtDistance = 0;
+		for (uint64_t NumNew : NumNewPerChunk)
+			NumAtDistance += NumNew;
+		NumUnknown -= NumAtDistance;
+		if (pStats != NULL && NumAtDistance > 0)
+		{
+			pStats->m_NumDistances = Distance + 2;
+			pStats->m_NumEntries[Distance + 1] = NumAtDistance;
+		}
+	}
+}
+
+// Returns true if the header describes a valid file of the given table.
+bool IsValid(const Pdb::SFileHeader& Header, Pdb::Type T, size_t FileSize)
+{
+	return memcmp(Header.m_Magic, Magic, sizeof(Magic)) == 0 && Header.m_Version == Pdb::FileVersion &&
+	       Header.m_Type == T && Header.m_NumEntries == Pdb::GetNumEntries(T) &&
+	       Header.m_TableSize == Pdb::GetTableSize(T) && FileSize == Pdb::FileHeaderSize + Header.m_TableSize;
+}
+
+}
+
+namespace Pdb
+{
+
+const SMoveTables* g_pMoveTables = NULL;
+
+// Build the move tables, if not built yet.
+void Init()
+{
+	if (g_pMoveTables != NULL)
+		return;
+
+	static SMoveTables s_Tables;
+	SCubies State, Moved;
+	Cubies::Reset(State);
+	for (uint32_t Perm = 0; Perm < NumCornerPerms; ++Perm)
+	{
+		Cubies::UnrankPermutation(Perm, State.m_Corners, NumCorners);
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			Cubies::Multiply(State, Cubies::GetRotation(Rot), Moved);
+			s_Tables.m_CornerPerm[Perm][Rot] = uint16_t(Cubies::RankPermutation(Moved.m_Corners, NumCorners));
+		}
+	}
+	Cubies::Reset(State);
+	for (uint16_t Twist = 0; Twist < Cubies::NumTwists; ++Twist)
+	{
+		Cubies::SetTwist(State, Twist);
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			Cubies::Multiply(State, Cubies::GetRotation(Rot), Moved);
+			s_Tables.m_Twist[Twist][Rot] = Cubies::GetTwist(Moved);
+		}
+	}
+
+	// After a rotation, position Pos holds the cubie that was at Rotated[Pos]
+	// (with its flip changed by that of Rotated[Pos]).
+	memset(s_Tables.m_EdgeLoc, 0, sizeof(s_Tables.m_EdgeLoc));
+	for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+	{
+		const SCubies& Rotated = Cubies::GetRotation(Rot);
+		for (uint8_t Pos = 0; Pos < NumEdges; ++Pos)
+		{
+			uint8_t From = Rotated.m_Edges[Pos] & CubieMask;
+			uint8_t Flip = Rotated.m_Edges[Pos] >> OriShift;
+			for (uint8_t Ori = 0; Ori < 2; ++Ori)
+				s_Tables.m_EdgeLoc[Rot][From | Ori << OriShift] = Pos | (Ori ^ Flip) << OriShift;
+		}
+	}
+	g_pMoveTables = &s_Tables;
+}
+
+void FromCubies(const Cubies::SCubies& State, SCoords& Coords)
+{
+	Coords.m_CornerPerm = uint16_t(Cubies::RankPermutation(State.m_Corners, NumCorners));
+	Coords.m_Twist      = Cubies::GetTwist(State);
+	for (uint8_t Pos = 0; Pos < NumEdges; ++Pos)
+		Coords.m_EdgeLocs[State.m_Edges[Pos] & CubieMask] = Pos | (State.m_Edges[Pos] & ~CubieMask);
+}
+
+uint64_t GetNumEntries(Type T)
+{
+	assert(T < NumTypes);
+	return (T == Corners ? uint64_t(NumCornerPerms) * Cubies::NumTwists : uint64_t(NumPlacements) * NumSubsetFlips);
+}
+
+uint64_t GetIndex(Type T, const SCoords& Coords)
+{
+	assert(T < NumTypes);
+	if (T == Corners)
+		return uint64_t(Coords.m_CornerPerm) * Cubies::NumTwists + Coords.m_Twist;
+	return GetEdgesIndex(Coords.m_EdgeLocs + (T == EdgesLow ? 0 : NumSubsetEdges));
+}
+
+const char* GetName(Type T)
+{
+	assert(T < NumTypes);
+	static const char* const s_Names[NumTypes] = {"corners", "edges-low", "edges-high"};
+	return s_Names[T];
+}
+
+// Fill the table by a breadth-first search from the solved state, on
+// NumThreads threads.
+void Build(Type T, uint8_t* pTable, unsigned NumThreads, SBuildStats* pStats)
+{
+	Init();
+	const SMoveTables& Tables = *g_pMoveTables;
+	if (T == Corners)
+	{
+		BuildTable(pTable, GetNumEntries(T), 0, NumThreads, pStats, [&](uint64_t Idx, uint64_t* pNext)
+		{
+			uint16_t Perm = uint16_t(Idx / Cubies::NumTwists), Twist = uint16_t(Idx % Cubies::NumTwists);
+			for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+				pNext[Rot] = uint64_t(Tables.m_CornerPerm[Perm][Rot]) * Cubies::NumTwists + Tables.m_Twist[Twist][Rot];
+		});
+		return;
+	}
+
+	// The two edge subsets only differ by the solved positions of their edges.
+	uint8_t SolvedLocs[NumSubsetEdges];
+	for (uint8_t i = 0; i < NumSubsetEdges; ++i)
+		SolvedLocs[i] = (T == EdgesLow ? i : NumSubsetEdges + i);
+	BuildTable(pTable, GetNumEntries(T), GetEdgesIndex(SolvedLocs), NumThreads, pStats, [&](uint64_t Idx, uint64_t* pNext)
+	{
+		uint8_t Locs[NumSubsetEdges], Moved[NumSubsetEdges];
+		SetEdgesIndex(uint32_t(Idx), Locs);
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			for (uint8_t i = 0; i < NumSubsetEdges; ++i)
+				Moved[i] = Tables.m_EdgeLoc[Rot][Locs[i]];
+			pNext[Rot] = GetEdgesIndex(Moved);
+		}
+	});
+}
+
+// Write a table file, through a temporary file.
+bool Write(Type T, const uint8_t* pTable, const char* pPath)
+{
+	STATIC_ASSERT(sizeof(SFileHeader) == FileHeaderSize, "The header must have a fixed size.");
+	SFileHeader Header;
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.m_Magic, Magic, sizeof(Magic));
+	Header.m_Version    = FileVersion;
+	Header.m_Type       = T;
+	Header.m_NumEntries = GetNumEntries(T);
+	Header.m_TableSize  = GetTableSize(T);
+
+	char TempPath[4096];
+	if (snprintf(TempPath, sizeof(TempPath), "%s.%d.tmp", pPath, int(getpid())) >= int(sizeof(TempPath)))
+		return false;
+	FILE* pFile = fopen(TempPath, "wb");
+	if (pFile == NULL)
+		return false;
+	bool Ok = (fwrite(&Header, sizeof(Header), 1, pFile) == 1);
+	Ok = Ok && fwrite(pTable, size_t(Header.m_TableSize), 1, pFile) == 1;
+	Ok = (fclose(pFile) == 0) && Ok;
+	Ok = Ok && rename(TempPath, pPath) == 0;
+	if (!Ok)
+		remove(TempPath);
+	return Ok;
+}
+
+// Map a table file. Returns false if it is missing or invalid.
+bool Load(STable& Table, Type T, const char* pPath)
+{
+	memset(&Table, 0, sizeof(Table));
+	int File = open(pPath, O_RDONLY);
+	if (File < 0)
+		return false;
+
+	struct stat Stat;
+	void* pData = MAP_FAILED;
+	if (fstat(File, &Stat) == 0 && size_t(Stat.st_size) >= FileHeaderSize)
+		pData = mmap(NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);	// The mapping stays valid.
+	if (pData == MAP_FAILED)
+		return false;
+
+	Table.m_pData      = static_cast<const uint8_t*>(pData);
+	Table.m_Size       = Stat.st_size;
+	Table.m_pDistances = Table.m_pData + FileHeaderSize;
+	if (!IsValid(*static_cast<const SFileHeader*>(pData), T, Table.m_Size))
+	{
+		Free(Table);
+		return false;
+	}
+
+	// Lookups are random: read the whole table now rather than fault it in
+	// page by page during the search.
+	madvise(pData, Table.m_Size, MADV_WILLNEED);
+	return true;
+}
+
+void Free(STable& Table)
+{
+	if (Table.m_pData != NULL)
+		munmap(const_cast<uint8_t*>(Table.m_pData), Table.m_Size);
+	memset(&Table, 0, sizeof(Table));
+}
+
+// Load the table, building and writing it first if needed.
+bool LoadOrBuild(STable& Table, Type T, const char* pPath, unsigned NumThreads, bool* pHasBuilt)
+{
+	if (pHasBuilt != NULL)
+		*pHasBuilt = false;
+	if (Load(Table, T, pPath))
+		return true;
+
+	// Build in anonymous memory laid out as the file, which is used as is if
+	// the file cannot be written.
+	size_t Size = FileHeaderSize + GetTableSize(T);
+	void* pData = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pData == MAP_FAILED)
+		return false;
+	uint8_t* pDistances = static_cast<uint8_t*>(pData) + FileHeaderSize;
+	Build(T, pDistances, NumThreads, NULL);
+	if (pHasBuilt != NULL)
+		*pHasBuilt = true;
+
+	if (Write(T, pDistances, pPath) && Load(Table, T, pPath))
+	{
+		munmap(pData, Size);
+		return true;
+	}
+	mprotect(pData, Size, PROT_READ);
+	Table.m_pData      = static_cast<const uint8_t*>(pData);
+	Table.m_Size       = Size;
+	Table.m_pDistances = pDistances;
+	return true;
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "cubies.h"
+
+// Host-only: pattern databases, i.e. tables of the exact number of rotations
+// (quarter turns) needed to solve a part of the cube, whatever the rest. The
+// largest of them is an admissible heuristic for the whole cube:
+// - Corners:   the 8 corners, 8! * 3^7 = 88179840 entries,
+// - EdgesLow:  edges UR to DF (0 to 5), 12!/6! * 2^6 = 42577920 entries,
+// - EdgesHigh: edges DL to BR (6 to 11), same size.
+// Distances are stored on 4 bits, two entries per byte, the even entry in the
+// low nibble.
+//
+// Tables are built once, by a multithreaded breadth-first search, and saved
+// to files that are memory-mapped by the solvers: a 64-byte header followed
+// by the table.
+namespace Pdb
+{
+typedef uint8_t Type;
+const Type Corners   = 0;
+const Type EdgesLow  = 1;
+const Type EdgesHigh = 2;
+const Type NumTypes  = 3;
+
+const uint8_t NumSubsetEdges = 6;		// Edges of EdgesLow and EdgesHigh.
+const uint8_t UnknownDistance = 15;		// Entry not reached yet while building.
+
+// Cube state as coordinates that are cheap to update and to turn into table
+// indices: the corners as permutation rank and twist, and the location of
+// each edge cubie (position | flip << Cubies::OriShift), i.e. the inverse of
+// the edge permutation.
+struct SCoords
+{
+	uint16_t m_CornerPerm;
+	uint16_t m_Twist;
+	uint8_t  m_EdgeLocs[Cubies::NumEdges];
+};
+
+// Move tables, built by Init().
+struct SMoveTables
+{
+	uint16_t m_CornerPerm[40320][Rotation::NumRotations];
+	uint16_t m_Twist[Cubies::NumTwists][Rotation::NumRotations];
+	uint8_t  m_EdgeLoc[Rotation::NumRotations][32];	// [Rot][location] --> location
+};
+
+extern const SMoveTables* g_pMoveTables;
+
+void Init();					// Build the move tables, if not built yet.
+
+void FromCubies(const Cubies::SCubies& State, SCoords& Coords);
+
+inline void Apply(SCoords& Coords, Rotation::Type Rot)
+{
+	const SMoveTables& Tables = *g_pMoveTables;
+	Coords.m_CornerPerm = Tables.m_CornerPerm[Coords.m_CornerPerm][Rot];
+	Coords.m_Twist      = Tables.m_Twist[Coords.m_Twist][Rot];
+	for (uint8_t Edge = 0; Edge < Cubies::NumEdges; ++Edge)
+		Coords.m_EdgeLocs[Edge] = Tables.m_EdgeLoc[Rot][Coords.m_EdgeLocs[Edge]];
+}
+
+uint64_t GetNumEntries(Type T);
+inline size_t GetTableSize(Type T)		// In bytes.
+{
+	return size_t((GetNumEntries(T) + 1) / 2);
+}
+
+uint64_t GetIndex(Type T, const SCoords& Coords);
+
+inline uint8_t GetDistance(const uint8_t* pTable, uint64_t Idx)
+{
+	return (pTable[Idx >> 1] >> ((Idx & 1) * 4)) & 0x0F;
+}
+
+const char* GetName(Type T);			// "corners", "edges-low" or "edges-high".
+
+// Number of entries found at each distance by Build().
+struct SBuildStats
+{
+	uint8_t  m_NumDistances;			// Largest distance + 1.
+	uint64_t m_NumEntries[UnknownDistance];
+};
+
+// Fill the table (GetTableSize() bytes) by a breadth-first search from the
+// solved state, on NumThreads threads. pStats may be NULL.
+void Build(Type T, uint8_t* pTable, unsigned NumThreads, SBuildStats* pStats);
+
+// Table file.
+const uint32_t FileVersion    = 1;
+const size_t   FileHeaderSize = 64;
+
+struct SFileHeader
+{
+	char     m_Magic[8];		// "RUBIKPDB"
+	uint32_t m_Version;		// FileVersion
+	uint8_t  m_Type;
+	uint8_t  m_Reserved[3];		// Always 0.
+	uint64_t m_NumEntries;
+	uint64_t m_TableSize;		// In bytes, following the header.
+	uint8_t  m_Reserved2[32];	// Always 0.
+};
+
+// Memory-mapped table file.
+struct STable
+{
+	const uint8_t* m_pData;		// Whole file.
+	size_t         m_Size;
+	const uint8_t* m_pDistances;	// Table, after the header.
+};
+
+// Write a table file, through a temporary file so that readers never see a
+// partial file. Returns false on I/O errors.
+bool Write(Type T, const uint8_t* pTable, const char* pPath);
+
+// Map a table file. Returns false if it is missing or not a valid file for
+// the given table.
+bool Load(STable& Table, Type T, const char* pPath);
+void Free(STable& Table);
+
+// Load() the table, or Build() and Write() it first if the file is missing
+// or invalid. If the file cannot be written, the table is kept in memory.
+// pHasBuilt, if not NULL, tells whether the table was built. Returns false if
+// the table cannot be allocated.
+bool LoadOrBuild(STable& Table, Type T, const char* pPath, unsigned NumThreads, bool* pHasBuilt);
+}
@@ -0,0 +1,305 @@
+#include "permutation.h"
+#include "../Cube/config.h"
+#include <string.h>
+
+#if defined(__AVX512VBMI__)
+	#include <immintrin.h>
+#elif defined(__SSSE3__)
+	#include <tmmintrin.h>
+#endif
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Permutation::SFacelets;
+using Permutation::STable;
+using Permutation::NumPaddedFacelets;
+
+const uint8_t NumBlocks = NumPaddedFacelets / 16;	// Number of 16-byte blocks in SFacelets.
+
+// These are in the same order as namespace Layout and namespace Rotation.
+const Permutation::SRotationIndices g_RotationIndices[Layout::NumLayouts][Cube::NumFaces] =
+{
+	{
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_TOP),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_FRONT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_RIGHT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_BACK),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_LEFT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_SIMULATOR_BOTTOM)
+	},
+	{
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_TOP),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_FRONT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_RIGHT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_BACK),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_LEFT),
+		LAYOUT_ROTATION_INITIALIZER(LAYOUT_HARDWARE_BOTTOM)
+	}
+};
+
+// Permutations of all rotations, for all layouts.
+struct STables
+{
+	STable m_Tables[Layout::NumLayouts][Rotation::NumRotations];
+	STables();
+};
+
+// Build the permutation of one rotation from its facelet indices. A clockwise
+// rotation moves the side facelets by 3 positions and the front facelets by 2
+// positions, just like the rotation animations in cube.cpp.
+void BuildTable(const Permutation::SRotationIndices& Indices, bool IsCCW, STable& Table)
+{
+	for (uint8_t i = 0; i < NumPaddedFacelets; ++i)
+		Table.m_Src[i] = i;
+
+	uint8_t SideStep  = (IsCCW ? Cube::NumSideFacelets  - 3 : 3);
+	uint8_t FrontStep = (IsCCW ? Cube::NumFrontFacelets - 2 : 2);
+	for (uint8_t i = 0; i < Cube::NumSideFacelets; ++i)
+		Table.m_Src[Indices.m_Side[i]] = Indices.m_Side[(i + SideStep) % Cube::NumSideFacelets];
+	for (uint8_t i = 0; i < Cube::NumFrontFacelets; ++i)
+		Table.m_Src[Indices.m_Front[i]] = Indices.m_Front[(i + FrontStep) % Cube::NumFrontFacelets];
+
+	// pshufb writes 0 for mask bytes with the high bit set; OR-ing the
+	// shuffles of all source blocks thus gives each destination block.
+	for (uint8_t Dst = 0; Dst < NumBlocks; ++Dst)
+		for (uint8_t Src = 0; Src < NumBlocks; ++Src)
+			for (uint8_t i = 0; i < 16; ++i)
+			{
+				uint8_t SrcIdx = Table.m_Src[Dst * 16 + i];
+				Table.m_Shuffle[Dst][Src][i] = (SrcIdx / 16 == Src ? SrcIdx % 16 : 0x80);
+			}
+}
+
+STables::STables()
+{
+	for (Layout::Type L = 0; L < Layout::NumLayouts; ++L)
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			bool IsCCW = (Rot >= Rotation::CCW);
+			Rotation::Type Face = (IsCCW ? Rot - Rotation::CCW : Rot);
+			BuildTable(g_RotationIndices[L][Face], IsCCW, m_Tables[L][Rot]);
+		}
+}
+
+// Returns the facelets of a solved cube.
+SFacelets MakeSolved()
+{
+	SFacelets State;
+	Permutation::Reset(State);
+	return State;
+}
+
+// The kernels below keep the cube in registers between rotations; Load() and
+// Store() are only needed at both ends of a sequence.
+#if defined(__AVX512VBMI__)
+
+const char* const KernelName = "avx512vbmi";
+
+struct SRegisters
+{
+	__m512i m_V;
+};
+
+inline SRegisters Load(const SFacelets& State)
+{
+	SRegisters Regs = { _mm512_load_si512(State.m_Facelets) };
+	return Regs;
+}
+
+inline void Store(const SRegisters& Regs, SFacelets& State)
+{
+	_mm512_store_si512(State.m_Facelets, Regs.m_V);
+}
+
+// GCC 12 warns about the undefined merge operand of its own
+// _mm512_permutexvar_epi8() once inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+inline void Shuffle(SRegisters& Regs, const STable& Table)
+{
+	__m512i Src = _mm512_load_si512(Table.m_Src);
+	Regs.m_V = _mm512_permutexvar_epi8(Src, Regs.m_V);
+}
+#pragma GCC diagnostic pop
+
+inline bool IsEqual(const SRegisters& A, const SRegisters& B)
+{
+	return _mm512_cmpeq_epi8_mask(A.m_V, B.m_V) == ~__mmask64(0);
+}
+
+#elif defined(__SSSE3__)
+
+const char* const KernelName = "ssse3";
+
+struct SRegisters
+{
+	__m128i m_V[NumBlocks];
+};
+
+inline SRegisters Load(const SFacelets& State)
+{
+	SRegisters Regs;
+	for (uint8_t Block = 0; Block < NumBlocks; ++Block)
+		Regs.m_V[Block] = _mm_load_si128(reinterpret_cast<const __m128i*>(State.m_Facelets) + Block);
+	return Regs;
+}
+
+inline void Store(const SRegisters& Regs, SFacelets& State)
+{
+	for (uint8_t Block = 0; Block < NumBlocks; ++Block)
+		_mm_store_si128(reinterpret_cast<__m128i*>(State.m_Facelets) + Block, Regs.m_V[Block]);
+}
+
+inline void Shuffle(SRegisters& Regs, const STable& Table)
+{
+	SRegisters Result;
+	for (uint8_t Dst = 0; Dst < NumBlocks; ++Dst)
+	{
+		const __m128i* pMasks = reinterpret_cast<const __m128i*>(Table.m_Shuffle[Dst]);
+		__m128i V = _mm_shuffle_epi8(Regs.m_V[0], _mm_load_si128(pMasks));
+		for (uint8_t Src = 1; Src < NumBlocks; ++Src)
+			V = _mm_or_si128(V, _mm_shuffle_epi8(Regs.m_V[Src], _mm_load_si128(pMasks + Src)));
+		Result.m_V[Dst] = V;
+	}
+	Regs = Result;
+}
+
+inline bool IsEqual(const SRegisters& A, const SRegisters& B)
+{
+	__m128i Eq = _mm_cmpeq_epi8(A.m_V[0], B.m_V[0]);
+	for (uint8_t Block = 1; Block < NumBlocks; ++Block)
+		Eq = _mm_and_si128(Eq, _mm_cmpeq_epi8(A.m_V[Block], B.m_V[Block]));
+	return _mm_movemask_epi8(Eq) == 0xFFFF;
+}
+
+#else
+
+const char* const KernelName = "scalar";
+
+struct SRegisters
+{
+	SFacelets m_V;
+};
+
+inline SRegisters Load(const SFacelets& State)
+{
+	SRegisters Regs = { State };
+	return Regs;
+}
+
+inline void Store(const SRegisters& Regs, SFacelets& State)
+{
+	State = Regs.m_V;
+}
+
+inline void Shuffle(SRegisters& Regs, const STable& Table)
+{
+	// Padding facelets map onto themselves, only the first 54 need moving.
+	SFacelets Old = Regs.m_V;
+	for (uint8_t i = 0; i < Cube::NumFacelets; ++i)
+		Regs.m_V.m_Facelets[i] = Old.m_Facelets[Table.m_Src[i]];
+}
+
+inline bool IsEqual(const SRegisters& A, const SRegisters& B)
+{
+	return memcmp(A.m_V.m_Facelets, B.m_V.m_Facelets, Cube::NumFacelets) == 0;
+}
+
+#endif
+
+}
+
+namespace Permutation
+{
+
+// Facelet indices affected by the rotation of a face, see Cube/layout.h.
+const SRotationIndices& GetRotationIndices(Layout::Type L, Rotation::Type Face)
+{
+	assert(L < Layout::NumLayouts);
+	assert(Face < Cube::NumFaces);
+	return g_RotationIndices[L][Face];
+}
+
+// Tables are built on first use.
+const STable& GetTable(Layout::Type L, Rotation::Type Rot)
+{
+	assert(L < Layout::NumLayouts);
+	assert(Rotation::IsRotation(Rot));
+	static const STables s_Tables;
+	return s_Tables.m_Tables[L][Rot];
+}
+
+// Name of the instruction set used by Apply().
+const char* GetKernelName()
+{
+	return KernelName;
+}
+
+// Reset cube to solved state (same for both layouts).
+void Reset(SFacelets& State)
+{
+	// Numerical order of colors in Facelet match initialization order.
+	memset(State.m_Facelets, 0, sizeof(State.m_Facelets));
+	Facelet::Type* pFacelet = State.m_Facelets;
+	for (Facelet::Type Color = 1; Color <= Cube::NumFaces; ++Color)
+		for (uint8_t i = 0; i < Cube::NumFaceletsPerFace; ++i)
+			*pFacelet++ = Color;
+}
+
+// Returns true if the cube is in the solved state.
+bool IsSolved(const SFacelets& State)
+{
+	static const SFacelets s_Solved = MakeSolved();
+	return memcmp(State.m_Facelets, s_Solved.m_Facelets, sizeof(State.m_Facelets)) == 0;
+}
+
+// Apply one permutation.
+void Apply(SFacelets& State, const STable& Table)
+{
+	SRegisters Regs = Load(State);
+	Shuffle(Regs, Table);
+	Store(Regs, State);
+}
+
+// Apply one rotation.
+void Apply(SFacelets& State, Layout::Type L, Rotation::Type Rot)
+{
+	Apply(State, GetTable(L, Rot));
+}
+
+// Apply a sequence of rotations.
+void Apply(SFacelets& State, Layout::Type L, const Rotation::Type* pRots, size_t NumRots)
+{
+	const STable* pTables = &GetTable(L, 0);
+	SRegisters Regs = Load(State);
+	for (size_t i = 0; i < NumRots; ++i)
+	{
+		assert(Rotation::IsRotation(pRots[i]));
+		Shuffle(Regs, pTables[pRots[i]]);
+	}
+	Store(Regs, State);
+}
+
+// Apply a sequence of rotations, stopping as soon as the cube is solved.
+// Returns the number of rotations applied.
+size_t ApplyUntilSolved(SFacelets& State, Layout::Type L, const Rotation::Type* pRots, size_t NumRots)
+{
+	static const SFacelets s_Solved = MakeSolved();
+	const STable* pTables = &GetTable(L, 0);
+	const SRegisters Solved = Load(s_Solved);
+	SRegisters Regs = Load(State);
+	size_t i = 0;
+	while (i < NumRots)
+	{
+		assert(Rotation::IsRotation(pRots[i]));
+		Shuffle(Regs, pTables[pRots[i++]]);
+		if (IsEqual(Regs, Solved))
+			break;
+	}
+	Store(Regs, State);
+	return i;
+}
+
+}
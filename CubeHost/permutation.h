@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+
+// Host-only: rotations applied as a single permutation of the 54 facelets,
+// without going through the animation steps of Cube::SState.
+namespace Permutation
+{
+const uint8_t NumPaddedFacelets = 64;	// 54 facelets, padded to a full SIMD register.
+
+// Facelet indices affected by the rotation of a face, see Cube/layout.h.
+struct SRotationIndices
+{
+	uint8_t m_Side[Cube::NumSideFacelets];		// facelets on the side of the turning face.
+	uint8_t m_Front[Cube::NumFrontFacelets];	// facelets on the front of the turning face, excluding the center.
+	uint8_t m_Center;				// center facelet of the turning face.
+};
+
+// Facelets of one cube, in LED order. Padding facelets are always 0.
+struct alignas(64) SFacelets
+{
+	Facelet::Type m_Facelets[NumPaddedFacelets];
+};
+
+// Permutation of the facelets performed by one rotation: after the rotation,
+// facelet i holds the value previously held by facelet m_Src[i]. The same
+// permutation is also stored as pshufb masks, one per pair of 16-byte blocks.
+struct alignas(64) STable
+{
+	uint8_t m_Src[NumPaddedFacelets];
+	uint8_t m_Shuffle[NumPaddedFacelets / 16][NumPaddedFacelets / 16][16];	// [dest block][source block][byte]
+};
+
+const SRotationIndices& GetRotationIndices(Layout::Type L, Rotation::Type Face);
+const STable& GetTable(Layout::Type L, Rotation::Type Rot);	// Tables are built on first use.
+const char* GetKernelName();		// Name of the instruction set used by Apply().
+
+void Reset(SFacelets& State);		// Reset cube to solved state (same for both layouts).
+bool IsSolved(const SFacelets& State);	// Returns true if the cube is in the solved state.
+
+void Apply(SFacelets& State, const STable& Table);	// Apply one permutation.
+void Apply(SFacelets& State, Layout::Type L, Rotation::Type Rot);	// Apply one rotation.
+void Apply(SFacelets& State, Layout::Type L, const Rotation::Type* pRots, size_t NumRots);	// Apply a sequence of rotations.
+
+// Apply a sequence of rotations, stopping as soon as the cube is solved.
+// Returns the number of rotations applied.
+size_t ApplyUntilSolved(SFacelets& State, Layout::Type L, const Rotation::Type* pRots, size_t NumRots);
+}
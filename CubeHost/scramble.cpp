@@ -0,0 +1,57 @@
+#include "scramble.h"
+#include "../Cube/config.h"
+#include "../Cube/sequence.h"
+#include <algorithm>
+
+namespace Scramble
+{
+
+// Uniformly random valid state.
+void GetRandomState(std::mt19937_64& Rng, Cubies::SCubies& State)
+{
+	Cubies::Reset(State);
+	std::shuffle(State.m_Corners, State.m_Corners + Cubies::NumCorners, Rng);
+	std::shuffle(State.m_Edges, State.m_Edges + Cubies::NumEdges, Rng);
+
+	// Swapping two edges maps the odd edge permutations one-to-one onto the
+	// even ones: the result is uniform among those of the right parity.
+	if (Cubies::IsOddPermutation(State.m_Corners, Cubies::NumCorners) != Cubies::IsOddPermutation(State.m_Edges, Cubies::NumEdges))
+		std::swap(State.m_Edges[Cubies::NumEdges - 2], State.m_Edges[Cubies::NumEdges - 1]);
+
+	Cubies::SetTwist(State, std::uniform_int_distribution<uint16_t>(0, Cubies::NumTwists - 1)(Rng));
+	Cubies::SetFlip(State, std::uniform_int_distribution<uint16_t>(0, Cubies::NumFlips - 1)(Rng));
+	assert(Cubies::IsValid(State));
+}
+
+// Scramble reaching a uniformly random state.
+void Generate(const TwoPhase::STables& Tables, std::mt19937_64& Rng, uint8_t MaxMoves, uint32_t TimeoutMs, SScramble& Scramble)
+{
+	GetRandomState(Rng, Scramble.m_State);
+
+	// The solution reversed, each rotation undone, leads from the solved
+	// cube to the state.
+	TwoPhase::SSolution Solution;
+	bool IsValid = TwoPhase::Solve(Tables, Scramble.m_State, MaxMoves, TimeoutMs, Solution);
+	assert(IsValid);
+	(void)IsValid;
+	for (uint8_t RotIdx = 0; RotIdx < Solution.m_NumRots; ++RotIdx)
+		Scramble.m_Rots[RotIdx] = Rotation::Opposite(Solution.m_Rots[Solution.m_NumRots - 1 - RotIdx]);
+	Scramble.m_NumRots  = Sequence::Canonicalize(Scramble.m_Rots, Solution.m_NumRots);
+	Scramble.m_NumMoves = Solution.m_NumMoves;
+}
+
+// Scramble of NumRots reduced random rotations.
+void GenerateRandomMoves(std::mt19937_64& Rng, uint8_t NumRots, SScramble& Scramble)
+{
+	assert(NumRots <= TwoPhase::MaxSolutionRotations);
+	std::uniform_int_distribution<unsigned> RandomRot(0, Rotation::NumRotations - 1);
+	Scramble.m_NumRots = 0;
+	while (Scramble.m_NumRots < NumRots)
+		Scramble.m_NumRots = Sequence::Append(Scramble.m_Rots, Scramble.m_NumRots, Rotation::Type(RandomRot(Rng)));
+	Scramble.m_NumMoves = 0;
+
+	Cubies::Reset(Scramble.m_State);
+	Cubies::Apply(Scramble.m_State, Scramble.m_Rots, Scramble.m_NumRots);
+}
+
+}
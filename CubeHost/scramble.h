@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <random>
+#include "../Cube/cube.h"
+#include "cubies.h"
+#include "twophase.h"
+
+// Host-only: scrambles reaching a uniformly random state, every one of the
+// 4.3 * 10^19 valid states being equally likely. Random moves do not give a
+// uniform sample (states close to the starting one are favored), so the state
+// is drawn first, and the scramble is the inverse of a two-phase solution of
+// it (about 20 face turns).
+namespace Scramble
+{
+struct SScramble
+{
+	Cubies::SCubies m_State;		// State reached from the solved cube.
+	Rotation::Type  m_Rots[TwoPhase::MaxSolutionRotations];
+	uint8_t         m_NumRots;
+	uint8_t         m_NumMoves;		// Number of face turns.
+};
+
+// Uniformly random valid state: random permutations of the same parity and
+// random orientations.
+void GetRandomState(std::mt19937_64& Rng, Cubies::SCubies& State);
+
+// Scramble reaching a uniformly random state, see TwoPhase::Solve() for
+// MaxMoves and TimeoutMs.
+void Generate(const TwoPhase::STables& Tables, std::mt19937_64& Rng, uint8_t MaxMoves, uint32_t TimeoutMs, SScramble& Scramble);
+
+// Scramble of NumRots random rotations reduced as they are drawn, as done by
+// the firmware before (see Sequence::Append()), for comparison. NumRots must
+// not exceed TwoPhase::MaxSolutionRotations. m_NumMoves is not set.
+void GenerateRandomMoves(std::mt19937_64& Rng, uint8_t NumRots, SScramble& Scramble);
+}
@@ -0,0 +1,208 @@
+#include "symmetry.h"
+#include "../Cube/config.h"
+#include <string.h>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Cubies::SCubies;
+using Cubies::NumCorners;
+using Cubies::NumEdges;
+using Cubies::CubieMask;
+using Cubies::OriShift;
+using Symmetry::NumSymmetries;
+
+// Reflections turn corners inside out: their corner orientations are 3 to 5
+// (3 + twist, the faces being listed counterclockwise).
+const uint8_t MirroredOri = 3;
+
+// Basic symmetries, see symmetry.h, as states (cubie | orientation << OriShift).
+const SCubies g_URF3 =
+{
+	{ 0x10, 0x24, 0x15, 0x21, 0x23, 0x17, 0x26, 0x12 },
+	{ 0x11, 0x08, 0x15, 0x09, 0x13, 0x0B, 0x17, 0x0A, 0x10, 0x14, 0x16, 0x12 }
+};
+const SCubies g_F2 =
+{
+	{ 0x05, 0x04, 0x07, 0x06, 0x01, 0x00, 0x03, 0x02 },
+	{ 0x06, 0x05, 0x04, 0x07, 0x02, 0x01, 0x00, 0x03, 0x09, 0x08, 0x0B, 0x0A }
+};
+const SCubies g_U4 =
+{
+	{ 0x03, 0x00, 0x01, 0x02, 0x07, 0x04, 0x05, 0x06 },
+	{ 0x03, 0x00, 0x01, 0x02, 0x07, 0x04, 0x05, 0x06, 0x1B, 0x18, 0x19, 0x1A }
+};
+const SCubies g_LR2 =
+{
+	{ 0x31, 0x30, 0x33, 0x32, 0x35, 0x34, 0x37, 0x36 },
+	{ 0x02, 0x01, 0x00, 0x03, 0x06, 0x05, 0x04, 0x07, 0x09, 0x08, 0x0B, 0x0A }
+};
+
+// All tables, built on first use.
+struct STables
+{
+	SCubies        m_Symmetries[NumSymmetries];
+	Symmetry::Type m_Inverses[NumSymmetries];
+	Rotation::Type m_Rotations[NumSymmetries][Rotation::NumRotations];	// Conjugates of the rotations.
+
+	STables();
+};
+
+// Sum of two corner orientations, either of them possibly mirrored. The
+// twist of a mirrored corner is counted the other way round.
+uint8_t AddCornerOri(uint8_t OriA, uint8_t OriB)
+{
+	if (OriB < MirroredOri)
+		return (OriA < MirroredOri ? (OriA + OriB) % 3 : MirroredOri + (OriA - MirroredOri + 3 - OriB) % 3);
+	return (OriA < MirroredOri ? MirroredOri + (OriA + OriB - MirroredOri) % 3 : (OriA + 3 - (OriB - MirroredOri)) % 3);
+}
+
+// Cubies::Multiply(), also for states with mirrored corners.
+void MultiplyMirrored(const SCubies& A, const SCubies& B, SCubies& Result)
+{
+	assert(&Result != &A && &Result != &B);
+	for (uint8_t i = 0; i < NumCorners; ++i)
+	{
+		uint8_t CubieB = B.m_Corners[i];
+		uint8_t CubieA = A.m_Corners[CubieB & CubieMask];
+		uint8_t Ori = AddCornerOri(CubieA >> OriShift, CubieB >> OriShift);
+		Result.m_Corners[i] = (CubieA & CubieMask) | (Ori << OriShift);
+	}
+	for (uint8_t i = 0; i < NumEdges; ++i)
+	{
+		uint8_t CubieB = B.m_Edges[i];
+		uint8_t CubieA = A.m_Edges[CubieB & CubieMask];
+		Result.m_Edges[i] = CubieA ^ (CubieB & ~CubieMask);
+	}
+}
+
+bool IsEqual(const SCubies& A, const SCubies& B)
+{
+	return memcmp(&A, &B, sizeof(SCubies)) == 0;
+}
+
+void Conjugate(const STables& Tables, const SCubies& State, Symmetry::Type Sym, SCubies& Result)
+{
+	SCubies Temp;
+	MultiplyMirrored(Tables.m_Symmetries[Tables.m_Inverses[Sym]], State, Temp);
+	MultiplyMirrored(Temp, Tables.m_Symmetries[Sym], Result);
+}
+
+STables::STables()
+{
+	// URF3^a * F2^b * U4^c * LR2^d, in the order of the symmetry indices.
+	SCubies Sym;
+	Cubies::Reset(Sym);
+	uint8_t SymIdx = 0;
+	for (uint8_t a = 0; a < 3; ++a)
+	{
+		for (uint8_t b = 0; b < 2; ++b)
+		{
+			for (uint8_t c = 0; c < 4; ++c)
+			{
+				for (uint8_t d = 0; d < 2; ++d)
+				{
+					m_Symmetries[SymIdx++] = Sym;
+					SCubies Old = Sym;
+					MultiplyMirrored(Old, g_LR2, Sym);
+				}
+				SCubies Old = Sym;
+				MultiplyMirrored(Old, g_U4, Sym);
+			}
+			SCubies Old = Sym;
+			MultiplyMirrored(Old, g_F2, Sym);
+		}
+		SCubies Old = Sym;
+		MultiplyMirrored(Old, g_URF3, Sym);
+	}
+
+	SCubies Solved, Product;
+	Cubies::Reset(Solved);
+	for (Symmetry::Type i = 0; i < NumSymmetries; ++i)
+	{
+		m_Inverses[i] = NumSymmetries;
+		for (Symmetry::Type j = 0; j < NumSymmetries && m_Inverses[i] == NumSymmetries; ++j)
+		{
+			MultiplyMirrored(m_Symmetries[i], m_Symmetries[j], Product);
+			if (IsEqual(Product, Solved))
+				m_Inverses[i] = j;
+		}
+		assert(m_Inverses[i] < NumSymmetries);
+	}
+
+	// The conjugate of a rotation is a rotation.
+	for (Symmetry::Type Sym = 0; Sym < NumSymmetries; ++Sym)
+	{
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			Conjugate(*this, Cubies::GetRotation(Rot), Sym, Product);
+			m_Rotations[Sym][Rot] = Rotation::None;
+			for (Rotation::Type Other = 0; Other < Rotation::NumRotations; ++Other)
+				if (IsEqual(Product, Cubies::GetRotation(Other)))
+					m_Rotations[Sym][Rot] = Other;
+			assert(m_Rotations[Sym][Rot] != Rotation::None);
+		}
+	}
+}
+
+const STables& GetTables()
+{
+	static const STables s_Tables;
+	return s_Tables;
+}
+
+}
+
+namespace Symmetry
+{
+
+// Symmetry S' such that S * S' is the identity.
+Type GetInverse(Type Sym)
+{
+	assert(Sym < NumSymmetries);
+	return GetTables().m_Inverses[Sym];
+}
+
+// Conjugate of a state, S^-1 * State * S.
+void Conjugate(const Cubies::SCubies& State, Type Sym, Cubies::SCubies& Result)
+{
+	assert(Sym < NumSymmetries);
+	::Conjugate(GetTables(), State, Sym, Result);
+}
+
+// Conjugate of a rotation.
+Rotation::Type ConjugateRotation(Rotation::Type Rot, Type Sym)
+{
+	assert(Rotation::IsRotation(Rot) && Sym < NumSymmetries);
+	return GetTables().m_Rotations[Sym][Rot];
+}
+
+// Representative of the symmetry class of a state, and the symmetry mapping
+// it back to the state.
+Type GetRepresentative(const Cubies::SCubies& State, Cubies::SCubies& Rep, uint8_t* pNumSelfSymmetries)
+{
+	assert(&Rep != &State);
+	const STables& Tables = GetTables();
+	Rep = State;
+	Type RepSym = Identity;
+	uint8_t NumSelfSymmetries = 1;
+	SCubies Conj;
+	for (Type Sym = 1; Sym < NumSymmetries; ++Sym)
+	{
+		::Conjugate(Tables, State, Sym, Conj);
+		if (memcmp(&Conj, &Rep, sizeof(SCubies)) < 0)
+		{
+			Rep = Conj;
+			RepSym = Sym;
+		}
+		if (IsEqual(Conj, State))
+			++NumSelfSymmetries;
+	}
+	if (pNumSelfSymmetries != NULL)
+		*pNumSelfSymmetries = NumSelfSymmetries;
+
+	// Rep = S^-1 * State * S, so State = S * Rep * S^-1.
+	return Tables.m_Inverses[RepSym];
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "cubies.h"
+
+// Host-only: the 48 symmetries of the cube (24 rotations of the whole cube,
+// each optionally followed by a reflection), used to store one state per
+// symmetry class instead of up to 48.
+//
+// A symmetry S acts on a state X by conjugation, S^-1 * X * S (see
+// Cubies::Multiply): the conjugate is X seen from another side or in a mirror,
+// and is solved by the conjugate of the solutions of X, in the same number of
+// rotations. Distance tables and state sets can therefore be indexed by the
+// representative of each class, the conjugate that sorts first.
+//
+// Symmetry 16*a + 8*b + 2*c + d is URF3^a * F2^b * U4^c * LR2^d, where URF3
+// turns the cube by 120 degrees around the URF-DBL diagonal, F2 by 180
+// degrees around the F axis, U4 by 90 degrees around the U axis, and LR2
+// mirrors left and right. Odd symmetries are reflections, symmetries 0 to 15
+// keep the U-D axis.
+namespace Symmetry
+{
+typedef uint8_t Type;
+const Type Identity         = 0;
+const Type NumSymmetries    = 48;
+const Type NumUDSymmetries  = 16;	// Symmetries 0 to 15 map the U-D axis to itself.
+
+inline bool IsReflection(Type Sym)
+{
+	assert(Sym < NumSymmetries);
+	return (Sym & 1) != 0;
+}
+
+Type GetInverse(Type Sym);		// Symmetry S' such that S * S' is the identity.
+
+// Conjugate of a state, S^-1 * State * S.
+void Conjugate(const Cubies::SCubies& State, Type Sym, Cubies::SCubies& Result);
+
+// Conjugate of a rotation: applying it to Conjugate(X, Sym) gives the
+// conjugate of X followed by Rot. Reflections turn clockwise rotations into
+// counterclockwise ones.
+Rotation::Type ConjugateRotation(Rotation::Type Rot, Type Sym);
+
+// Representative of the symmetry class of a state: its conjugate whose bytes
+// (m_Corners then m_Edges) sort first. Returns the symmetry mapping the
+// representative back to the state, i.e. Conjugate(Rep, Sym) == State.
+// pNumSelfSymmetries, if not NULL, receives the number of symmetries mapping
+// the state to itself (the class has 48 / *pNumSelfSymmetries states).
+Type GetRepresentative(const Cubies::SCubies& State, Cubies::SCubies& Rep, uint8_t* pNumSelfSymmetries);
+}
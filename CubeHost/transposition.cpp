@@ -0,0 +1,116 @@
+#include "transposition.h"
+#include "../Cube/config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Transposition::Key;
+
+const Key EmptyKey = 0;
+
+// Key 0 marks empty slots: the (unlikely) hash 0 is stored as 1.
+inline Key GetStoredKey(Key K)
+{
+	return (K == EmptyKey ? 1 : K);
+}
+
+// First slot probed. The low bits of a Zobrist hash are as random as its
+// high bits, but other hashes may not be: the key is mixed first.
+inline size_t GetFirstSlot(const Transposition::STable& Table, Key K)
+{
+	uint64_t H = K * 0x9E3779B97F4A7C15ull;
+	return size_t(H ^ (H >> 32)) & Table.m_Mask;
+}
+
+}
+
+namespace Transposition
+{
+
+// Create an empty table of 2^NumSlotsLog2 slots.
+void Create(STable& Table, unsigned NumSlotsLog2)
+{
+	assert(NumSlotsLog2 < 8 * sizeof(size_t) - 4);
+	size_t NumSlots = size_t(1) << NumSlotsLog2;
+	Table.m_Slots.reset(new SSlot[NumSlots]);
+	Table.m_Mask = NumSlots - 1;
+	Clear(Table);
+}
+
+// Remove all the entries.
+void Clear(STable& Table)
+{
+	for (size_t Slot = 0; Slot <= Table.m_Mask; ++Slot)
+	{
+		Table.m_Slots[Slot].m_Key.store(EmptyKey, std::memory_order_relaxed);
+		Table.m_Slots[Slot].m_Value.store(PendingValue, std::memory_order_relaxed);
+	}
+}
+
+size_t GetNumSlots(const STable& Table)
+{
+	return Table.m_Mask + 1;
+}
+
+// Bytes used by the slots.
+size_t GetMemorySize(const STable& Table)
+{
+	return GetNumSlots(Table) * sizeof(SSlot);
+}
+
+// Number of entries, scanning the whole table.
+size_t Count(const STable& Table)
+{
+	size_t NumEntries = 0;
+	for (size_t Slot = 0; Slot <= Table.m_Mask; ++Slot)
+		NumEntries += (Table.m_Slots[Slot].m_Key.load(std::memory_order_relaxed) != EmptyKey);
+	return NumEntries;
+}
+
+// Add a key with its value if it is not in the table yet.
+Result Insert(STable& Table, Key K, uint32_t Value)
+{
+	assert(Value != PendingValue);
+	K = GetStoredKey(K);
+	size_t Slot = GetFirstSlot(Table, K);
+	for (size_t Probe = 0; Probe < MaxProbes && Probe <= Table.m_Mask; ++Probe, Slot = (Slot + 1) & Table.m_Mask)
+	{
+		SSlot& S = Table.m_Slots[Slot];
+		Key Current = S.m_Key.load(std::memory_order_acquire);
+		if (Current == EmptyKey)
+		{
+			// On failure, Current receives the key of the thread that
+			// claimed the slot first, which may be the same key.
+			if (S.m_Key.compare_exchange_strong(Current, K, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				S.m_Value.store(Value, std::memory_order_release);
+				return Added;
+			}
+		}
+		if (Current == K)
+			return Found;
+	}
+	return Full;
+}
+
+// Value of a key.
+bool Find(const STable& Table, Key K, uint32_t& Value)
+{
+	K = GetStoredKey(K);
+	size_t Slot = GetFirstSlot(Table, K);
+	for (size_t Probe = 0; Probe < MaxProbes && Probe <= Table.m_Mask; ++Probe, Slot = (Slot + 1) & Table.m_Mask)
+	{
+		const SSlot& S = Table.m_Slots[Slot];
+		Key Current = S.m_Key.load(std::memory_order_acquire);
+		if (Current == EmptyKey)
+			return false;
+		if (Current == K)
+		{
+			Value = S.m_Value.load(std::memory_order_acquire);
+			return Value != PendingValue;
+		}
+	}
+	return false;
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+// Host-only: fixed-size hash table of states keyed by their 64-bit hash (see
+// CubeHost/zobrist.h), with one value per state, shared by several threads
+// without locks.
+//
+// Slots are claimed by a compare-and-swap of their key, and collisions are
+// resolved by linear probing. Entries are never removed nor moved, so a key
+// stays in its slot once it is written. Threads only write to the slots they
+// claim, and nothing else is shared: there is no counter of entries. The
+// table does not grow; it should be kept at most 3/4 full.
+//
+// As usual with transposition tables, states are only told apart by their
+// hash: two states of the same hash are the same entry (for 64-bit hashes,
+// about one chance in 10^7 for a billion states).
+namespace Transposition
+{
+typedef uint64_t Key;
+
+const uint32_t PendingValue = 0xFFFFFFFF;	// Reserved: value of a slot claimed but not written yet.
+const size_t   MaxProbes = 1024;		// Slots probed before giving up.
+
+struct SSlot
+{
+	std::atomic<Key>      m_Key;		// 0 if empty.
+	std::atomic<uint32_t> m_Value;
+};
+
+struct STable
+{
+	std::unique_ptr<SSlot[]> m_Slots;
+	size_t                   m_Mask;	// Number of slots minus one.
+};
+
+// "enum" of the results of Insert().
+typedef uint8_t Result;
+const Result Added = 0;		// The key was not in the table.
+const Result Found = 1;		// The key was already in the table, its value is unchanged.
+const Result Full  = 2;		// The key is not in the table and there is no room for it.
+
+// Create an empty table of 2^NumSlotsLog2 slots. Not thread-safe.
+void Create(STable& Table, unsigned NumSlotsLog2);
+void Clear(STable& Table);			// Remove all the entries. Not thread-safe.
+size_t GetNumSlots(const STable& Table);
+size_t GetMemorySize(const STable& Table);	// Bytes used by the slots.
+size_t Count(const STable& Table);		// Number of entries, scanning the whole table.
+
+// Add a key with its value (not PendingValue) if it is not in the table yet.
+Result Insert(STable& Table, Key K, uint32_t Value);
+
+// Value of a key. Returns false if it is not in the table, or if the thread
+// inserting it has not written its value yet.
+bool Find(const STable& Table, Key K, uint32_t& Value);
+}
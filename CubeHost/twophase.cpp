@@ -0,0 +1,634 @@
+#include "twophase.h"
+#include "../Cube/config.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Cubies::SCubies;
+using Cubies::CubieMask;
+using Cubies::OriShift;
+using TwoPhase::STables;
+
+// Moves of the search: Face * 3 + Turn, for the clockwise quarter turn, the
+// half turn and the counterclockwise quarter turn of each face, in the order
+// of Rotation::Type.
+const uint8_t NumMoves = 3 * Cube::NumFaces;
+const uint8_t HalfTurn = 1, CCWTurn = 2;
+
+// Moves of phase 2: quarter turns of U and D, half turns of the other faces.
+const uint8_t NumPhase2Moves = 10;
+const uint8_t Phase2Moves[NumPhase2Moves] = {0, 1, 2, 4, 7, 10, 13, 15, 16, 17};
+
+// Sizes of the coordinates.
+const uint32_t NumTwists       = Cubies::NumTwists;
+const uint32_t NumFlips        = Cubies::NumFlips;
+const uint32_t NumSlices       = 495;	// C(12, 4): positions of the 4 middle-slice edges.
+const uint32_t NumSliceOrders  = 24;	// 4!: order of the 4 middle-slice edges.
+const uint32_t NumSliceSorted  = NumSlices * NumSliceOrders;
+const uint32_t NumCornerPerms  = 40320;	// 8!
+const uint32_t NumUDEdgePerms  = 40320;	// 8!
+
+// Longest phase 2 searched. Every phase 2 position is solved in 18 moves.
+const uint8_t MaxPhase2Moves = 18;
+
+// Pruning tables store distances up to 14, 15 marks unvisited entries.
+const uint8_t UnknownDistance = 15;
+
+// Header of the cache file. Tables follow, each at a multiple of TableAlign.
+struct SFileHeader
+{
+	char     m_Magic[8];		// "RUBIK2PH"
+	uint32_t m_Version;		// FileVersion
+	uint32_t m_Reserved;		// Always 0.
+	uint64_t m_Size;		// Size of the file.
+};
+
+const char     Magic[sizeof(SFileHeader().m_Magic)] = {'R', 'U', 'B', 'I', 'K', '2', 'P', 'H'};
+const uint32_t FileVersion = 1;
+const size_t   TableAlign  = 64;
+
+// Offsets of the tables in the cache file.
+struct SFileLayout
+{
+	size_t m_TwistMoves;
+	size_t m_FlipMoves;
+	size_t m_SliceSortedMoves;
+	size_t m_CornerMoves;
+	size_t m_UDEdgeMoves;
+	size_t m_TwistSlicePrun;
+	size_t m_FlipSlicePrun;
+	size_t m_CornerSlicePrun;
+	size_t m_UDEdgeSlicePrun;
+	size_t m_Size;
+};
+
+// Reserve Size bytes at the end of the file. Returns the offset.
+size_t AddTable(size_t& FileSize, size_t Size)
+{
+	size_t Offset = (FileSize + TableAlign - 1) / TableAlign * TableAlign;
+	FileSize = Offset + Size;
+	return Offset;
+}
+
+const SFileLayout& GetFileLayout()
+{
+	static SFileLayout s_Layout;
+	if (s_Layout.m_Size == 0)
+	{
+		size_t Size = sizeof(SFileHeader);
+		s_Layout.m_TwistMoves       = AddTable(Size, NumTwists      * NumMoves * sizeof(uint16_t));
+		s_Layout.m_FlipMoves        = AddTable(Size, NumFlips       * NumMoves * sizeof(uint16_t));
+		s_Layout.m_SliceSortedMoves = AddTable(Size, NumSliceSorted * NumMoves * sizeof(uint16_t));
+		s_Layout.m_CornerMoves      = AddTable(Size, NumCornerPerms * NumMoves * sizeof(uint16_t));
+		s_Layout.m_UDEdgeMoves      = AddTable(Size, NumUDEdgePerms * NumPhase2Moves * sizeof(uint16_t));
+		s_Layout.m_TwistSlicePrun   = AddTable(Size, (NumTwists      * NumSlices      + 1) / 2);
+		s_Layout.m_FlipSlicePrun    = AddTable(Size, (NumFlips       * NumSlices      + 1) / 2);
+		s_Layout.m_CornerSlicePrun  = AddTable(Size, (NumCornerPerms * NumSliceOrders + 1) / 2);
+		s_Layout.m_UDEdgeSlicePrun  = AddTable(Size, (NumUDEdgePerms * NumSliceOrders + 1) / 2);
+		s_Layout.m_Size = Size;
+	}
+	return s_Layout;
+}
+
+// Point the tables into the given data, laid out as in the cache file.
+void SetPointers(STables& Tables, const uint8_t* pData, size_t Size)
+{
+	const SFileLayout& FileLayout = GetFileLayout();
+	Tables.m_pData             = pData;
+	Tables.m_Size              = Size;
+	Tables.m_pTwistMoves       = reinterpret_cast<const uint16_t*>(pData + FileLayout.m_TwistMoves);
+	Tables.m_pFlipMoves        = reinterpret_cast<const uint16_t*>(pData + FileLayout.m_FlipMoves);
+	Tables.m_pSliceSortedMoves = reinterpret_cast<const uint16_t*>(pData + FileLayout.m_SliceSortedMoves);
+	Tables.m_pCornerMoves      = reinterpret_cast<const uint16_t*>(pData + FileLayout.m_CornerMoves);
+	Tables.m_pUDEdgeMoves      = reinterpret_cast<const uint16_t*>(pData + FileLayout.m_UDEdgeMoves);
+	Tables.m_pTwistSlicePrun   = pData + FileLayout.m_TwistSlicePrun;
+	Tables.m_pFlipSlicePrun    = pData + FileLayout.m_FlipSlicePrun;
+	Tables.m_pCornerSlicePrun  = pData + FileLayout.m_CornerSlicePrun;
+	Tables.m_pUDEdgeSlicePrun  = pData + FileLayout.m_UDEdgeSlicePrun;
+}
+
+// State after each move of a solved cube.
+const SCubies& GetMove(uint8_t Move)
+{
+	static SCubies s_Moves[NumMoves];
+	static bool s_IsInitialized = false;
+	if (!s_IsInitialized)
+	{
+		for (Rotation::Type Face = 0; Face < Cube::NumFaces; ++Face)
+		{
+			s_Moves[3 * Face] = Cubies::GetRotation(Face);
+			Cubies::Multiply(s_Moves[3 * Face], s_Moves[3 * Face], s_Moves[3 * Face + HalfTurn]);
+			s_Moves[3 * Face + CCWTurn] = Cubies::GetRotation(Face + Rotation::CCW);
+		}
+		s_IsInitialized = true;
+	}
+	return s_Moves[Move];
+}
+
+// Returns true if the move may follow the previous one. A face is not turned
+// twice in a row, and of two opposite faces turned in a row, the lower one
+// comes first (the moves commute).
+inline bool IsAllowedAfter(uint8_t Move, uint8_t PrevMove)
+{
+	Rotation::Type Face = Move / 3, PrevFace = PrevMove / 3;
+	return Face != PrevFace && !(Face < PrevFace && Face == Rotation::OppositeFace(PrevFace));
+}
+
+uint32_t Choose(uint8_t N, uint8_t K)
+{
+	if (K > N)
+		return 0;
+	uint32_t Result = 1;
+	for (uint8_t i = 1; i <= K; ++i)
+		Result = Result * (N - K + i) / i;
+	return Result;
+}
+
+// Coordinates. Each Get function depends only on its part of the state, each
+// Set function builds a valid state with that part (other parts solved).
+
+// Orientations, solved permutation.
+void SetTwist(SCubies& State, uint16_t Twist)
+{
+	Cubies::Reset(State);
+	Cubies::SetTwist(State, Twist);
+}
+
+void SetFlip(SCubies& State, uint16_t Flip)
+{
+	Cubies::Reset(State);
+	Cubies::SetFlip(State, Flip);
+}
+
+// Positions of the middle-slice edges (FR, FL, BL, BR) as a combination, 0
+// when they are in the middle slice, times 24 plus the rank of their order.
+// Phase 1 only needs the positions (SliceSorted / 24).
+uint16_t GetSliceSorted(const SCubies& State)
+{
+	uint16_t Slice = 0;
+	uint8_t SliceEdges[4];
+	uint8_t NumFound = 0;
+	for (uint8_t Pos = Cubies::NumEdges; Pos-- > 0; )
+	{
+		uint8_t Edge = State.m_Edges[Pos] & CubieMask;
+		if (Edge >= Cubies::FR)
+		{
+			Slice += Choose(Cubies::NumEdges - 1 - Pos, NumFound + 1);
+			SliceEdges[3 - NumFound++] = Edge;
+		}
+	}
+	return Slice * NumSliceOrders + uint16_t(Cubies::RankPermutation(SliceEdges, 4));
+}
+
+void SetSliceSorted(SCubies& State, uint16_t SliceSorted)
+{
+	uint8_t SliceEdges[4];
+	Cubies::UnrankPermutation(SliceSorted % NumSliceOrders, SliceEdges, 4);
+	uint32_t Slice = SliceSorted / NumSliceOrders;
+
+	uint8_t NumLeft = 4, OtherEdge = 0;
+	for (uint8_t Pos = 0; Pos < Cubies::NumEdges; ++Pos)
+	{
+		uint32_t Count = Choose(Cubies::NumEdges - 1 - Pos, NumLeft);
+		if (NumLeft > 0 && Slice >= Count)
+		{
+			Slice -= Count;
+			State.m_Edges[Pos] = Cubies::FR + SliceEdges[4 - NumLeft--];
+		}
+		else
+			State.m_Edges[Pos] = OtherEdge++;
+	}
+}
+
+// Corner permutation.
+uint16_t GetCornerPerm(const SCubies& State)
+{
+	return uint16_t(Cubies::RankPermutation(State.m_Corners, Cubies::NumCorners));
+}
+
+void SetCornerPerm(SCubies& State, uint16_t Perm)
+{
+	Cubies::UnrankPermutation(Perm, State.m_Corners, Cubies::NumCorners);
+}
+
+// Permutation of the edges of the U and D faces, which stay in these faces
+// in phase 2.
+uint16_t GetUDEdgePerm(const SCubies& State)
+{
+	return uint16_t(Cubies::RankPermutation(State.m_Edges, Cubies::FR));
+}
+
+void SetUDEdgePerm(SCubies& State, uint16_t Perm)
+{
+	Cubies::UnrankPermutation(Perm, State.m_Edges, Cubies::FR);
+	for (uint8_t Pos = Cubies::FR; Pos < Cubies::NumEdges; ++Pos)
+		State.m_Edges[Pos] = Pos;
+}
+
+// Fill a move table: pTable[Coord * NumTableMoves + i] is the coordinate
+// after pMoves[i].
+template<typename GetFunc, typename SetFunc>
+void BuildMoveTable(uint16_t* pTable, uint32_t NumCoords, const uint8_t* pMoves, uint8_t NumTableMoves, GetFunc Get, SetFunc Set)
+{
+	SCubies State, Moved;
+	Cubies::Reset(State);
+	for (uint32_t Coord = 0; Coord < NumCoords; ++Coord)
+	{
+		Set(State, uint16_t(Coord));
+		for (uint8_t i = 0; i < NumTableMoves; ++i)
+		{
+			Cubies::Multiply(State, GetMove(pMoves[i]), Moved);
+			pTable[Coord * NumTableMoves + i] = Get(Moved);
+		}
+	}
+}
+
+inline uint8_t GetDistance(const uint8_t* pTable, uint32_t Idx)
+{
+	return (pTable[Idx >> 1] >> ((Idx & 1) * 4)) & 0x0F;
+}
+
+inline void SetDistance(uint8_t* pTable, uint32_t Idx, uint8_t Distance)
+{
+	uint8_t Shift = (Idx & 1) * 4;
+	pTable[Idx >> 1] = uint8_t((pTable[Idx >> 1] & ~(0x0F << Shift)) | Distance << Shift);
+}
+
+// Fill a pruning table by a breadth-first search from the entry 0 (goal).
+// Next(Idx, i) gives the entry after the i-th of NumTableMoves moves.
+template<typename NextFunc>
+void BuildPruningTable(uint8_t* pTable, uint32_t NumEntries, uint8_t NumTableMoves, NextFunc Next)
+{
+	memset(pTable, 0xFF, (NumEntries + 1) / 2);
+	SetDistance(pTable, 0, 0);
+	uint32_t NumNew = 1;
+	for (uint8_t Distance = 0; NumNew > 0; ++Distance)
+	{
+		assert(Distance + 1 < UnknownDistance);
+		NumNew = 0;
+		for (uint32_t Idx = 0; Idx < NumEntries; ++Idx)
+		{
+			if (GetDistance(pTable, Idx) != Distance)
+				continue;
+			for (uint8_t i = 0; i < NumTableMoves; ++i)
+			{
+				uint32_t NextIdx = Next(Idx, i);
+				if (GetDistance(pTable, NextIdx) == UnknownDistance)
+				{
+					SetDistance(pTable, NextIdx, Distance + 1);
+					++NumNew;
+				}
+			}
+		}
+	}
+}
+
+// Build all the tables into pData, laid out as in the cache file.
+void BuildTables(uint8_t* pData)
+{
+	const SFileLayout& FileLayout = GetFileLayout();
+	SFileHeader& Header = *reinterpret_cast<SFileHeader*>(pData);
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.m_Magic, Magic, sizeof(Magic));
+	Header.m_Version = FileVersion;
+	Header.m_Size    = FileLayout.m_Size;
+
+	uint8_t AllMoves[NumMoves];
+	for (uint8_t Move = 0; Move < NumMoves; ++Move)
+		AllMoves[Move] = Move;
+
+	uint16_t* pTwistMoves       = reinterpret_cast<uint16_t*>(pData + FileLayout.m_TwistMoves);
+	uint16_t* pFlipMoves        = reinterpret_cast<uint16_t*>(pData + FileLayout.m_FlipMoves);
+	uint16_t* pSliceSortedMoves = reinterpret_cast<uint16_t*>(pData + FileLayout.m_SliceSortedMoves);
+	uint16_t* pCornerMoves      = reinterpret_cast<uint16_t*>(pData + FileLayout.m_CornerMoves);
+	uint16_t* pUDEdgeMoves      = reinterpret_cast<uint16_t*>(pData + FileLayout.m_UDEdgeMoves);
+	BuildMoveTable(pTwistMoves,       NumTwists,      AllMoves,    NumMoves,       Cubies::GetTwist, SetTwist);
+	BuildMoveTable(pFlipMoves,        NumFlips,       AllMoves,    NumMoves,       Cubies::GetFlip,  SetFlip);
+	BuildMoveTable(pSliceSortedMoves, NumSliceSorted, AllMoves,    NumMoves,       GetSliceSorted,   SetSliceSorted);
+	BuildMoveTable(pCornerMoves,      NumCornerPerms, AllMoves,    NumMoves,       GetCornerPerm,    SetCornerPerm);
+	BuildMoveTable(pUDEdgeMoves,      NumUDEdgePerms, Phase2Moves, NumPhase2Moves, GetUDEdgePerm,    SetUDEdgePerm);
+
+	// Phase 1: (twist or flip) * NumSlices + slice positions.
+	BuildPruningTable(pData + FileLayout.m_TwistSlicePrun, NumTwists * NumSlices, NumMoves, [&](uint32_t Idx, uint8_t Move)
+	{
+		uint32_t Twist = Idx / NumSlices, Slice = Idx % NumSlices;
+		return pTwistMoves[Twist * NumMoves + Move] * NumSlices
+		     + pSliceSortedMoves[Slice * NumSliceOrders * NumMoves + Move] / NumSliceOrders;
+	});
+	BuildPruningTable(pData + FileLayout.m_FlipSlicePrun, NumFlips * NumSlices, NumMoves, [&](uint32_t Idx, uint8_t Move)
+	{
+		uint32_t Flip = Idx / NumSlices, Slice = Idx % NumSlices;
+		return pFlipMoves[Flip * NumMoves + Move] * NumSlices
+		     + pSliceSortedMoves[Slice * NumSliceOrders * NumMoves + Move] / NumSliceOrders;
+	});
+
+	// Phase 2: (corner or U/D edge permutation) * NumSliceOrders + slice order.
+	// In phase 2, the slice edges stay in the slice: SliceSorted < 24.
+	BuildPruningTable(pData + FileLayout.m_CornerSlicePrun, NumCornerPerms * NumSliceOrders, NumPhase2Moves, [&](uint32_t Idx, uint8_t i)
+	{
+		uint32_t Perm = Idx / NumSliceOrders, Order = Idx % NumSliceOrders;
+		return pCornerMoves[Perm * NumMoves + Phase2Moves[i]] * NumSliceOrders
+		     + pSliceSortedMoves[Order * NumMoves + Phase2Moves[i]];
+	});
+	BuildPruningTable(pData + FileLayout.m_UDEdgeSlicePrun, NumUDEdgePerms * NumSliceOrders, NumPhase2Moves, [&](uint32_t Idx, uint8_t i)
+	{
+		uint32_t Perm = Idx / NumSliceOrders, Order = Idx % NumSliceOrders;
+		return pUDEdgeMoves[Perm * NumPhase2Moves + i] * NumSliceOrders
+		     + pSliceSortedMoves[Order * NumMoves + Phase2Moves[i]];
+	});
+}
+
+// Map the cache file. Returns NULL if it is missing or invalid.
+const uint8_t* MapFile(const char* pPath)
+{
+	int File = open(pPath, O_RDONLY);
+	if (File < 0)
+		return NULL;
+
+	struct stat Stat;
+	void* pData = MAP_FAILED;
+	if (fstat(File, &Stat) == 0 && size_t(Stat.st_size) == GetFileLayout().m_Size)
+		pData = mmap(NULL, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);	// The mapping stays valid.
+	if (pData == MAP_FAILED)
+		return NULL;
+
+	const SFileHeader& Header = *static_cast<const SFileHeader*>(pData);
+	if (memcmp(Header.m_Magic, Magic, sizeof(Magic)) != 0 || Header.m_Version != FileVersion || Header.m_Size != size_t(Stat.st_size))
+	{
+		munmap(pData, Stat.st_size);
+		return NULL;
+	}
+	return static_cast<const uint8_t*>(pData);
+}
+
+// Write the cache file, through a temporary file so that concurrent readers
+// never see a partial file. Returns false on I/O errors.
+bool WriteFile(const char* pPath, const uint8_t* pData, size_t Size)
+{
+	char TempPath[4096];
+	if (snprintf(TempPath, sizeof(TempPath), "%s.%d.tmp", pPath, int(getpid())) >= int(sizeof(TempPath)))
+		return false;
+	FILE* pFile = fopen(TempPath, "wb");
+	if (pFile == NULL)
+		return false;
+	bool Ok = (fwrite(pData, Size, 1, pFile) == 1);
+	Ok = (fclose(pFile) == 0) && Ok;
+	Ok = Ok && rename(TempPath, pPath) == 0;
+	if (!Ok)
+		remove(TempPath);
+	return Ok;
+}
+
+// Inputs and state of a search.
+struct SSearch
+{
+	const STables* m_pTables;
+	SCubies        m_State;			// State to solve.
+	uint8_t        m_MaxMoves;		// Stop as soon as a solution is not longer.
+	uint8_t        m_Moves[TwoPhase::MaxSolutionMoves];	// Current path.
+	uint8_t        m_Phase1Moves;		// Length of phase 1 in the current path.
+	uint8_t        m_BestMoves[TwoPhase::MaxSolutionMoves];
+	uint8_t        m_NumBestMoves;		// MaxSolutionMoves + 1 while no solution is found.
+
+	std::chrono::steady_clock::time_point m_Deadline;
+	bool           m_HasDeadline;
+	uint32_t       m_NumNodes;
+	bool           m_IsStopped;		// Solution short enough, or timeout.
+};
+
+// Check the time now and then, once a solution is known. Returns true if the
+// search must stop.
+inline bool IsStopped(SSearch& Search)
+{
+	if ((++Search.m_NumNodes & 0xFFF) == 0 && Search.m_HasDeadline && Search.m_NumBestMoves <= TwoPhase::MaxSolutionMoves &&
+	    std::chrono::steady_clock::now() >= Search.m_Deadline)
+		Search.m_IsStopped = true;
+	return Search.m_IsStopped;
+}
+
+// Phase 2 search from the given coordinates, with exactly ToGo moves left.
+bool SearchPhase2(SSearch& Search, uint16_t CornerPerm, uint16_t UDEdgePerm, uint8_t SliceOrder, uint8_t Depth, uint8_t ToGo)
+{
+	if (ToGo == 0)
+		return CornerPerm == 0 && UDEdgePerm == 0 && SliceOrder == 0;
+	if (IsStopped(Search))
+		return false;
+
+	const STables& Tables = *Search.m_pTables;
+	for (uint8_t i = 0; i < NumPhase2Moves; ++i)
+	{
+		uint8_t Move = Phase2Moves[i];
+		if (Depth > 0 && !IsAllowedAfter(Move, Search.m_Moves[Depth - 1]))
+			continue;
+
+		uint16_t NextCornerPerm = Tables.m_pCornerMoves[CornerPerm * NumMoves + Move];
+		uint16_t NextUDEdgePerm = Tables.m_pUDEdgeMoves[UDEdgePerm * NumPhase2Moves + i];
+		uint8_t NextSliceOrder  = uint8_t(Tables.m_pSliceSortedMoves[SliceOrder * NumMoves + Move]);
+		if (GetDistance(Tables.m_pCornerSlicePrun, NextCornerPerm * NumSliceOrders + NextSliceOrder) >= ToGo ||
+		    GetDistance(Tables.m_pUDEdgeSlicePrun, NextUDEdgePerm * NumSliceOrders + NextSliceOrder) >= ToGo)
+			continue;
+
+		Search.m_Moves[Depth] = Move;
+		if (SearchPhase2(Search, NextCornerPerm, NextUDEdgePerm, NextSliceOrder, Depth + 1, ToGo - 1))
+			return true;
+	}
+	return false;
+}
+
+// Solve phase 2 after the current phase 1, with a solution shorter than the
+// best one so far.
+void StartPhase2(SSearch& Search)
+{
+	uint8_t Phase1Moves = Search.m_Phase1Moves;
+	if (Phase1Moves + 1 >= Search.m_NumBestMoves)
+		return;
+	uint8_t MaxMoves = Search.m_NumBestMoves - 1 - Phase1Moves;
+	if (MaxMoves > MaxPhase2Moves)
+		MaxMoves = MaxPhase2Moves;
+
+	// The phase 2 coordinates are not tracked by phase 1: apply its moves.
+	SCubies State = Search.m_State, Moved;
+	for (uint8_t i = 0; i < Phase1Moves; ++i)
+	{
+		Cubies::Multiply(State, GetMove(Search.m_Moves[i]), Moved);
+		State = Moved;
+	}
+	uint16_t CornerPerm = GetCornerPerm(State);
+	uint16_t UDEdgePerm = GetUDEdgePerm(State);
+	uint8_t SliceOrder  = uint8_t(GetSliceSorted(State));
+	assert(SliceOrder < NumSliceOrders);
+
+	const STables& Tables = *Search.m_pTables;
+	uint8_t MinMoves = GetDistance(Tables.m_pCornerSlicePrun, CornerPerm * NumSliceOrders + SliceOrder);
+	uint8_t UDEdgeMoves = GetDistance(Tables.m_pUDEdgeSlicePrun, UDEdgePerm * NumSliceOrders + SliceOrder);
+	if (UDEdgeMoves > MinMoves)
+		MinMoves = UDEdgeMoves;
+
+	for (uint8_t ToGo = MinMoves; ToGo <= MaxMoves && !Search.m_IsStopped; ++ToGo)
+	{
+		if (SearchPhase2(Search, CornerPerm, UDEdgePerm, SliceOrder, Phase1Moves, ToGo))
+		{
+			Search.m_NumBestMoves = Phase1Moves + ToGo;
+			memcpy(Search.m_BestMoves, Search.m_Moves, Search.m_NumBestMoves);
+			if (Search.m_NumBestMoves <= Search.m_MaxMoves)
+				Search.m_IsStopped = true;
+			return;
+		}
+	}
+}
+
+// Phase 1 search from the given coordinates, with exactly ToGo moves left.
+void SearchPhase1(SSearch& Search, uint16_t Twist, uint16_t Flip, uint16_t Slice, uint8_t Depth, uint8_t ToGo)
+{
+	if (ToGo == 0)
+	{
+		// A phase 1 ending with a phase 2 move was already found shorter.
+		if (Depth == 0 || !(Search.m_Moves[Depth - 1] % 3 == HalfTurn || Search.m_Moves[Depth - 1] / 3 == Rotation::Top ||
+		                    Search.m_Moves[Depth - 1] / 3 == Rotation::Bottom))
+			StartPhase2(Search);
+		return;
+	}
+
+	if (IsStopped(Search))
+		return;
+
+	const STables& Tables = *Search.m_pTables;
+	for (uint8_t Move = 0; Move < NumMoves && !Search.m_IsStopped; ++Move)
+	{
+		if (Depth > 0 && !IsAllowedAfter(Move, Search.m_Moves[Depth - 1]))
+			continue;
+
+		uint16_t NextTwist = Tables.m_pTwistMoves[Twist * NumMoves + Move];
+		uint16_t NextFlip  = Tables.m_pFlipMoves[Flip * NumMoves + Move];
+		uint16_t NextSlice = Tables.m_pSliceSortedMoves[Slice * NumSliceOrders * NumMoves + Move] / NumSliceOrders;
+		if (GetDistance(Tables.m_pTwistSlicePrun, NextTwist * NumSlices + NextSlice) >= ToGo ||
+		    GetDistance(Tables.m_pFlipSlicePrun, NextFlip * NumSlices + NextSlice) >= ToGo)
+			continue;
+
+		Search.m_Moves[Depth] = Move;
+		SearchPhase1(Search, NextTwist, NextFlip, NextSlice, Depth + 1, ToGo - 1);
+	}
+}
+
+}
+
+namespace TwoPhase
+{
+
+// Map the tables from the given cache file, building it if it is missing or
+// invalid.
+bool LoadTables(STables& Tables, const char* pPath, bool* pHasBuilt)
+{
+	memset(&Tables, 0, sizeof(Tables));
+	size_t Size = GetFileLayout().m_Size;
+	if (pHasBuilt != NULL)
+		*pHasBuilt = false;
+
+	const uint8_t* pFileData = MapFile(pPath);
+	if (pFileData != NULL)
+	{
+		SetPointers(Tables, pFileData, Size);
+		return true;
+	}
+
+	// Build the tables in anonymous memory, which is used as is if the file
+	// cannot be written.
+	void* pData = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pData == MAP_FAILED)
+		return false;
+	BuildTables(static_cast<uint8_t*>(pData));
+	if (pHasBuilt != NULL)
+		*pHasBuilt = true;
+
+	pFileData = (WriteFile(pPath, static_cast<uint8_t*>(pData), Size) ? MapFile(pPath) : NULL);
+	if (pFileData != NULL)
+	{
+		munmap(pData, Size);
+		SetPointers(Tables, pFileData, Size);
+	}
+	else
+	{
+		mprotect(pData, Size, PROT_READ);
+		SetPointers(Tables, static_cast<uint8_t*>(pData), Size);
+	}
+	return true;
+}
+
+void FreeTables(STables& Tables)
+{
+	if (Tables.m_pData != NULL)
+		munmap(const_cast<uint8_t*>(Tables.m_pData), Tables.m_Size);
+	memset(&Tables, 0, sizeof(Tables));
+}
+
+// Search for a solution of at most MaxMoves face turns, or the shortest one
+// found within TimeoutMs milliseconds (or when the first one is found).
+bool Solve(const STables& Tables, const Cubies::SCubies& State, uint8_t MaxMoves, uint32_t TimeoutMs, SSolution& Solution)
+{
+	Solution.m_NumRots  = 0;
+	Solution.m_NumMoves = 0;
+	if (!Cubies::IsValid(State))
+		return false;
+
+	SSearch Search;
+	Search.m_pTables      = &Tables;
+	Search.m_State        = State;
+	Search.m_MaxMoves     = MaxMoves;
+	Search.m_NumBestMoves = MaxSolutionMoves + 1;
+	Search.m_HasDeadline  = (TimeoutMs != 0);
+	Search.m_Deadline     = std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutMs);
+	Search.m_NumNodes     = 0;
+	Search.m_IsStopped    = false;
+
+	uint16_t Twist = Cubies::GetTwist(State);
+	uint16_t Flip  = Cubies::GetFlip(State);
+	uint16_t Slice = GetSliceSorted(State) / NumSliceOrders;
+	uint8_t MinMoves = GetDistance(Tables.m_pTwistSlicePrun, Twist * NumSlices + Slice);
+	uint8_t FlipMoves = GetDistance(Tables.m_pFlipSlicePrun, Flip * NumSlices + Slice);
+	if (FlipMoves > MinMoves)
+		MinMoves = FlipMoves;
+
+	// Longer phases 1 give shorter phases 2: keep searching until the
+	// solution is short enough.
+	for (uint8_t Phase1Moves = MinMoves; Phase1Moves < Search.m_NumBestMoves && !Search.m_IsStopped; ++Phase1Moves)
+	{
+		Search.m_Phase1Moves = Phase1Moves;
+		SearchPhase1(Search, Twist, Flip, Slice, 0, Phase1Moves);
+	}
+	if (Search.m_NumBestMoves > MaxSolutionMoves)
+		return false;
+
+	// Face turns --> rotations.
+	Solution.m_NumMoves = Search.m_NumBestMoves;
+	for (uint8_t i = 0; i < Search.m_NumBestMoves; ++i)
+	{
+		Rotation::Type Face = Search.m_BestMoves[i] / 3;
+		uint8_t Turn = Search.m_BestMoves[i] % 3;
+		Solution.m_Rots[Solution.m_NumRots++] = (Turn == CCWTurn ? Face + Rotation::CCW : Face);
+		if (Turn == HalfTurn)
+			Solution.m_Rots[Solution.m_NumRots++] = Face;
+	}
+	return true;
+}
+
+bool Solve(const STables& Tables, Layout::Type L, const Facelet::Type* pFacelets, uint8_t MaxMoves, uint32_t TimeoutMs, SSolution& Solution)
+{
+	Cubies::SCubies State;
+	if (!Cubies::FromFacelets(L, pFacelets, State))
+	{
+		Solution.m_NumRots  = 0;
+		Solution.m_NumMoves = 0;
+		return false;
+	}
+	return Solve(Tables, State, MaxMoves, TimeoutMs, Solution);
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+#include "cubies.h"
+
+// Host-only: two-phase solver (H. Kociemba's algorithm). Phase 1 brings the
+// cube into the subgroup <U, D, R2, F2, L2, B2>, phase 2 solves it using only
+// these moves. Both phases are IDA* searches over coordinates of the cubie
+// state, using move and pruning tables (about 5 MB) that are built once,
+// cached in a file and memory-mapped afterwards.
+//
+// The search uses the 18 face turns (a half turn counts as one move);
+// solutions are returned as rotations, a half turn giving two rotations.
+namespace TwoPhase
+{
+const uint8_t MaxSolutionMoves     = 31;	// Maximum length of a solution, in face turns.
+const uint8_t MaxSolutionRotations = 2 * MaxSolutionMoves;
+
+// Tables used by the solver, see twophase.cpp. m_pData maps the whole cache
+// file (or memory, if the file could not be written).
+struct STables
+{
+	const uint8_t*  m_pData;
+	size_t          m_Size;
+
+	// Move tables: [coordinate][move] --> coordinate.
+	const uint16_t* m_pTwistMoves;		// Corner orientations, 3^7.
+	const uint16_t* m_pFlipMoves;		// Edge orientations, 2^11.
+	const uint16_t* m_pSliceSortedMoves;	// Positions and order of the 4 middle-slice edges, 12*11*10*9.
+	const uint16_t* m_pCornerMoves;		// Corner permutation, 8!.
+	const uint16_t* m_pUDEdgeMoves;		// Permutation of the 8 other edges in phase 2, 8!, phase 2 moves only.
+
+	// Pruning tables: lower bounds of the distance to the goal of each phase,
+	// 4 bits per entry.
+	const uint8_t*  m_pTwistSlicePrun;	// Phase 1: twist * slice positions.
+	const uint8_t*  m_pFlipSlicePrun;	// Phase 1: flip * slice positions.
+	const uint8_t*  m_pCornerSlicePrun;	// Phase 2: corner permutation * slice order.
+	const uint8_t*  m_pUDEdgeSlicePrun;	// Phase 2: other edges permutation * slice order.
+};
+
+struct SSolution
+{
+	Rotation::Type m_Rots[MaxSolutionRotations];
+	uint8_t        m_NumRots;
+	uint8_t        m_NumMoves;		// Number of face turns.
+};
+
+// Map the tables from the given cache file. If the file is missing or
+// invalid, the tables are built (a few seconds) and the file is written.
+// pHasBuilt, if not NULL, tells whether the tables were built. Returns false
+// if the tables cannot be allocated.
+bool LoadTables(STables& Tables, const char* pPath, bool* pHasBuilt);
+void FreeTables(STables& Tables);
+
+// Search for a solution of at most MaxMoves face turns. If none is found
+// within TimeoutMs milliseconds (0: no limit), the shortest solution found so
+// far is returned, the search going on until a first solution is found.
+// Returns false if the state is invalid.
+bool Solve(const STables& Tables, const Cubies::SCubies& State, uint8_t MaxMoves, uint32_t TimeoutMs, SSolution& Solution);
+bool Solve(const STables& Tables, Layout::Type L, const Facelet::Type* pFacelets, uint8_t MaxMoves, uint32_t TimeoutMs, SSolution& Solution);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Host-only: runs independent tasks on a pool of threads. Tasks are dealt to
+// one queue per thread; each thread takes tasks from the back of its own
+// queue and, once it is empty, steals from the front of the other queues, so
+// that threads that drew cheap tasks help those that drew expensive ones.
+namespace WorkStealing
+{
+// Number of hardware threads, at least 1.
+inline unsigned GetDefaultNumThreads()
+{
+	unsigned NumThreads = std::thread::hardware_concurrency();
+	return (NumThreads > 0 ? NumThreads : 1);
+}
+
+// Call Func(TaskIdx, ThreadIdx) for each TaskIdx in [0, NumTasks[, on
+// NumThreads threads (the calling thread is thread 0). Returns when all tasks
+// are done. A task can make the others return early by itself checking a
+// shared flag.
+template<typename TaskFunc>
+void Run(unsigned NumThreads, size_t NumTasks, TaskFunc Func)
+{
+	struct SQueue
+	{
+		std::mutex         m_Mutex;
+		std::deque<size_t> m_Tasks;
+	};
+	std::vector<SQueue> Queues(NumThreads);
+	for (size_t TaskIdx = 0; TaskIdx < NumTasks; ++TaskIdx)
+		Queues[TaskIdx % NumThreads].m_Tasks.push_front(TaskIdx);
+
+	auto Work = [&](unsigned ThreadIdx)
+	{
+		for (;;)
+		{
+			size_t TaskIdx = 0;
+			bool IsFound = false;
+			for (unsigned i = 0; i < NumThreads && !IsFound; ++i)
+			{
+				SQueue& Queue = Queues[(ThreadIdx + i) % NumThreads];
+				std::lock_guard<std::mutex> Lock(Queue.m_Mutex);
+				if (Queue.m_Tasks.empty())
+					continue;
+				if (i == 0)
+				{
+					TaskIdx = Queue.m_Tasks.back();
+					Queue.m_Tasks.pop_back();
+				}
+				else
+				{
+					TaskIdx = Queue.m_Tasks.front();
+					Queue.m_Tasks.pop_front();
+				}
+				IsFound = true;
+			}
+			if (!IsFound)
+				return;	// No task is added once started: all are taken.
+			Func(TaskIdx, ThreadIdx);
+		}
+	};
+
+	std::vector<std::thread> Threads;
+	for (unsigned ThreadIdx = 1; ThreadIdx < NumThreads; ++ThreadIdx)
+		Threads.emplace_back(Work, ThreadIdx);
+	Work(0);
+	for (std::thread& Thread : Threads)
+		Thread.join();
+}
+}
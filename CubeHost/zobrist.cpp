@@ -0,0 +1,97 @@
+#include "zobrist.h"
+#include "permutation.h"
+#include "../Cube/config.h"
+
+// Unnamed namespace for internal details.
+namespace
+{
+using Zobrist::Hash;
+using Zobrist::NumMovingFacelets;
+
+const Facelet::Type NumColors = Facelet::Bright;	// Colors without the brightness, including Black and Unused.
+const uint64_t Seed = 0x5A0B215743C0FFEEull;
+
+// Deltas of one rotation: the color of facelet m_Src[i] before the rotation
+// selects the delta of the i-th moving facelet.
+struct SMove
+{
+	uint8_t m_Src[NumMovingFacelets];
+	Hash    m_Deltas[NumMovingFacelets][NumColors];
+};
+
+struct STables
+{
+	Hash  m_Keys[Cube::NumFacelets][NumColors];
+	SMove m_Moves[Layout::NumLayouts][Rotation::NumRotations];
+	STables();
+};
+
+// SplitMix64, whose output does not depend on the standard library.
+Hash GetNextKey(uint64_t& State)
+{
+	uint64_t Z = (State += 0x9E3779B97F4A7C15ull);
+	Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+	return Z ^ (Z >> 31);
+}
+
+STables::STables()
+{
+	uint64_t State = Seed;
+	for (uint8_t Idx = 0; Idx < Cube::NumFacelets; ++Idx)
+		for (Facelet::Type Color = 0; Color < NumColors; ++Color)
+			m_Keys[Idx][Color] = GetNextKey(State);
+
+	for (Layout::Type L = 0; L < Layout::NumLayouts; ++L)
+		for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+		{
+			const Permutation::STable& Table = Permutation::GetTable(L, Rot);
+			SMove& Move = m_Moves[L][Rot];
+			uint8_t NumMoving = 0;
+			for (uint8_t Dst = 0; Dst < Cube::NumFacelets; ++Dst)
+			{
+				uint8_t Src = Table.m_Src[Dst];
+				if (Src == Dst)
+					continue;
+				assert(NumMoving < NumMovingFacelets);
+				Move.m_Src[NumMoving] = Src;
+				for (Facelet::Type Color = 0; Color < NumColors; ++Color)
+					Move.m_Deltas[NumMoving][Color] = m_Keys[Src][Color] ^ m_Keys[Dst][Color];
+				++NumMoving;
+			}
+			assert(NumMoving == NumMovingFacelets);
+		}
+}
+
+const STables& GetTables()
+{
+	static const STables s_Tables;
+	return s_Tables;
+}
+
+}
+
+namespace Zobrist
+{
+
+// Hash of the 54 facelets of a cube.
+Hash GetHash(const Facelet::Type* pFacelets)
+{
+	const STables& Tables = GetTables();
+	Hash H = 0;
+	for (uint8_t Idx = 0; Idx < Cube::NumFacelets; ++Idx)
+		H ^= Tables.m_Keys[Idx][pFacelets[Idx] % NumColors];
+	return H;
+}
+
+// Hash of a cube after one rotation.
+Hash Update(Hash H, Layout::Type L, const Facelet::Type* pFacelets, Rotation::Type Rot)
+{
+	assert(L < Layout::NumLayouts && Rot < Rotation::NumRotations);
+	const SMove& Move = GetTables().m_Moves[L][Rot];
+	for (uint8_t Idx = 0; Idx < NumMovingFacelets; ++Idx)
+		H ^= Move.m_Deltas[Idx][pFacelets[Move.m_Src[Idx]] % NumColors];
+	return H;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include "../Cube/cube.h"
+#include "../Cube/layout.h"
+
+// Host-only: Zobrist hash of the facelets of a cube, for sets of states.
+//
+// The hash is the XOR of one random key per facelet and color. A rotation
+// only moves 20 facelets (see Permutation::SRotationIndices): the hash after
+// it is found from the hash before it by XOR-ing one precomputed delta per
+// moving facelet, which removes the key of its color at its old position and
+// adds the key of the same color at its new position. The keys come from a
+// fixed seed, so hashes are the same from one run to the next.
+namespace Zobrist
+{
+typedef uint64_t Hash;
+
+const uint8_t NumMovingFacelets = Cube::NumSideFacelets + Cube::NumFrontFacelets;
+
+// Hash of the 54 facelets of a cube, in LED order. The brightness of the
+// facelets is ignored.
+Hash GetHash(const Facelet::Type* pFacelets);
+
+// Hash of a cube after one rotation, given its hash and its facelets before
+// the rotation. The deltas are built on first use.
+Hash Update(Hash H, Layout::Type L, const Facelet::Type* pFacelets, Rotation::Type Rot);
+}
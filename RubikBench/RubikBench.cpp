@@ -0,0 +1,265 @@
+// Microbenchmarks of the hot paths of the cube logic shared with the firmware,
+// compiled for the host. There is one executable per rotation animation
+// (ROTATION_ANIMATION_VERSION, see Cube/cube.cpp).
+//
+// Each benchmark is timed in samples of OpsPerSample operations; the table
+// gives percentiles of the ns/op of the samples.
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../Cube/controls.h"
+#include "../Cube/rand8.h"
+
+#ifndef ROTATION_ANIMATION_VERSION
+	#define ROTATION_ANIMATION_VERSION 0	// Unknown
+#endif
+
+const int NumSamples   = 2000;
+const int OpsPerSample = 256;
+
+// Results are accumulated here so that the benchmarked code is not optimized away.
+volatile uint32_t g_Sink;
+
+// Random generator for the setup of the benchmarks, not to disturb Rand8.
+std::mt19937 g_Random(12345);
+
+// Time Op(), after calling Setup() before each sample, and print the results.
+template<typename SetupFunc, typename OpFunc>
+void Run(const char* pName, SetupFunc Setup, OpFunc Op)
+{
+	std::vector<double> Samples;
+	Samples.reserve(NumSamples);
+	uint32_t Sink = 0;
+
+	// The first samples warm up the caches and branch predictors.
+	const int NumWarmUpSamples = NumSamples / 10;
+	for (int SampleIdx = 0; SampleIdx < NumWarmUpSamples + NumSamples; ++SampleIdx)
+	{
+		Setup();
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int OpIdx = 0; OpIdx < OpsPerSample; ++OpIdx)
+			Sink += Op();
+		std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+		if (SampleIdx >= NumWarmUpSamples)
+			Samples.push_back(std::chrono::duration<double, std::nano>(End - Start).count() / OpsPerSample);
+	}
+	g_Sink = Sink;
+
+	std::sort(Samples.begin(), Samples.end());
+	printf("%-36s %9.1f %9.1f %9.1f %9.1f\n", pName,
+	       Samples.front(), Samples[Samples.size() / 2], Samples[Samples.size() * 9 / 10], Samples[Samples.size() * 99 / 100]);
+}
+
+void NoSetup()
+{
+}
+
+// Put the sensor counters in a random state, with a few sensors ON for long
+// enough to brighten facelets and sometimes trigger actions.
+void RandomizeSensors()
+{
+	const int MaxReads = 40;
+	int NumReads[Controls::NumSensors];
+	for (uint8_t SensorIdx = 0; SensorIdx < Controls::NumSensors; ++SensorIdx)
+		NumReads[SensorIdx] = (g_Random() % 4 == 0 ? int(g_Random() % MaxReads) : 0);
+
+	// Each sensor is ON for its last NumReads reads.
+	Controls::ResetSensors();
+	for (int ReadIdx = MaxReads; ReadIdx > 0; --ReadIdx)
+	{
+		uint8_t SensorsOn[Controls::NumSensorBytes] = {};
+		for (uint8_t SensorIdx = 0; SensorIdx < Controls::NumSensors; ++SensorIdx)
+			if (NumReads[SensorIdx] >= ReadIdx)
+				SensorsOn[SensorIdx >> 3] |= 1 << (SensorIdx & 7);
+		Controls::UpdateSensors(SensorsOn);
+	}
+}
+
+// A finger on a sensor of the simulator layout, from read First to read
+// Last included, as seen after the debouncing of Rings (which keeps a sensor
+// ON for 3 more reads after the finger leaves it).
+struct STouch
+{
+	uint8_t m_SensorIdx;
+	int     m_First;
+	int     m_Last;
+};
+
+// Feed the touches to Controls, one read at a time, until an action is
+// detected, and print it with its latency as reported by Controls.
+void PrintGestureLatency(const char* pName, const STouch* pTouches, int NumTouches)
+{
+	const int MaxReads = 100;
+	const int ReadMs   = 25;
+	Controls::ResetSensors();
+	for (int ReadIdx = 0; ReadIdx < MaxReads; ++ReadIdx)
+	{
+		uint8_t SensorsOn[Controls::NumSensorBytes] = {};
+		for (int i = 0; i < NumTouches; ++i)
+			if (ReadIdx >= pTouches[i].m_First && ReadIdx <= pTouches[i].m_Last + 3)
+				SensorsOn[pTouches[i].m_SensorIdx >> 3] |= 1 << (pTouches[i].m_SensorIdx & 7);
+		Controls::UpdateSensors(SensorsOn);
+		Action::Type CurAction = Controls::DetermineAction();
+		if (CurAction != Action::None)
+		{
+			printf("%-36s %9u %9u %9u\n", pName, unsigned(CurAction),
+			       unsigned(Controls::GetActionLatency()), unsigned(Controls::GetActionLatency()) * ReadMs);
+			return;
+		}
+	}
+	printf("%-36s %9s\n", pName, "none");
+}
+
+// Scramble the default cube with the given number of random rotations.
+void Scramble(int NumRotations)
+{
+	Cube::Reset();
+	for (int i = 0; i < NumRotations; ++i)
+		Cube::Apply(g_Random() % Rotation::NumRotations);
+}
+
+// Rotations used by the benchmarks, in a fixed order to keep runs comparable.
+Rotation::Type NextRotation()
+{
+	static Rotation::Type s_Rot = 0;
+	s_Rot = (s_Rot + 5) % Rotation::NumRotations;
+	return s_Rot;
+}
+
+// Slice moves and whole-cube rotations, in a fixed order as well.
+Rotation::Type NextOtherMove()
+{
+	static Rotation::Type s_Move = 0;
+	s_Move = (s_Move + 5) % (Rotation::NumMoves - Rotation::NumRotations);
+	return Rotation::NumRotations + s_Move;
+}
+
+int main()
+{
+	printf("RubikBench: ROTATION_ANIMATION_VERSION %d, %d samples x %d ops\n\n",
+	       ROTATION_ANIMATION_VERSION, NumSamples, OpsPerSample);
+	printf("%-36s %9s %9s %9s %9s\n", "ns/op", "min", "p50", "p90", "p99");
+
+	// Animations. A new animation starts when the previous one ends.
+	Cube::Reset();
+	bool IsAnimating = false;
+	Run("Animation::Next (rotation frame)", NoSetup, [&]()
+	{
+		if (!IsAnimating)
+			Cube::Animation::Rotate(NextRotation());
+		uint16_t Delay = Cube::Animation::Next();
+		IsAnimating = (Delay != 0);
+		return Delay;
+	});
+	while (Cube::Animation::Next() != 0) {}
+
+	Run("Animation::Next (whole rotation)", NoSetup, []()
+	{
+		Cube::Animation::Rotate(NextRotation());
+		uint32_t NumFrames = 1;
+		while (Cube::Animation::Next() != 0)
+			++NumFrames;
+		return NumFrames;
+	});
+
+	Run("Animation::Next (whole other move)", NoSetup, []()
+	{
+		Cube::Animation::Rotate(NextOtherMove());
+		uint32_t NumFrames = 1;
+		while (Cube::Animation::Next() != 0)
+			++NumFrames;
+		return NumFrames;
+	});
+
+	IsAnimating = false;
+	Run("Animation::Next (victory frame)", NoSetup, [&]()
+	{
+		if (!IsAnimating)
+			Cube::Animation::Victory();
+		uint16_t Delay = Cube::Animation::Next();
+		IsAnimating = (Delay != 0);
+		return Delay;
+	});
+	while (Cube::Animation::Next() != 0) {}
+
+	// Controls, for random sensor states.
+	Scramble(20);
+	Run("Controls::UpdateCubeBrightness", RandomizeSensors, []()
+	{
+		return uint32_t(Controls::UpdateCubeBrightness());
+	});
+	Run("Controls::DetermineAction", RandomizeSensors, []()
+	{
+		return uint32_t(Controls::DetermineAction());
+	});
+	Run("Controls::UpdateSensors", RandomizeSensors, []()
+	{
+		static const uint8_t s_SensorsOn[Controls::NumSensorBytes] = {0x11, 0x00, 0x10};
+		Controls::UpdateSensors(s_SensorsOn);
+		return 0u;
+	});
+
+	// Solved state detection.
+	Run("Cube::IsSolved", []() { Scramble(20); }, []()
+	{
+		return uint32_t(Cube::IsSolved());
+	});
+	Run("Cube::Apply", NoSetup, []()
+	{
+		Cube::Apply(NextRotation());
+		return 0u;
+	});
+	Run("Cube::Apply (slices, whole cube)", NoSetup, []()
+	{
+		Cube::Apply(NextOtherMove());
+		return 0u;
+	});
+	Run("Cube::Apply + Cube::IsSolved", NoSetup, []()
+	{
+		Cube::Apply(NextRotation());
+		return uint32_t(Cube::IsSolved());
+	});
+
+	// Random numbers, for the ranges used by Scramble() and the victory animation.
+	Run("Rand8::Get(0, 11)", NoSetup, []()
+	{
+		return uint32_t(Rand8::Get(0, Rotation::NumRotations - 1));
+	});
+	Run("Rand8::Get(0, 53)", NoSetup, []()
+	{
+		return uint32_t(Rand8::Get(0, Cube::NumFacelets - 1));
+	});
+
+	// Gestures turning the top face, on the simulator layout: sensors 4 and
+	// 5 are the corners of the top row of the front face, 12 faces 4.
+	printf("\n%-36s %9s %9s %9s\n", "gesture", "action", "reads", "ms");
+	const STouch Hold[]     = {{4, 0, 50}, {12, 0, 50}};
+	const STouch SwipeCW[]  = {{5, 0, 2}, {4, 2, 10}};
+	const STouch SwipeCCW[] = {{4, 0, 2}, {5, 2, 10}};
+	const STouch Reset[]    = {{16, 0, 50}, {17, 2, 50}, {18, 4, 50}, {19, 6, 50}};
+	PrintGestureLatency("Hold (top)", Hold, 2);
+	PrintGestureLatency("Swipe (top)", SwipeCW, 2);
+	PrintGestureLatency("Swipe (top CCW)", SwipeCCW, 2);
+	PrintGestureLatency("Hold, one finger at a time (reset)", Reset, 4);
+
+	// Duration of a rotation animation on the firmware, which is shortened
+	// when actions are pending.
+	printf("\n%-36s %9s\n", "pending actions", "ms");
+	for (int NumPending = 0; NumPending <= Controls::MaxAnimationSpeedUp + 1; ++NumPending)
+	{
+		Controls::ResetPendingActions();
+		for (int i = 0; i < NumPending; ++i)
+			Controls::PushPendingAction(Rotation::Top);
+		Cube::Animation::Rotate(Rotation::Front);
+		unsigned DurationMs = 0;
+		for (uint16_t DelayMs = Cube::Animation::Next(); DelayMs != 0; DelayMs = Cube::Animation::Next())
+			DurationMs += DelayMs >> Controls::GetAnimationSpeedUp();
+		printf("%-36d %9u\n", NumPending, DurationMs);
+	}
+	Controls::ResetPendingActions();
+	return 0;
+}
@@ -0,0 +1,214 @@
+// Command-line tool computing the exact distance to the solved cube, in
+// rotations (quarter turns), of a batch of states, by meet-in-the-middle
+// search (see CubeHost/census.h). E.g. to see how far the scrambles really
+// are:
+//   RubikScramble -c 1000 -r 15 | RubikCensus
+//
+// Each input line is either a state, its last word being 54 face letters as
+// printed by RubikReplay, or a sequence of rotations in standard notation
+// applied to a solved cube. For each line, the distance is printed, or
+// ">N" if it exceeds the ball depth plus the search depth, or "invalid".
+// The histogram of the distances and the throughput are printed to the
+// standard error.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../CubeHost/census.h"
+#include "../CubeHost/notation.h"
+#include "../CubeHost/workstealing.h"
+
+// Maximum length of an input line. Each character gives at most 2 rotations.
+const size_t MaxLineLength = 1024;
+
+// State of an input line, or invalid.
+struct SQuery
+{
+	Cubies::SCubies m_State;
+	bool            m_IsValid;
+	uint8_t         m_Distance;
+};
+
+// Read the state of a line: 54 face letters, or a sequence of rotations.
+// Returns false if it is invalid.
+bool ParseLine(Layout::Type L, const char* pLine, Cubies::SCubies& State)
+{
+	size_t Len = strlen(pLine);
+	while (Len > 0 && isspace(uint8_t(pLine[Len - 1])))
+		--Len;
+	size_t Begin = Len;
+	while (Begin > 0 && !isspace(uint8_t(pLine[Begin - 1])))
+		--Begin;
+
+	if (Len - Begin == Cube::NumFacelets)
+	{
+		Facelet::Type Facelets[Cube::NumFacelets];
+		return Notation::ParseFacelets(L, pLine + Begin, Facelets) && Cubies::FromFacelets(L, Facelets, State);
+	}
+
+	Rotation::Type Rots[2 * MaxLineLength];
+	Notation::SParser Parser;
+	Notation::Reset(Parser);
+	size_t NumRots = Notation::Parse(Parser, pLine, Len, Rots);
+	if (NumRots == Notation::ParseError)
+		return false;
+	NumRots += Notation::Finish(Parser, Rots + NumRots);
+	Cubies::Reset(State);
+	Cubies::Apply(State, Rots, NumRots);
+	return true;
+}
+
+// Read the states of a text stream, skipping blank lines.
+void ReadFile(Layout::Type L, FILE* pFile, std::vector<SQuery>& Queries)
+{
+	char Line[MaxLineLength];
+	while (fgets(Line, sizeof(Line), pFile) != NULL)
+	{
+		const char* pChar = Line;
+		while (isspace(uint8_t(*pChar)))
+			++pChar;
+		if (*pChar == 0)
+			continue;
+
+		SQuery Query;
+		Query.m_IsValid  = ParseLine(L, Line, Query.m_State);
+		Query.m_Distance = Census::UnknownDistance;
+		Queries.push_back(Query);
+	}
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikCensus [-l sim|hw] [-b depth] [-s depth] [-j threads] [file...]\n"
+		"  -l  LED layout of the states (default: sim)\n"
+		"  -b  depth of the ball of states around the solved cube, at most %u (default: 7, 9.2 M states)\n"
+		"  -s  depth searched from each state, at most %u (default: 7)\n"
+		"  -j  number of threads (default: %u)\n"
+		"Reads the standard input if no file is given.\n",
+		unsigned(Census::MaxBallDepth), unsigned(Census::MaxSearchDepth), WorkStealing::GetDefaultNumThreads());
+}
+
+int main(int argc, char** argv)
+{
+	Layout::Type L = Layout::Simulator;
+	int BallDepth   = 7;
+	int SearchDepth = 7;
+	int NumThreads  = int(WorkStealing::GetDefaultNumThreads());
+
+	int ArgIdx = 1;
+	for (; ArgIdx < argc && argv[ArgIdx][0] == '-' && argv[ArgIdx][1] != 0; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "sim") == 0)
+			L = Layout::Simulator, ++ArgIdx;
+		else if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "hw") == 0)
+			L = Layout::Hardware, ++ArgIdx;
+		else if (strcmp(pArg, "-b") == 0 && ArgIdx + 1 < argc)
+			BallDepth = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-s") == 0 && ArgIdx + 1 < argc)
+			SearchDepth = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-j") == 0 && ArgIdx + 1 < argc)
+			NumThreads = atoi(argv[++ArgIdx]);
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	if (BallDepth < 0 || BallDepth > Census::MaxBallDepth || SearchDepth < 0 || SearchDepth > Census::MaxSearchDepth || NumThreads < 1)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	// Read all the states first: they are searched in parallel.
+	std::vector<SQuery> Queries;
+	if (ArgIdx == argc)
+		ReadFile(L, stdin, Queries);
+	for (; ArgIdx < argc; ++ArgIdx)
+	{
+		FILE* pFile = fopen(argv[ArgIdx], "r");
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "%s: cannot open file\n", argv[ArgIdx]);
+			return 1;
+		}
+		ReadFile(L, pFile, Queries);
+		fclose(pFile);
+	}
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	Census::SBall Ball;
+	Census::Build(Ball, uint8_t(BallDepth), unsigned(NumThreads));
+	double BuildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	uint64_t BallSize = 0;
+	for (int Distance = 0; Distance <= BallDepth; ++Distance)
+		BallSize += Ball.m_NumStates[Distance];
+	fprintf(stderr, "ball of depth %d: %llu states, %.1f MB, built in %.3f s (%.1f M states/s) with %d threads\n",
+		BallDepth, (unsigned long long)BallSize, Census::GetMemorySize(Ball) * 1e-6, BuildSeconds,
+		BuildSeconds > 0.0 ? BallSize / BuildSeconds * 1e-6 : 0.0, NumThreads);
+
+	std::atomic<uint64_t> NumNodes(0);
+	Start = std::chrono::steady_clock::now();
+	WorkStealing::Run(unsigned(NumThreads), Queries.size(), [&](size_t QueryIdx, unsigned)
+	{
+		SQuery& Query = Queries[QueryIdx];
+		if (!Query.m_IsValid)
+			return;
+		Census::SSearchStats Stats;
+		Stats.m_NumNodes = 0;
+		Query.m_Distance = Census::GetDistance(Ball, Query.m_State, uint8_t(SearchDepth), Stats);
+		NumNodes += Stats.m_NumNodes;
+	});
+	double SearchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	int MaxDistance = BallDepth + SearchDepth;
+	std::vector<unsigned long long> Counts(MaxDistance + 2, 0);	// The last one counts the states beyond.
+	unsigned long long NumInvalid = 0;
+	for (const SQuery& Query : Queries)
+	{
+		if (!Query.m_IsValid)
+		{
+			printf("invalid\n");
+			++NumInvalid;
+		}
+		else if (Query.m_Distance == Census::UnknownDistance)
+		{
+			printf(">%d\n", MaxDistance);
+			++Counts[MaxDistance + 1];
+		}
+		else
+		{
+			printf("%u\n", unsigned(Query.m_Distance));
+			++Counts[Query.m_Distance];
+		}
+	}
+
+	unsigned long long NumValid = Queries.size() - NumInvalid;
+	fprintf(stderr, "%llu states, %llu invalid, searched in %.3f s (%.1f states/s, %.1f M nodes/s)\n",
+		NumValid, NumInvalid, SearchSeconds, SearchSeconds > 0.0 ? NumValid / SearchSeconds : 0.0,
+		SearchSeconds > 0.0 ? NumNodes / SearchSeconds * 1e-6 : 0.0);
+	unsigned long long TotalDistance = 0, NumKnown = 0;
+	for (int Distance = 0; Distance <= MaxDistance + 1; ++Distance)
+	{
+		if (Counts[Distance] == 0)
+			continue;
+		if (Distance <= MaxDistance)
+		{
+			TotalDistance += Distance * Counts[Distance];
+			NumKnown += Counts[Distance];
+			fprintf(stderr, "  %3d: %llu (%.1f%%)\n", Distance, Counts[Distance], Counts[Distance] * 100.0 / NumValid);
+		}
+		else
+			fprintf(stderr, "  >%2d: %llu (%.1f%%)\n", MaxDistance, Counts[Distance], Counts[Distance] * 100.0 / NumValid);
+	}
+	if (NumKnown > 0)
+		fprintf(stderr, "  average of the known distances: %.2f\n", double(TotalDistance) / NumKnown);
+	return 0;
+}
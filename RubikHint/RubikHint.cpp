@@ -0,0 +1,435 @@
+// Command-line tool building the tables of the hint engine of the firmware
+// (see Cube/hint.h), and checking the engine compiled in.
+//
+// With -o, the plan of every case of every table is found by a bidirectional
+// breadth-first search on the facelets, in which the pieces that may move
+// are black: from the case, and backwards from the piece placed, until both
+// searches meet. The plans are the shortest ones in rotations, and are
+// written as the C++ header Cube/hinttables.h.
+//
+// Then, the hints are followed from random states until the cube is solved,
+// as the firmware would, and statistics are printed to the standard error:
+// the number of rotations, and the number of ring scans before each hint.
+// After writing new tables, rebuild and run again to check them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../Cube/hint.h"
+#include "../CubeHost/cubies.h"
+#include "../CubeHost/permutation.h"
+#include "../CubeHost/transposition.h"
+#include "../CubeHost/zobrist.h"
+
+// A rotation fits in a nibble; this value ends each plan.
+const uint8_t PlanEnd = 0x0F;
+
+// Longest plan searched, in rotations, and slots of the table of the states
+// visited by each side of a search (512 MB each).
+const uint8_t  MaxPlanLength = 16;
+const unsigned NumVisitedSlotsLog2 = 25;
+
+// Value of the first state of a search in the tables of visited states.
+const uint32_t NoRotation = Rotation::NumRotations;
+
+const uint8_t NumSides = 4;
+
+// One side of a bidirectional search: the states visited, with the rotation
+// that reached each one, and the states at the last depth.
+struct SSearch
+{
+	Transposition::STable                m_Visited;
+	std::vector<Permutation::SFacelets>  m_Frontier;
+	bool                                 m_IsBackward;	// Going backwards from the goal: rotations are undone.
+};
+
+// First target using a table. The tables of the layers are the same for
+// the 4 pieces of the layer, and are built for the first one.
+uint8_t GetFirstTarget(uint8_t Table)
+{
+	return (Table < Hint::NumStageTables ? Table * NumSides : Hint::NumStageTables * NumSides + (Table - Hint::NumStageTables));
+}
+
+// Color the stickers of the piece whose home is Home, placed at Pos with the
+// given orientation.
+void PlacePiece(const Permutation::SFacelets& Solved, uint8_t Home, uint8_t Pos, uint8_t Ori, Permutation::SFacelets& State)
+{
+	uint8_t NumStickers = Hint::GetNumStickers(Home);
+	for (uint8_t Sticker = 0; Sticker < NumStickers; ++Sticker)
+		State.m_Facelets[Hint::GetFacelet(Pos, (Sticker + Ori) % NumStickers)] = Solved.m_Facelets[Hint::GetFacelet(Home, Sticker)];
+}
+
+// Pieces that must not move while placing the target piece of a table at
+// Pos: the pieces placed before it and, for the tables of the layers, the
+// other pieces of its layer, since it is the same table for all of them. A
+// piece at Pos must move, though. Positions are seen from the side of the
+// first target. Returns false if Pos holds a piece placed before.
+bool GetKeptPositions(uint8_t Table, uint8_t Pos, std::vector<uint8_t>& Kept)
+{
+	uint8_t Target = GetFirstTarget(Table);
+	uint8_t NumQuarterTurns = NumSides - (Target & (NumSides - 1));
+	uint8_t Stage = Target / NumSides;
+	Kept.clear();
+	for (uint8_t Other = 0; Other < Hint::NumTargets; ++Other)
+	{
+		bool IsBefore = (Other < Target);
+		bool IsSameLayer = (Other / NumSides == Stage && Other != Target && Table < Hint::NumStageTables);
+		if (!IsBefore && !IsSameLayer)
+			continue;
+		uint8_t OtherPos = Hint::RotatePosition(Hint::GetHome(Other), NumQuarterTurns);
+		if (OtherPos == Pos)
+		{
+			if (IsBefore)
+				return false;
+			continue;
+		}
+		Kept.push_back(OtherPos);
+	}
+
+	// A piece cannot be flipped or twisted alone: if no other piece of its
+	// kind may move, the next piece of the layer may. It is placed after the
+	// target, unless the target is the last piece of the layer, which is then
+	// never flipped or twisted alone.
+	uint8_t Home = Hint::GetHome(Target);
+	uint8_t First = (Home < Hint::FirstCorner ? 0 : Hint::FirstCorner);
+	uint8_t End = (Home < Hint::FirstCorner ? Hint::FirstCorner : Hint::NumPositions);
+	size_t NumKeptOfKind = 0;
+	for (uint8_t KeptPos : Kept)
+		NumKeptOfKind += (KeptPos >= First && KeptPos < End);
+	if (Table < Hint::NumStageTables && NumKeptOfKind == size_t(End - First - 1))
+		Kept.erase(std::find(Kept.begin(), Kept.end(), Hint::RotatePosition(Home, 1)));
+	return true;
+}
+
+// Returns true if a case of a table of the bottom corners can happen, that
+// is, if the corners placed after the target can complete it into a state
+// reachable by rotations. Half the cases of the last table cannot, since
+// two corners cannot be swapped alone.
+bool IsReachable(const Permutation::SFacelets& Solved, const std::vector<uint8_t>& Kept, uint8_t Home, uint8_t Pos, uint8_t Ori)
+{
+	std::vector<uint8_t> Homes, Positions;
+	for (uint8_t Corner = Hint::NumPositions - NumSides; Corner < Hint::NumPositions; ++Corner)
+	{
+		if (std::find(Kept.begin(), Kept.end(), Corner) != Kept.end())
+			continue;
+		if (Corner != Home)
+			Homes.push_back(Corner);
+		if (Corner != Pos)
+			Positions.push_back(Corner);
+	}
+
+	unsigned NumOris = 1;
+	for (size_t CornerIdx = 0; CornerIdx < Homes.size(); ++CornerIdx)
+		NumOris *= 3;
+	do
+	{
+		for (unsigned Oris = 0; Oris < NumOris; ++Oris)
+		{
+			Permutation::SFacelets State = Solved;
+			PlacePiece(Solved, Home, Pos, Ori, State);
+			for (size_t CornerIdx = 0, Rest = Oris; CornerIdx < Homes.size(); ++CornerIdx, Rest /= 3)
+				PlacePiece(Solved, Homes[CornerIdx], Positions[CornerIdx], uint8_t(Rest % 3), State);
+			Cubies::SCubies Cubies;
+			if (Cubies::FromFacelets(Layout::Simulator, State.m_Facelets, Cubies) && Cubies::IsValid(Cubies))
+				return true;
+		}
+	}
+	while (std::next_permutation(Positions.begin(), Positions.end()));
+	return false;
+}
+
+// Add a state to one side of the search. Returns false if it was visited.
+bool Visit(SSearch& Search, const Permutation::SFacelets& State, uint32_t Rot)
+{
+	Zobrist::Hash Hash = Zobrist::GetHash(State.m_Facelets);
+	Transposition::Result Result = Transposition::Insert(Search.m_Visited, Hash, Rot);
+	if (Result == Transposition::Full)
+	{
+		fprintf(stderr, "the table of visited states is full\n");
+		exit(1);
+	}
+	if (Result == Transposition::Found)
+		return false;
+	Search.m_Frontier.push_back(State);
+	return true;
+}
+
+// Rotations from the first state of a search to State, in the order they
+// are applied to the first state (reversed for a backward search).
+void GetPath(const SSearch& Search, Permutation::SFacelets State, std::vector<Rotation::Type>& Path)
+{
+	Path.clear();
+	for (;;)
+	{
+		uint32_t Rot = NoRotation;
+		bool IsFound = Transposition::Find(Search.m_Visited, Zobrist::GetHash(State.m_Facelets), Rot);
+		assert(IsFound);
+		(void)IsFound;
+		if (Rot == NoRotation)
+			break;
+		Path.push_back(Rotation::Type(Rot));
+		Permutation::Apply(State, Layout::Simulator, Search.m_IsBackward ? Rotation::Type(Rot) : Rotation::Opposite(Rotation::Type(Rot)));
+	}
+	if (!Search.m_IsBackward)
+		std::reverse(Path.begin(), Path.end());
+}
+
+// Shortest sequence of rotations from Start to Goal, by a bidirectional
+// breadth-first search. Returns false if there is none of at most
+// MaxPlanLength rotations.
+bool FindPlan(SSearch Searches[2], const Permutation::SFacelets& Start, const Permutation::SFacelets& Goal, std::vector<Rotation::Type>& Plan)
+{
+	for (uint8_t Side = 0; Side < 2; ++Side)
+	{
+		Transposition::Clear(Searches[Side].m_Visited);
+		Searches[Side].m_Frontier.clear();
+		Searches[Side].m_IsBackward = (Side == 1);
+	}
+	Visit(Searches[0], Start, NoRotation);
+	Visit(Searches[1], Goal, NoRotation);
+	if (memcmp(&Start, &Goal, sizeof(Start)) == 0)
+	{
+		Plan.clear();
+		return true;
+	}
+
+	// Each depth of the smaller side is expanded in turn. The first states
+	// met at a depth give a shortest plan.
+	for (uint8_t Length = 1; Length <= MaxPlanLength; ++Length)
+	{
+		uint8_t Side = (Searches[0].m_Frontier.size() <= Searches[1].m_Frontier.size() ? 0 : 1);
+		SSearch& Search = Searches[Side];
+		const SSearch& Other = Searches[1 - Side];
+		std::vector<Permutation::SFacelets> Frontier;
+		Frontier.swap(Search.m_Frontier);
+		for (const Permutation::SFacelets& Parent : Frontier)
+			for (Rotation::Type Rot = 0; Rot < Rotation::NumRotations; ++Rot)
+			{
+				Permutation::SFacelets Child = Parent;
+				Permutation::Apply(Child, Layout::Simulator, Search.m_IsBackward ? Rotation::Opposite(Rot) : Rot);
+				if (!Visit(Search, Child, Rot))
+					continue;
+				uint32_t OtherRot;
+				if (!Transposition::Find(Other.m_Visited, Zobrist::GetHash(Child.m_Facelets), OtherRot))
+					continue;
+
+				std::vector<Rotation::Type> Backward;
+				GetPath(Searches[0], Child, Plan);
+				GetPath(Searches[1], Child, Backward);
+				Plan.insert(Plan.end(), Backward.begin(), Backward.end());
+
+				// States are only told apart by their hash: check the plan.
+				Permutation::SFacelets State = Start;
+				Permutation::Apply(State, Layout::Simulator, Plan.data(), Plan.size());
+				if (memcmp(&State, &Goal, sizeof(State)) != 0)
+				{
+					fprintf(stderr, "hash collision, the plan is wrong\n");
+					exit(1);
+				}
+				return true;
+			}
+	}
+	return false;
+}
+
+// Find the plans of all the cases of all the tables, as nibbles.
+bool BuildTables(std::vector<uint8_t>& Nibbles)
+{
+	SSearch Searches[2];
+	for (SSearch& Search : Searches)
+		Transposition::Create(Search.m_Visited, NumVisitedSlotsLog2);
+
+	Permutation::SFacelets Solved;
+	Permutation::Reset(Solved);
+	for (uint8_t Table = 0; Table < Hint::NumTables; ++Table)
+	{
+		uint8_t Home = Hint::GetHome(GetFirstTarget(Table)) & ~(NumSides - 1);
+		uint8_t FirstPos = (Home < Hint::FirstCorner ? 0 : Hint::FirstCorner);
+		uint8_t NumStickers = Hint::GetNumStickers(Home);
+		size_t NumPlans = 0, TotalLength = 0, MaxLength = 0;
+		for (uint8_t Case = 0; Case < Hint::NumCases; ++Case)
+		{
+			uint8_t Pos = FirstPos + Case / NumStickers;
+			uint8_t Ori = Case % NumStickers;
+			std::vector<uint8_t> Kept;
+			if (GetKeptPositions(Table, Pos, Kept) && (Pos != Home || Ori != 0) &&
+			    (Table < Hint::NumStageTables || IsReachable(Solved, Kept, Home, Pos, Ori)))
+			{
+				// Pieces that may move are black, and centers do not move.
+				Permutation::SFacelets Start, Goal;
+				memset(Start.m_Facelets, Facelet::Black, sizeof(Start.m_Facelets));
+				for (uint8_t Face = 0; Face < Cube::NumFaces; ++Face)
+				{
+					uint8_t Center = Permutation::GetRotationIndices(Layout::Simulator, Face).m_Center;
+					Start.m_Facelets[Center] = Solved.m_Facelets[Center];
+				}
+				for (uint8_t KeptPos : Kept)
+					PlacePiece(Solved, KeptPos, KeptPos, 0, Start);
+				Goal = Start;
+				PlacePiece(Solved, Home, Pos, Ori, Start);
+				PlacePiece(Solved, Home, Home, 0, Goal);
+
+				std::vector<Rotation::Type> Plan;
+				if (FindPlan(Searches, Start, Goal, Plan))
+				{
+					Nibbles.insert(Nibbles.end(), Plan.begin(), Plan.end());
+					++NumPlans;
+					TotalLength += Plan.size();
+					if (Plan.size() > MaxLength)
+						MaxLength = Plan.size();
+				}
+				else
+				{
+					fprintf(stderr, "table %u, case %u: no plan of at most %u rotations\n",
+						unsigned(Table), unsigned(Case), unsigned(MaxPlanLength));
+					return false;
+				}
+			}
+			Nibbles.push_back(PlanEnd);
+		}
+		fprintf(stderr, "table %u: %zu plans, %.1f rotations on average, at most %zu\n",
+			unsigned(Table), NumPlans, NumPlans > 0 ? double(TotalLength) / NumPlans : 0.0, MaxLength);
+	}
+	if (Nibbles.size() % 2 != 0)
+		Nibbles.push_back(PlanEnd);
+	return true;
+}
+
+// Write the plans as the header of the tables of the firmware, two rotations
+// per byte, the first one in the low nibble.
+bool WriteHeader(const char* pPath, const std::vector<uint8_t>& Nibbles)
+{
+	FILE* pFile = fopen(pPath, "w");
+	if (pFile == NULL)
+		return false;
+	fprintf(pFile,
+		"#pragma once\n"
+		"\n"
+		"#include <stdint.h>\n"
+		"#include \"config.h\"\n"
+		"\n"
+		"// Plans of the hint engine (see hint.h). Generated by RubikHint.\n"
+		"namespace HintTables\n"
+		"{\n"
+		"const uint8_t End = 0x%02X;\n"
+		"\n"
+		"// Rotations, two per byte (the first one in the low nibble), each plan\n"
+		"// ending with End: the %u cases of each of the %u tables, in order.\n"
+		"// This is stored in flash memory and must be accessed using pgm_read_byte().\n"
+		"const uint8_t f_Rotations[%zu] PROGMEM =\n"
+		"{",
+		unsigned(PlanEnd), unsigned(Hint::NumCases), unsigned(Hint::NumTables), Nibbles.size() / 2);
+	for (size_t ByteIdx = 0; ByteIdx < Nibbles.size() / 2; ++ByteIdx)
+		fprintf(pFile, "%s0x%02X%s", ByteIdx % 12 == 0 ? "\n\t" : " ",
+			unsigned(Nibbles[2 * ByteIdx] | Nibbles[2 * ByteIdx + 1] << 4), ByteIdx + 1 < Nibbles.size() / 2 ? "," : "");
+	fprintf(pFile, "\n};\n}\n");
+	return fclose(pFile) == 0;
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikHint [-c count] [-s seed] [-n rotations] [-o header]\n"
+		"  -c  number of random states solved by following the hints (default: 1000)\n"
+		"  -s  seed of the random generator (default: 1)\n"
+		"  -n  random rotations reaching each state (default: 100)\n"
+		"  -o  build the tables and write them as a firmware header instead\n");
+}
+
+int main(int argc, char** argv)
+{
+	const char* pHeaderPath = NULL;
+	int NumStates = 1000;
+	unsigned long long Seed = 1;
+	int NumRandomRots = 100;
+
+	for (int ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-c") == 0 && ArgIdx + 1 < argc)
+			NumStates = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-s") == 0 && ArgIdx + 1 < argc)
+			Seed = strtoull(argv[++ArgIdx], NULL, 10);
+		else if (strcmp(pArg, "-n") == 0 && ArgIdx + 1 < argc)
+			NumRandomRots = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-o") == 0 && ArgIdx + 1 < argc)
+			pHeaderPath = argv[++ArgIdx];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	if (NumStates < 1 || NumRandomRots < 0)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	if (pHeaderPath != NULL)
+	{
+		std::vector<uint8_t> Nibbles;
+		if (!BuildTables(Nibbles))
+			return 1;
+		fprintf(stderr, "%zu bytes of flash\n", Nibbles.size() / 2);
+		if (!WriteHeader(pHeaderPath, Nibbles))
+		{
+			fprintf(stderr, "%s: write error\n", pHeaderPath);
+			return 1;
+		}
+		return 0;
+	}
+
+	// Follow the hints as the firmware does: request one, then scan the rings
+	// until it is shown, and rotate the face of the hint.
+	const unsigned MaxHintScans = Hint::NumTargets / 4 + 1;
+	const unsigned MaxRotsPerState = 1000;
+	std::mt19937_64 Rng(Seed);
+	unsigned long long TotalRots = 0;
+	unsigned MaxRots = 0, MaxScans = 0, NumFailed = 0;
+	for (int StateIdx = 0; StateIdx < NumStates; ++StateIdx)
+	{
+		Cube::Reset();
+		for (int RotIdx = 0; RotIdx < NumRandomRots; ++RotIdx)
+			Cube::Apply(Rotation::Type(Rng() % Rotation::NumRotations));
+
+		unsigned NumRots = 0;
+		Hint::Request();
+		for (;;)
+		{
+			unsigned NumScans = 0;
+			Rotation::Type Rot;
+			while ((Rot = Hint::Get()) == Rotation::None && NumScans < MaxHintScans)
+			{
+				Hint::Step();
+				++NumScans;
+			}
+			if (NumScans > MaxScans)
+				MaxScans = NumScans;
+			if (Rot == Rotation::None || NumRots == MaxRotsPerState)
+				break;
+			Cube::Apply(Rot);
+			Hint::OnRotation(Rot);
+			++NumRots;
+		}
+
+		if (!Cube::IsSolved())
+			++NumFailed;
+		TotalRots += NumRots;
+		if (NumRots > MaxRots)
+			MaxRots = NumRots;
+	}
+
+	fprintf(stderr, "%d states, %.1f rotations (max %u) to solve, at most %u ring scans before a hint\n",
+		NumStates, double(TotalRots) / NumStates, MaxRots, MaxScans);
+	if (NumFailed > 0)
+	{
+		fprintf(stderr, "%u states not solved\n", NumFailed);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,241 @@
+// Command-line tool finding optimal solutions, in quarter turns, with the
+// parallel IDA* solver (see CubeHost/optimal.h).
+//
+// States are read as by RubikSolve: one per line, the last word of the line
+// being 54 face letters (e.g. the output of RubikReplay), or from a binary
+// corpus with -i. For each state, the number of rotations and the solution
+// are printed, or "invalid" / "unsolved" (beyond -n rotations).
+//
+// The pattern databases are memory-mapped from the files written by
+// RubikPdbGen, and built first if missing. The time of each solve and the
+// nodes generated per second by each thread are printed to the standard error.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../CubeHost/corpus.h"
+#include "../CubeHost/notation.h"
+#include "../CubeHost/optimal.h"
+#include "../CubeHost/workstealing.h"
+
+// Solver and statistics.
+struct SSolver
+{
+	Optimal::STables        m_Tables;
+	unsigned                m_NumThreads;
+	uint8_t                 m_MaxRots;
+
+	unsigned long long      m_NumSolved;
+	unsigned long long      m_NumInvalid;
+	unsigned long long      m_NumUnsolved;
+	double                  m_Seconds;
+	uint64_t                m_NumSplitNodes;
+	std::vector<Optimal::SThreadStats> m_Threads;	// Totals over all states.
+};
+
+// Print the nodes per second of each thread, and the nodes generated to
+// split the searches into tasks.
+void PrintThreadStats(const std::vector<Optimal::SThreadStats>& Threads, uint64_t NumSplitNodes)
+{
+	uint64_t TotalNodes = NumSplitNodes;
+	for (size_t ThreadIdx = 0; ThreadIdx < Threads.size(); ++ThreadIdx)
+	{
+		const Optimal::SThreadStats& Thread = Threads[ThreadIdx];
+		TotalNodes += Thread.m_NumNodes;
+		fprintf(stderr, "  thread %zu: %llu nodes, %.1f M nodes/s\n", ThreadIdx, (unsigned long long)Thread.m_NumNodes,
+			Thread.m_Seconds > 0.0 ? Thread.m_NumNodes / Thread.m_Seconds * 1e-6 : 0.0);
+	}
+	fprintf(stderr, "  split: %llu nodes\n", (unsigned long long)NumSplitNodes);
+	fprintf(stderr, "  total: %llu nodes\n", (unsigned long long)TotalNodes);
+}
+
+// Solve one state and print the result.
+void Solve(SSolver& Solver, Layout::Type L, const Facelet::Type* pFacelets)
+{
+	Cubies::SCubies State;
+	if (!Cubies::FromFacelets(L, pFacelets, State))
+	{
+		printf("invalid\n");
+		++Solver.m_NumInvalid;
+		return;
+	}
+
+	Rotation::Type Rots[Optimal::MaxRotations];
+	uint8_t NumRots;
+	Optimal::SStats Stats;
+	if (Optimal::Solve(Solver.m_Tables, State, Solver.m_NumThreads, Solver.m_MaxRots, Rots, NumRots, &Stats))
+	{
+		char Text[3 * Optimal::MaxRotations + 1];
+		Notation::Format(Rots, NumRots, Text);
+		printf("%u %s\n", unsigned(NumRots), Text);
+		++Solver.m_NumSolved;
+	}
+	else
+	{
+		printf("unsolved\n");
+		++Solver.m_NumUnsolved;
+	}
+	fflush(stdout);
+
+	uint64_t NumNodes = Stats.m_NumSplitNodes;
+	for (size_t ThreadIdx = 0; ThreadIdx < Stats.m_Threads.size(); ++ThreadIdx)
+	{
+		NumNodes += Stats.m_Threads[ThreadIdx].m_NumNodes;
+		Solver.m_Threads[ThreadIdx].m_NumNodes += Stats.m_Threads[ThreadIdx].m_NumNodes;
+		Solver.m_Threads[ThreadIdx].m_Seconds  += Stats.m_Threads[ThreadIdx].m_Seconds;
+	}
+	Solver.m_Seconds += Stats.m_Seconds;
+	Solver.m_NumSplitNodes += Stats.m_NumSplitNodes;
+	fprintf(stderr, "%.3f s, %llu nodes, %.1f M nodes/s, %llu tasks\n", Stats.m_Seconds, (unsigned long long)NumNodes,
+		Stats.m_Seconds > 0.0 ? NumNodes / Stats.m_Seconds * 1e-6 : 0.0, (unsigned long long)Stats.m_NumTasks);
+}
+
+// Solve the states of a text stream, see RubikSolve.
+void SolveFile(SSolver& Solver, Layout::Type L, FILE* pFile)
+{
+	char Line[1024];
+	while (fgets(Line, sizeof(Line), pFile) != NULL)
+	{
+		size_t Len = strlen(Line);
+		while (Len > 0 && isspace(uint8_t(Line[Len - 1])))
+			--Len;
+		size_t Begin = Len;
+		while (Begin > 0 && !isspace(uint8_t(Line[Begin - 1])))
+			--Begin;
+		if (Len - Begin != Cube::NumFacelets)
+			continue;
+
+		Facelet::Type Facelets[Cube::NumFacelets];
+		if (Notation::ParseFacelets(L, Line + Begin, Facelets))
+			Solve(Solver, L, Facelets);
+		else
+		{
+			printf("invalid\n");
+			++Solver.m_NumInvalid;
+		}
+	}
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikOptimal [-l sim|hw] [-d dir] [-j threads] [-n rotations] [-i corpus | file...]\n"
+		"  -l  LED layout of the states (default: sim)\n"
+		"  -d  directory of the pattern database files (default: .)\n"
+		"  -j  number of threads (default: %u)\n"
+		"  -n  longest solution searched, in rotations (default: %u)\n"
+		"  -i  read the states from a corpus file\n"
+		"Reads the standard input if neither a corpus nor a file is given.\n",
+		WorkStealing::GetDefaultNumThreads(), unsigned(Optimal::MaxRotations));
+}
+
+int main(int argc, char** argv)
+{
+	Layout::Type L = Layout::Simulator;
+	const char* pCorpusPath = NULL;
+	const char* pPdbDir = ".";
+	int NumThreads = int(WorkStealing::GetDefaultNumThreads());
+	int MaxRots    = Optimal::MaxRotations;
+
+	int ArgIdx = 1;
+	for (; ArgIdx < argc && argv[ArgIdx][0] == '-' && argv[ArgIdx][1] != 0; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "sim") == 0)
+			L = Layout::Simulator, ++ArgIdx;
+		else if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "hw") == 0)
+			L = Layout::Hardware, ++ArgIdx;
+		else if (strcmp(pArg, "-d") == 0 && ArgIdx + 1 < argc)
+			pPdbDir = argv[++ArgIdx];
+		else if (strcmp(pArg, "-j") == 0 && ArgIdx + 1 < argc)
+			NumThreads = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-n") == 0 && ArgIdx + 1 < argc)
+			MaxRots = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-i") == 0 && ArgIdx + 1 < argc)
+			pCorpusPath = argv[++ArgIdx];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	if (NumThreads < 1 || MaxRots < 0 || MaxRots > Optimal::MaxRotations || (pCorpusPath != NULL && ArgIdx != argc))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	SSolver Solver;
+	Solver.m_NumThreads  = unsigned(NumThreads);
+	Solver.m_MaxRots     = uint8_t(MaxRots);
+	Solver.m_NumSolved   = 0;
+	Solver.m_NumInvalid  = 0;
+	Solver.m_NumUnsolved = 0;
+	Solver.m_Seconds     = 0.0;
+	Solver.m_NumSplitNodes = 0;
+	Solver.m_Threads.assign(NumThreads, Optimal::SThreadStats());
+
+	Pdb::STable Pdbs[Pdb::NumTypes];
+	for (Pdb::Type T = 0; T < Pdb::NumTypes; ++T)
+	{
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		std::string Path = std::string(pPdbDir) + "/" + Pdb::GetName(T) + ".pdb";
+		bool HasBuilt;
+		if (!Pdb::LoadOrBuild(Pdbs[T], T, Path.c_str(), Solver.m_NumThreads, &HasBuilt))
+		{
+			fprintf(stderr, "cannot allocate the pattern databases\n");
+			return 1;
+		}
+		Solver.m_Tables.m_pPdbs[T] = Pdbs[T].m_pDistances;
+		fprintf(stderr, "%s %s in %.3f s (%.1f MB)\n", Path.c_str(), HasBuilt ? "built" : "loaded",
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count(), Pdbs[T].m_Size * 1e-6);
+	}
+
+	if (pCorpusPath != NULL)
+	{
+		Corpus::SReader Reader;
+		if (!Corpus::Open(Reader, pCorpusPath))
+		{
+			fprintf(stderr, "%s: cannot open corpus\n", pCorpusPath);
+			return 1;
+		}
+		for (uint64_t RecordIdx = 0; RecordIdx < Corpus::GetNumRecords(Reader); ++RecordIdx)
+		{
+			Facelet::Type Facelets[Cube::NumFacelets];
+			if (Corpus::GetFacelets(Reader, RecordIdx, Facelets))
+				Solve(Solver, Reader.m_pHeader->m_Layout, Facelets);
+			else
+			{
+				printf("invalid\n");
+				++Solver.m_NumInvalid;
+			}
+		}
+		Corpus::Close(Reader);
+	}
+	else if (ArgIdx == argc)
+		SolveFile(Solver, L, stdin);
+	for (; ArgIdx < argc; ++ArgIdx)
+	{
+		FILE* pFile = fopen(argv[ArgIdx], "r");
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "%s: cannot open file\n", argv[ArgIdx]);
+			return 1;
+		}
+		SolveFile(Solver, L, pFile);
+		fclose(pFile);
+	}
+
+	for (Pdb::Type T = 0; T < Pdb::NumTypes; ++T)
+		Pdb::Free(Pdbs[T]);
+
+	fprintf(stderr, "%llu solved, %llu invalid, %llu unsolved, %.3f s, %d threads\n",
+		Solver.m_NumSolved, Solver.m_NumInvalid, Solver.m_NumUnsolved, Solver.m_Seconds, NumThreads);
+	PrintThreadStats(Solver.m_Threads, Solver.m_NumSplitNodes);
+	return 0;
+}
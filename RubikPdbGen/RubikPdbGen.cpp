@@ -0,0 +1,99 @@
+// Command-line tool building the pattern databases of CubeHost/pdb.h and
+// writing them as files, "<name>.pdb", that the solvers memory-map.
+//
+// For each table, the number of entries at each distance, the build time and
+// the size are printed, then the peak resident memory of the process, to
+// budget the machines that build them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "../CubeHost/pdb.h"
+#include "../CubeHost/workstealing.h"
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikPdbGen [-d dir] [-j threads] [table...]\n"
+		"  -d  output directory (default: .)\n"
+		"  -j  number of threads (default: %u)\n"
+		"Tables: corners, edges-low, edges-high (default: all).\n",
+		WorkStealing::GetDefaultNumThreads());
+}
+
+int main(int argc, char** argv)
+{
+	const char* pDir = ".";
+	int NumThreads = int(WorkStealing::GetDefaultNumThreads());
+
+	int ArgIdx = 1;
+	for (; ArgIdx < argc && argv[ArgIdx][0] == '-' && argv[ArgIdx][1] != 0; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-d") == 0 && ArgIdx + 1 < argc)
+			pDir = argv[++ArgIdx];
+		else if (strcmp(pArg, "-j") == 0 && ArgIdx + 1 < argc)
+			NumThreads = atoi(argv[++ArgIdx]);
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	if (NumThreads < 1)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	bool IsSelected[Pdb::NumTypes];
+	memset(IsSelected, ArgIdx == argc, sizeof(IsSelected));
+	for (; ArgIdx < argc; ++ArgIdx)
+	{
+		Pdb::Type T = 0;
+		while (T < Pdb::NumTypes && strcmp(argv[ArgIdx], Pdb::GetName(T)) != 0)
+			++T;
+		if (T == Pdb::NumTypes)
+		{
+			PrintUsage();
+			return 2;
+		}
+		IsSelected[T] = true;
+	}
+
+	Pdb::Init();
+	std::vector<uint8_t> Table;
+	for (Pdb::Type T = 0; T < Pdb::NumTypes; ++T)
+	{
+		if (!IsSelected[T])
+			continue;
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		Table.resize(Pdb::GetTableSize(T));
+		Pdb::SBuildStats Stats;
+		Pdb::Build(T, Table.data(), unsigned(NumThreads), &Stats);
+		double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		std::string Path = std::string(pDir) + "/" + Pdb::GetName(T) + ".pdb";
+		if (!Pdb::Write(T, Table.data(), Path.c_str()))
+		{
+			fprintf(stderr, "%s: write error\n", Path.c_str());
+			return 1;
+		}
+
+		printf("%s: %llu entries, built in %.3f s with %d threads, %.1f MB\n", Path.c_str(),
+			(unsigned long long)Pdb::GetNumEntries(T), Seconds, NumThreads, (Pdb::FileHeaderSize + Table.size()) * 1e-6);
+		for (uint8_t Distance = 0; Distance < Stats.m_NumDistances; ++Distance)
+			printf("  %2u: %llu\n", unsigned(Distance), (unsigned long long)Stats.m_NumEntries[Distance]);
+		fflush(stdout);
+	}
+
+	struct rusage Usage;
+	getrusage(RUSAGE_SELF, &Usage);
+	printf("peak RSS: %.1f MB\n", Usage.ru_maxrss * 1e-3);	// ru_maxrss is in KB on Linux.
+	return 0;
+}
@@ -0,0 +1,353 @@
+// Command-line tool replaying rotations written in standard notation (see
+// CubeHost/notation.h) from files or from the standard input.
+//
+// By default, each line is an independent sequence applied to a solved cube,
+// e.g. a scramble. With -c, the whole input is a single session. The final
+// state of each sequence is printed as 54 face letters in LED order: each
+// facelet is named after the face whose center has its color. Every time the
+// cube becomes solved, a "solved" event is printed. Statistics are printed
+// to the standard error. With -o, final states are also written to a binary
+// corpus (see CubeHost/corpus.h). With -s, the representative of the
+// symmetry class of each final state (see CubeHost/symmetry.h) is output
+// instead, so that symmetric states can be merged by sorting. With -u, the
+// number of distinct states reached by all the moves is counted, each move
+// updating the Zobrist hash of the cube (see CubeHost/zobrist.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "../Cube/cube.h"
+#include "../CubeHost/corpus.h"
+#include "../CubeHost/notation.h"
+#include "../CubeHost/permutation.h"
+#include "../CubeHost/symmetry.h"
+#include "../CubeHost/transposition.h"
+#include "../CubeHost/zobrist.h"
+
+// Size of the chunks read from the input. Parsing a chunk gives at most
+// 2 rotations per character.
+const size_t TextChunkSize = 1 << 16;
+
+// Slots of the table of the states reached with -u, 512 MB. It holds about
+// 25 M states before getting too full.
+const unsigned NumVisitedSlotsLog2 = 25;
+
+// Cube being replayed, with either engine.
+struct SReplay
+{
+	bool                     m_UseFacelets;	// Use Cube::SState (the facelets of the firmware) instead of Permutation.
+	Layout::Type             m_Layout;
+	bool                     m_Continuous;	// The whole input is a single sequence.
+	bool                     m_PrintStates;
+	bool                     m_Symmetric;	// Output the symmetry representatives of the final states.
+	Corpus::SWriter*         m_pCorpus;	// Corpus receiving the final states, if any.
+	Transposition::STable*   m_pVisited;	// States reached, with the line reaching them first, if counted.
+
+	Permutation::SFacelets   m_Facelets;
+	Cube::SState             m_Cube;
+
+	unsigned long long       m_LineIdx;	// Current line, 1-based.
+	unsigned long long       m_SeqMoves;	// Moves applied to the current sequence.
+	unsigned long long       m_TotalMoves;
+	unsigned long long       m_NumSolved;
+	Zobrist::Hash            m_Hash;	// Hash of the cube, kept only if states are counted.
+	unsigned long long       m_NumDistinct;
+	unsigned long long       m_NumDropped;	// States not counted since m_pVisited is too full.
+
+	SReplay(bool UseFacelets, Layout::Type L, bool Continuous, bool PrintStates, bool Symmetric, Corpus::SWriter* pCorpus,
+	        Transposition::STable* pVisited);
+	void Reset();
+	void Visit();
+	bool ApplyOne(Rotation::Type Rot);
+	void Apply(const Rotation::Type* pRots, size_t NumRots);
+	void EndSequence();
+};
+
+SReplay::SReplay(bool UseFacelets, Layout::Type L, bool Continuous, bool PrintStates, bool Symmetric, Corpus::SWriter* pCorpus,
+                 Transposition::STable* pVisited)
+	: m_UseFacelets(UseFacelets)
+	, m_Layout(L)
+	, m_Continuous(Continuous)
+	, m_PrintStates(PrintStates)
+	, m_Symmetric(Symmetric)
+	, m_pCorpus(pCorpus)
+	, m_pVisited(pVisited)
+	, m_LineIdx(1)
+	, m_SeqMoves(0)
+	, m_TotalMoves(0)
+	, m_NumSolved(0)
+	, m_NumDistinct(0)
+	, m_NumDropped(0)
+{
+	Reset();
+}
+
+void SReplay::Reset()
+{
+	Permutation::Reset(m_Facelets);
+	m_Cube.Reset();
+	m_SeqMoves = 0;
+	if (m_pVisited != NULL)
+	{
+		m_Hash = Zobrist::GetHash(m_UseFacelets ? m_Cube.m_Facelets : m_Facelets.m_Facelets);
+		Visit();
+	}
+}
+
+// Count the current state if it is reached for the first time.
+void SReplay::Visit()
+{
+	uint32_t Value = uint32_t(m_LineIdx < Transposition::PendingValue ? m_LineIdx : Transposition::PendingValue - 1);
+	Transposition::Result Result = Transposition::Insert(*m_pVisited, m_Hash, Value);
+	m_NumDistinct += (Result == Transposition::Added);
+	m_NumDropped  += (Result == Transposition::Full);
+}
+
+// Apply one rotation. Returns true if the cube is solved.
+bool SReplay::ApplyOne(Rotation::Type Rot)
+{
+	const Facelet::Type* pFacelets = (m_UseFacelets ? m_Cube.m_Facelets : m_Facelets.m_Facelets);
+	if (m_pVisited != NULL && Rotation::IsRotation(Rot))
+		m_Hash = Zobrist::Update(m_Hash, m_Layout, pFacelets, Rot);
+
+	bool IsSolved;
+	if (m_UseFacelets)
+	{
+		m_Cube.Apply(Rot);
+		IsSolved = m_Cube.IsSolved();
+		// Zobrist has no tables for the other moves: hash the new state.
+		if (m_pVisited != NULL && !Rotation::IsRotation(Rot))
+			m_Hash = Zobrist::GetHash(m_Cube.m_Facelets);
+	}
+	else
+	{
+		Permutation::Apply(m_Facelets, m_Layout, Rot);
+		IsSolved = Permutation::IsSolved(m_Facelets);
+	}
+
+	if (m_pVisited != NULL)
+		Visit();
+	return IsSolved;
+}
+
+void SReplay::Apply(const Rotation::Type* pRots, size_t NumRots)
+{
+	while (NumRots > 0)
+	{
+		size_t NumApplied = 0;
+		bool IsSolved = false;
+		if (m_UseFacelets || m_pVisited != NULL)
+		{
+			while (NumApplied < NumRots && !IsSolved)
+				IsSolved = ApplyOne(pRots[NumApplied++]);
+		}
+		else
+		{
+			NumApplied = Permutation::ApplyUntilSolved(m_Facelets, m_Layout, pRots, NumRots);
+			IsSolved = Permutation::IsSolved(m_Facelets);
+		}
+
+		m_SeqMoves   += NumApplied;
+		m_TotalMoves += NumApplied;
+		if (IsSolved)
+		{
+			++m_NumSolved;
+			printf("solved %llu %llu\n", m_LineIdx, m_SeqMoves);
+		}
+		pRots   += NumApplied;
+		NumRots -= NumApplied;
+	}
+}
+
+void SReplay::EndSequence()
+{
+	// In line mode, empty lines are skipped.
+	if (!m_Continuous && m_SeqMoves == 0)
+		return;
+
+	const Facelet::Type* pFacelets = (m_UseFacelets ? m_Cube.m_Facelets : m_Facelets.m_Facelets);
+	Facelet::Type RepFacelets[Cube::NumFacelets];
+	if (m_Symmetric)
+	{
+		Cubies::SCubies State, Rep;
+		bool IsValid = Cubies::FromFacelets(m_Layout, pFacelets, State);
+		assert(IsValid);
+		(void)IsValid;
+		Symmetry::GetRepresentative(State, Rep, NULL);
+		Cubies::ToFacelets(m_Layout, Rep, RepFacelets);
+		pFacelets = RepFacelets;
+	}
+	if (m_pCorpus != NULL)
+		Corpus::Write(*m_pCorpus, pFacelets);
+	if (m_PrintStates)
+	{
+		char Letters[Cube::NumFacelets + 1];
+		Notation::FormatFacelets(m_Layout, pFacelets, Letters);
+		printf("state %llu %s\n", m_LineIdx, Letters);
+	}
+	Reset();
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikReplay [-c] [-q] [-s] [-u] [-l sim|hw] [-e perm|facelets] [-o corpus] [file...]\n"
+		"  -c  the whole input is one sequence (default: one sequence per line)\n"
+		"  -q  do not print final states\n"
+		"  -s  output the symmetry representatives of the final states\n"
+		"  -u  count the distinct states reached by the moves\n"
+		"  -l  LED layout of the printed states (default: sim)\n"
+		"  -e  perm: SIMD permutations (default), facelets: Cube::SState::Apply() of\n"
+		"      the firmware, which also applies M, E, S, x, y and z (but not with -s)\n"
+		"  -o  also write the final states to a corpus file\n"
+		"Reads the standard input if no file is given.\n");
+}
+
+// Replay one input stream. Returns false on a parse error.
+bool ReplayFile(SReplay& Replay, FILE* pFile, const char* pName)
+{
+	static char Text[TextChunkSize];
+	static Rotation::Type Rots[2 * TextChunkSize];
+
+	// Only the facelet engine applies the other moves, and they move the centers,
+	// which Cubies::FromFacelets() does not allow.
+	Notation::SParser Parser;
+	Notation::Reset(Parser);
+	Parser.m_AllowMoves = (Replay.m_UseFacelets && !Replay.m_Symmetric);
+	size_t Len;
+	while ((Len = fread(Text, 1, TextChunkSize, pFile)) > 0)
+	{
+		const char* pBegin = Text;
+		const char* pEnd   = Text + Len;
+		while (pBegin != pEnd)
+		{
+			// Parse up to the end of the line, so that events can give
+			// their line number.
+			const char* pLineEnd = static_cast<const char*>(memchr(pBegin, '\n', pEnd - pBegin));
+			bool IsEndOfLine = (pLineEnd != NULL);
+			pLineEnd = (IsEndOfLine ? pLineEnd + 1 : pEnd);
+
+			size_t NumRots = Notation::Parse(Parser, pBegin, pLineEnd - pBegin, Rots);
+			if (NumRots == Notation::ParseError)
+			{
+				fprintf(stderr, "%s:%llu: invalid character '%c'\n", pName, Replay.m_LineIdx, Parser.m_Invalid);
+				return false;
+			}
+			Replay.Apply(Rots, NumRots);
+
+			if (IsEndOfLine)
+			{
+				if (!Replay.m_Continuous)
+					Replay.EndSequence();
+				++Replay.m_LineIdx;
+			}
+			pBegin = pLineEnd;
+		}
+	}
+	Replay.Apply(Rots, Notation::Finish(Parser, Rots));
+
+	// In line mode, a last line without a newline is a sequence too.
+	if (!Replay.m_Continuous && Replay.m_SeqMoves > 0)
+	{
+		Replay.EndSequence();
+		++Replay.m_LineIdx;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool UseFacelets = false;
+	bool Continuous  = false;
+	bool PrintStates = true;
+	bool Symmetric   = false;
+	bool CountStates = false;
+	Layout::Type L   = Layout::Simulator;
+	const char* pCorpusPath = NULL;
+
+	int ArgIdx = 1;
+	for (; ArgIdx < argc && argv[ArgIdx][0] == '-' && argv[ArgIdx][1] != 0; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-c") == 0)
+			Continuous = true;
+		else if (strcmp(pArg, "-q") == 0)
+			PrintStates = false;
+		else if (strcmp(pArg, "-s") == 0)
+			Symmetric = true;
+		else if (strcmp(pArg, "-u") == 0)
+			CountStates = true;
+		else if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "sim") == 0)
+			L = Layout::Simulator, ++ArgIdx;
+		else if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "hw") == 0)
+			L = Layout::Hardware, ++ArgIdx;
+		else if (strcmp(pArg, "-e") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "perm") == 0)
+			UseFacelets = false, ++ArgIdx;
+		else if (strcmp(pArg, "-e") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "facelets") == 0)
+			UseFacelets = true, ++ArgIdx;
+		else if (strcmp(pArg, "-o") == 0 && ArgIdx + 1 < argc)
+			pCorpusPath = argv[++ArgIdx];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	// The firmware code is compiled for a single layout.
+	if (UseFacelets && L != Layout::Native)
+	{
+		fprintf(stderr, "The facelet engine only supports the layout it is compiled for.\n");
+		return 2;
+	}
+
+	Corpus::SWriter Writer;
+	if (pCorpusPath != NULL && !Corpus::Create(Writer, pCorpusPath, L, Corpus::FaceletsEncoding))
+	{
+		fprintf(stderr, "%s: cannot create file\n", pCorpusPath);
+		return 1;
+	}
+
+	Transposition::STable Visited;
+	if (CountStates)
+		Transposition::Create(Visited, NumVisitedSlotsLog2);
+
+	SReplay Replay(UseFacelets, L, Continuous, PrintStates, Symmetric, pCorpusPath != NULL ? &Writer : NULL,
+		CountStates ? &Visited : NULL);
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	bool Ok = true;
+	if (ArgIdx == argc)
+		Ok = ReplayFile(Replay, stdin, "<stdin>");
+	for (; Ok && ArgIdx < argc; ++ArgIdx)
+	{
+		FILE* pFile = fopen(argv[ArgIdx], "rb");
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "%s: cannot open file\n", argv[ArgIdx]);
+			return 1;
+		}
+		Ok = ReplayFile(Replay, pFile, argv[ArgIdx]);
+		fclose(pFile);
+	}
+	if (!Ok)
+		return 1;
+
+	if (Continuous)
+		Replay.EndSequence();
+	if (pCorpusPath != NULL && !Corpus::Close(Writer))
+	{
+		fprintf(stderr, "%s: write error\n", pCorpusPath);
+		return 1;
+	}
+
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	fprintf(stderr, "%llu moves, %llu solved, %.3f s, %.1f M moves/s (%s)\n",
+		Replay.m_TotalMoves, Replay.m_NumSolved, Seconds,
+		Seconds > 0.0 ? Replay.m_TotalMoves / Seconds * 1e-6 : 0.0,
+		UseFacelets ? "facelets" : Permutation::GetKernelName());
+	if (CountStates)
+		fprintf(stderr, "%llu distinct states%s\n", Replay.m_NumDistinct, Replay.m_NumDropped > 0 ? " (table full, some were not counted)" : "");
+	return 0;
+}
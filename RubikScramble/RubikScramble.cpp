@@ -0,0 +1,216 @@
+// Command-line tool generating scrambles that reach uniformly random states
+// (see CubeHost/scramble.h), printed in standard notation, one per line.
+//
+// With -o, the scrambles are also written as the C++ header of the pool of
+// scrambles stored in the flash memory of the firmware (AVRubik/scrambles.h).
+// With -r, scrambles of random rotations are generated instead, as done by
+// the firmware before, for comparison.
+//
+// Statistics are printed to the standard error: the length of the scrambles,
+// the duration of their animation on the cube, and with -q, the distance of
+// the scrambled states to the solved cube, as estimated by the two-phase
+// solver with the same time limit for every state. The closer the states,
+// the worse the scramble.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../CubeHost/notation.h"
+#include "../CubeHost/scramble.h"
+#include "../CubeHost/twophase.h"
+
+const char* const DefaultTablesPath = "twophase.tbl";
+
+// A rotation fits in a nibble; this value ends each scramble of the pool.
+const uint8_t ScrambleEnd = 0x0F;
+
+// Duration of the animation of a scramble on the cube, in ms, with the
+// rotation animation the cube library is compiled with.
+uint32_t GetAnimationMs(const Rotation::Type* pRots, uint8_t NumRots)
+{
+	uint32_t Ms = 0;
+	Cube::Reset();
+	for (uint8_t RotIdx = 0; RotIdx < NumRots; ++RotIdx)
+	{
+		Cube::Animation::Rotate(pRots[RotIdx]);
+		uint16_t DelayMs;
+		while ((DelayMs = Cube::Animation::Next()) != 0)
+			Ms += DelayMs;
+	}
+	return Ms;
+}
+
+// Write the scrambles as the header of the pool of the firmware. Rotations
+// are packed two per byte, the first one in the low nibble, and each
+// scramble ends with ScrambleEnd.
+bool WriteHeader(const char* pPath, const std::vector<Scramble::SScramble>& Scrambles, const char* pOptions)
+{
+	std::vector<uint8_t> Nibbles;
+	for (const Scramble::SScramble& Scramble : Scrambles)
+	{
+		Nibbles.insert(Nibbles.end(), Scramble.m_Rots, Scramble.m_Rots + Scramble.m_NumRots);
+		Nibbles.push_back(ScrambleEnd);
+	}
+	if (Nibbles.size() % 2 != 0)
+		Nibbles.push_back(ScrambleEnd);
+
+	FILE* pFile = fopen(pPath, "w");
+	if (pFile == NULL)
+		return false;
+	fprintf(pFile,
+		"#pragma once\n"
+		"\n"
+		"#include <stdint.h>\n"
+		"#include \"../Cube/config.h\"\n"
+		"\n"
+		"// Pool of scrambles reaching uniformly random states, picked at random by\n"
+		"// Scramble(). Generated by RubikScramble %s.\n"
+		"namespace Scrambles\n"
+		"{\n"
+		"const uint8_t NumScrambles = %zu;\n"
+		"const uint8_t End = 0x%02X;\n"
+		"\n"
+		"// Rotations, two per byte (the first one in the low nibble), each scramble\n"
+		"// ending with End. This is stored in flash memory and must be accessed\n"
+		"// using pgm_read_byte().\n"
+		"const uint8_t f_Rotations[%zu] PROGMEM =\n"
+		"{",
+		pOptions, Scrambles.size(), unsigned(ScrambleEnd), Nibbles.size() / 2);
+	for (size_t ByteIdx = 0; ByteIdx < Nibbles.size() / 2; ++ByteIdx)
+		fprintf(pFile, "%s0x%02X%s", ByteIdx % 12 == 0 ? "\n\t" : " ",
+			unsigned(Nibbles[2 * ByteIdx] | Nibbles[2 * ByteIdx + 1] << 4), ByteIdx + 1 < Nibbles.size() / 2 ? "," : "");
+	fprintf(pFile, "\n};\n}\n");
+	return fclose(pFile) == 0;
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikScramble [-t tables] [-c count] [-s seed] [-n moves] [-T ms] [-r rotations] [-q ms] [-o header]\n"
+		"  -t  cache file of the two-phase tables, built if missing (default: %s)\n"
+		"  -c  number of scrambles (default: 32)\n"
+		"  -s  seed of the random generator (default: 1)\n"
+		"  -n  stop at the first scramble of at most this many face turns (default: 20)\n"
+		"  -T  time limit per scramble in ms, 0 for none (default: 1000)\n"
+		"  -r  random rotations instead of random states (not with -o)\n"
+		"  -q  estimate the distance of the scrambled states, searching this many ms each\n"
+		"  -o  also write the scrambles as a firmware header\n",
+		DefaultTablesPath);
+}
+
+int main(int argc, char** argv)
+{
+	const char* pTablesPath = DefaultTablesPath;
+	const char* pHeaderPath = NULL;
+	int NumScrambles = 32;
+	unsigned long long Seed = 1;
+	int MaxMoves  = 20;
+	int TimeoutMs = 1000;
+	int NumRandomRots = 0;
+	int QualityMs = 0;
+
+	for (int ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-t") == 0 && ArgIdx + 1 < argc)
+			pTablesPath = argv[++ArgIdx];
+		else if (strcmp(pArg, "-c") == 0 && ArgIdx + 1 < argc)
+			NumScrambles = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-s") == 0 && ArgIdx + 1 < argc)
+			Seed = strtoull(argv[++ArgIdx], NULL, 10);
+		else if (strcmp(pArg, "-n") == 0 && ArgIdx + 1 < argc)
+			MaxMoves = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-T") == 0 && ArgIdx + 1 < argc)
+			TimeoutMs = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-r") == 0 && ArgIdx + 1 < argc)
+			NumRandomRots = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-q") == 0 && ArgIdx + 1 < argc)
+			QualityMs = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-o") == 0 && ArgIdx + 1 < argc)
+			pHeaderPath = argv[++ArgIdx];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	// The firmware picks a scramble with Rand8::Get(), up to 254.
+	if (NumScrambles < 1 || (pHeaderPath != NULL && NumScrambles > 255) || MaxMoves < 0 || MaxMoves > TwoPhase::MaxSolutionMoves || TimeoutMs < 0 ||
+	    NumRandomRots < 0 || NumRandomRots > TwoPhase::MaxSolutionRotations || QualityMs < 0 ||
+	    (NumRandomRots > 0 && pHeaderPath != NULL))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	TwoPhase::STables Tables;
+	bool NeedsTables = (NumRandomRots == 0 || QualityMs > 0);
+	if (NeedsTables && !TwoPhase::LoadTables(Tables, pTablesPath, NULL))
+	{
+		fprintf(stderr, "cannot allocate the tables\n");
+		return 1;
+	}
+
+	std::mt19937_64 Rng(Seed);
+	std::vector<Scramble::SScramble> Scrambles(NumScrambles);
+	unsigned long long TotalRots = 0, TotalMoves = 0, TotalMs = 0;
+	unsigned MaxRots = 0;
+	unsigned DistanceCounts[TwoPhase::MaxSolutionMoves + 1] = {};
+	for (Scramble::SScramble& Scramble : Scrambles)
+	{
+		if (NumRandomRots > 0)
+			Scramble::GenerateRandomMoves(Rng, uint8_t(NumRandomRots), Scramble);
+		else
+			Scramble::Generate(Tables, Rng, uint8_t(MaxMoves), uint32_t(TimeoutMs), Scramble);
+
+		char Text[3 * TwoPhase::MaxSolutionRotations + 1];
+		Notation::Format(Scramble.m_Rots, Scramble.m_NumRots, Text);
+		printf("%s\n", Text);
+
+		TotalRots  += Scramble.m_NumRots;
+		TotalMoves += Scramble.m_NumMoves;
+		TotalMs    += GetAnimationMs(Scramble.m_Rots, Scramble.m_NumRots);
+		if (Scramble.m_NumRots > MaxRots)
+			MaxRots = Scramble.m_NumRots;
+
+		// No solution has 0 moves: the search runs for the whole time limit.
+		TwoPhase::SSolution Solution;
+		if (QualityMs > 0 && TwoPhase::Solve(Tables, Scramble.m_State, 0, uint32_t(QualityMs), Solution))
+			++DistanceCounts[Solution.m_NumMoves];
+	}
+
+	fprintf(stderr, "%d scrambles, %.1f rotations (max %u), %.1f s of animation on average\n",
+		NumScrambles, double(TotalRots) / NumScrambles, MaxRots, TotalMs * 1e-3 / NumScrambles);
+	if (NumRandomRots == 0)
+		fprintf(stderr, "%.1f face turns on average\n", double(TotalMoves) / NumScrambles);
+	if (QualityMs > 0)
+	{
+		unsigned long long TotalDistance = 0;
+		fprintf(stderr, "estimated distance of the states (face turns):\n");
+		for (uint8_t Distance = 0; Distance <= TwoPhase::MaxSolutionMoves; ++Distance)
+		{
+			if (DistanceCounts[Distance] == 0)
+				continue;
+			TotalDistance += uint64_t(Distance) * DistanceCounts[Distance];
+			fprintf(stderr, "  %2u: %5.1f%%\n", unsigned(Distance), DistanceCounts[Distance] * 100.0 / NumScrambles);
+		}
+		fprintf(stderr, "  average: %.2f\n", double(TotalDistance) / NumScrambles);
+	}
+
+	if (pHeaderPath != NULL)
+	{
+		char Options[64];
+		snprintf(Options, sizeof(Options), "-c %d -s %llu -n %d -T %d", NumScrambles, Seed, MaxMoves, TimeoutMs);
+		if (!WriteHeader(pHeaderPath, Scrambles, Options))
+		{
+			fprintf(stderr, "%s: write error\n", pHeaderPath);
+			return 1;
+		}
+	}
+	if (NeedsTables)
+		TwoPhase::FreeTables(Tables);
+	return 0;
+}
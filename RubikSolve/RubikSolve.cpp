@@ -0,0 +1,207 @@
+// Command-line tool solving cube states with the two-phase solver (see
+// CubeHost/twophase.h).
+//
+// States are read from files or from the standard input, one per line, as 54
+// face letters in LED order: the last word of each line is used, so the
+// output of RubikReplay can be given as is. Lines whose last word is not 54
+// characters long (e.g. "solved" events) are ignored. With -i, states are
+// read from a binary corpus instead (see CubeHost/corpus.h).
+//
+// For each state, the solver stops at the first solution of at most 20 face
+// turns, or returns the shortest one found in 50 ms. The number of face turns
+// and the solution are printed, or "invalid". The table loading time and the latency of the
+// solves are printed to the standard error.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "../Cube/cube.h"
+#include "../CubeHost/corpus.h"
+#include "../CubeHost/notation.h"
+#include "../CubeHost/twophase.h"
+
+const char* const DefaultTablesPath = "twophase.tbl";
+
+// Solver and statistics.
+struct SSolver
+{
+	const TwoPhase::STables* m_pTables;
+	uint8_t                  m_MaxMoves;
+	uint32_t                 m_TimeoutMs;
+
+	std::vector<double>      m_Latencies;	// In ms, one per solved state.
+	unsigned long long       m_TotalMoves;
+	unsigned long long       m_NumInvalid;
+};
+
+// Solve one state and print the result.
+void Solve(SSolver& Solver, Layout::Type L, const Facelet::Type* pFacelets)
+{
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	TwoPhase::SSolution Solution;
+	bool Ok = TwoPhase::Solve(*Solver.m_pTables, L, pFacelets, Solver.m_MaxMoves, Solver.m_TimeoutMs, Solution);
+	double Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+	if (!Ok)
+	{
+		printf("invalid\n");
+		++Solver.m_NumInvalid;
+		return;
+	}
+
+	char Text[3 * TwoPhase::MaxSolutionRotations + 1];
+	Notation::Format(Solution.m_Rots, Solution.m_NumRots, Text);
+	printf("%u %s\n", unsigned(Solution.m_NumMoves), Text);
+	Solver.m_Latencies.push_back(Ms);
+	Solver.m_TotalMoves += Solution.m_NumMoves;
+}
+
+// Solve the states of a text stream.
+void SolveFile(SSolver& Solver, Layout::Type L, FILE* pFile)
+{
+	char Line[1024];
+	while (fgets(Line, sizeof(Line), pFile) != NULL)
+	{
+		size_t Len = strlen(Line);
+		while (Len > 0 && isspace(uint8_t(Line[Len - 1])))
+			--Len;
+		if (Len == 0)
+			continue;
+
+		size_t Begin = Len;
+		while (Begin > 0 && !isspace(uint8_t(Line[Begin - 1])))
+			--Begin;
+		if (Len - Begin != Cube::NumFacelets)
+			continue;
+
+		Facelet::Type Facelets[Cube::NumFacelets];
+		if (Notation::ParseFacelets(L, Line + Begin, Facelets))
+			Solve(Solver, L, Facelets);
+		else
+		{
+			printf("invalid\n");
+			++Solver.m_NumInvalid;
+		}
+	}
+}
+
+void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: RubikSolve [-l sim|hw] [-t tables] [-n moves] [-T ms] [-i corpus | file...]\n"
+		"  -l  LED layout of the states (default: sim)\n"
+		"  -t  cache file of the tables, built if missing (default: %s)\n"
+		"  -n  stop at the first solution of at most this many face turns (default: 20)\n"
+		"  -T  time limit per state in ms, 0 for none (default: 50)\n"
+		"  -i  read the states from a corpus file\n"
+		"Reads the standard input if neither a corpus nor a file is given.\n",
+		DefaultTablesPath);
+}
+
+int main(int argc, char** argv)
+{
+	Layout::Type L = Layout::Simulator;
+	const char* pTablesPath = DefaultTablesPath;
+	const char* pCorpusPath = NULL;
+	int MaxMoves  = 20;
+	int TimeoutMs = 50;
+
+	int ArgIdx = 1;
+	for (; ArgIdx < argc && argv[ArgIdx][0] == '-' && argv[ArgIdx][1] != 0; ++ArgIdx)
+	{
+		const char* pArg = argv[ArgIdx];
+		if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "sim") == 0)
+			L = Layout::Simulator, ++ArgIdx;
+		else if (strcmp(pArg, "-l") == 0 && ArgIdx + 1 < argc && strcmp(argv[ArgIdx + 1], "hw") == 0)
+			L = Layout::Hardware, ++ArgIdx;
+		else if (strcmp(pArg, "-t") == 0 && ArgIdx + 1 < argc)
+			pTablesPath = argv[++ArgIdx];
+		else if (strcmp(pArg, "-n") == 0 && ArgIdx + 1 < argc)
+			MaxMoves = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-T") == 0 && ArgIdx + 1 < argc)
+			TimeoutMs = atoi(argv[++ArgIdx]);
+		else if (strcmp(pArg, "-i") == 0 && ArgIdx + 1 < argc)
+			pCorpusPath = argv[++ArgIdx];
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+	if (MaxMoves < 0 || MaxMoves > TwoPhase::MaxSolutionMoves || TimeoutMs < 0 || (pCorpusPath != NULL && ArgIdx != argc))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	TwoPhase::STables Tables;
+	bool HasBuilt;
+	if (!TwoPhase::LoadTables(Tables, pTablesPath, &HasBuilt))
+	{
+		fprintf(stderr, "cannot allocate the tables\n");
+		return 1;
+	}
+	fprintf(stderr, "tables %s in %.3f s (%.1f MB)\n", HasBuilt ? "built" : "loaded",
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count(), Tables.m_Size * 1e-6);
+
+	SSolver Solver;
+	Solver.m_pTables     = &Tables;
+	Solver.m_MaxMoves    = uint8_t(MaxMoves);
+	Solver.m_TimeoutMs   = uint32_t(TimeoutMs);
+	Solver.m_TotalMoves  = 0;
+	Solver.m_NumInvalid  = 0;
+
+	if (pCorpusPath != NULL)
+	{
+		Corpus::SReader Reader;
+		if (!Corpus::Open(Reader, pCorpusPath))
+		{
+			fprintf(stderr, "%s: cannot open corpus\n", pCorpusPath);
+			return 1;
+		}
+		for (uint64_t RecordIdx = 0; RecordIdx < Corpus::GetNumRecords(Reader); ++RecordIdx)
+		{
+			Facelet::Type Facelets[Cube::NumFacelets];
+			if (Corpus::GetFacelets(Reader, RecordIdx, Facelets))
+				Solve(Solver, Reader.m_pHeader->m_Layout, Facelets);
+			else
+			{
+				printf("invalid\n");
+				++Solver.m_NumInvalid;
+			}
+		}
+		Corpus::Close(Reader);
+	}
+	else if (ArgIdx == argc)
+		SolveFile(Solver, L, stdin);
+	for (; ArgIdx < argc; ++ArgIdx)
+	{
+		FILE* pFile = fopen(argv[ArgIdx], "r");
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "%s: cannot open file\n", argv[ArgIdx]);
+			return 1;
+		}
+		SolveFile(Solver, L, pFile);
+		fclose(pFile);
+	}
+	TwoPhase::FreeTables(Tables);
+
+	std::vector<double>& Latencies = Solver.m_Latencies;
+	size_t NumSolved = Latencies.size();
+	fprintf(stderr, "%zu solved, %llu invalid", NumSolved, Solver.m_NumInvalid);
+	if (NumSolved > 0)
+	{
+		std::sort(Latencies.begin(), Latencies.end());
+		fprintf(stderr, ", %.2f moves avg, ms/solve: p50 %.3f, p90 %.3f, p99 %.3f, max %.3f",
+			double(Solver.m_TotalMoves) / NumSolved,
+			Latencies[NumSolved / 2], Latencies[NumSolved * 9 / 10], Latencies[NumSolved * 99 / 100], Latencies.back());
+	}
+	fprintf(stderr, "\n");
+	return 0;
+}
@@ -1,6 +1,7 @@
 #define GLFW_INCLUDE_GLU
 #include <GLFW/glfw3.h>
 #include "../Cube/cube.h"
+#include "../Cube/controls.h"
 
 struct SGLState
 {
@@ -29,6 +30,8 @@ SGLState::SGLState()
 	m_Roll  =   0.0f;
 }
 
+// Start the animation of a move, or queue it if an animation is running, as
+// the firmware does for the actions detected during animations.
 void SGLState::StartOp(uint8_t NewOp)
 {
 	if (m_CurOp == NO_OP)
@@ -37,6 +40,10 @@ void SGLState::StartOp(uint8_t NewOp)
 		m_CurOp  = NewOp;
 		Cube::Animation::Rotate(NewOp);
 	}
+	else
+	{
+		Controls::PushPendingAction(NewOp);
+	}
 }
 
 // Resize And Initialize The GL Window
@@ -103,8 +110,7 @@ void DrawFace(GLfloat px, GLfloat py, GLfloat pz, // first corner
 		{
 			// Get Color.
 			uint8_t FaceletIndex = FaceletIndices[i * 3 + j];
-			Facelet::Type FaceletState = Facelets[FaceletIndex];
-			SColor Color = Colors[FaceletState];
+			SColor Color = GetColor(Facelets[FaceletIndex], Cube::IsBright(FaceletIndex));
 			glColor3ub(Color.r, Color.g, Color.b);
 
 			// Offset is used to skip the black outline only once.
@@ -228,11 +234,15 @@ static void HandleOperations(GLFWwindow* Window)
 			uint16_t NextDelayMs = Cube::Animation::Next();
 			if (NextDelayMs != 0)
 			{
+				NextDelayMs >>= Controls::GetAnimationSpeedUp();
 				pGLState->m_OpTime = CurTime + (NextDelayMs + LED_UPDATE_DELAY_MS) / 1000.0;
 			}
 			else
 			{
 				pGLState->m_CurOp = SGLState::NO_OP;
+				uint8_t NextOp = Controls::PopPendingAction();
+				if (NextOp != Action::None)
+					pGLState->StartOp(NextOp);
 			}
 		}
 	}
@@ -254,6 +264,12 @@ static void KeyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, i
 		case GLFW_KEY_4: pGLState->StartOp(Orientation + Rotation::Back  ); break;
 		case GLFW_KEY_5: pGLState->StartOp(Orientation + Rotation::Left  ); break;
 		case GLFW_KEY_6: pGLState->StartOp(Orientation + Rotation::Bottom); break;
+		case GLFW_KEY_7: pGLState->StartOp(Orientation + Rotation::Middle  ); break;
+		case GLFW_KEY_8: pGLState->StartOp(Orientation + Rotation::Equator ); break;
+		case GLFW_KEY_9: pGLState->StartOp(Orientation + Rotation::Standing); break;
+		case GLFW_KEY_X: pGLState->StartOp(Orientation + Rotation::CubeX   ); break;
+		case GLFW_KEY_Y: pGLState->StartOp(Orientation + Rotation::CubeY   ); break;
+		case GLFW_KEY_Z: pGLState->StartOp(Orientation + Rotation::CubeZ   ); break;
 		}
 	}
 }